@@ -13,6 +13,8 @@
 #include "klee/Constraints.h"
 #include "klee/Expr.h"
 #include "klee/Internal/ADT/TreeStream.h"
+#include "klee/util/AbstractDomain.h"
+#include "klee/util/Assignment.h"
 
 // FIXME: We do not want to be exposing these? :(
 #include "../../lib/Core/AddressSpace.h"
@@ -97,6 +99,26 @@ public:
   /// @brief Constraints collected so far
   ConstraintManager constraints;
 
+  /// @brief An assignment to the symbolic arrays which satisfies
+  /// constraints; used to decide one side of a branch without asking
+  /// the solver. Only meaningful when concolicModelValid is set.
+  Assignment concolicModel;
+
+  /// @brief Whether concolicModel is known to satisfy constraints
+  bool concolicModelValid;
+
+  /// @brief Intervals and known bits of the symbolic bytes, derived
+  /// from constraints. Only maintained when useAbstractDomain is set.
+  AbstractDomain abstractDomain;
+
+  /// @brief Whether abstractDomain is kept up to date
+  bool useAbstractDomain;
+
+  /// @brief Whether constraints were added without asking the solver if
+  /// they can hold together, as done by --fast-replay-path; they are
+  /// checked before the next query which needs a solution
+  bool uncheckedConstraints;
+
   /// Statistics and information
 
   /// @brief Costs for all queries issued for this state, in seconds
@@ -133,6 +155,14 @@ public:
   /// @brief Pointer to the process tree of the current state
   PTreeNode *ptreeNode;
 
+  /// @brief Position of the state among the states in the executor's
+  /// StateRegistry; ~0U when not registered.
+  unsigned registryIndex;
+
+  /// @brief Slot of the state's seeds in the executor's SeedMap; ~0U when
+  /// the state has no seeds.
+  unsigned seedSlot;
+
   /// @brief Ordered list of symbolics: used to generate test cases.
   //
   // FIXME: Move to a shared list structure (not critical).
@@ -146,7 +176,10 @@ public:
   void removeFnAlias(std::string fn);
 
 private:
-  ExecutionState() : ptreeNode(0) {}
+  ExecutionState()
+      : concolicModelValid(false), useAbstractDomain(false),
+        uncheckedConstraints(false), ptreeNode(0),
+        registryIndex(~0U), seedSlot(~0U) {}
 
 public:
   ExecutionState(KFunction *kf);
@@ -165,7 +198,7 @@ public:
   void popFrame();
 
   void addSymbolic(const MemoryObject *mo, const Array *array);
-  void addConstraint(ref<Expr> e) { constraints.addConstraint(e); }
+  void addConstraint(ref<Expr> e);
 
   bool merge(const ExecutionState &b);
   void dumpStack(llvm::raw_ostream &out) const;
@@ -462,9 +462,21 @@ public:
   /// the array size.
   const std::vector<ref<ConstantExpr> > constantValues;
 
+  /// Piece - A run [start, end) of a constant array whose values are
+  /// base + step * (i - start), modulo the range of the array.
+  struct Piece {
+    unsigned start, end;
+    uint64_t base, step;
+  };
+
 private:
   unsigned hashValue;
 
+  /// pieces - The split of a constant array made by getPieces, and the
+  /// maximum number of pieces it was made for (0 if not made yet).
+  mutable std::vector<Piece> pieces;
+  mutable unsigned piecesLimit;
+
   // FIXME: Make =delete when we switch to C++11
   Array(const Array& array);
 
@@ -494,6 +506,11 @@ public:
   Expr::Width getDomain() const { return domain; }
   Expr::Width getRange() const { return range; }
 
+  /// getPieces - Return the split of a constant array into the fewest runs
+  /// of values in arithmetic progression, or null if that takes more than
+  /// \a maxPieces runs. The split is made once and kept with the array.
+  const std::vector<Piece> *getPieces(unsigned maxPieces) const;
+
   /// ComputeHash must take into account the name, the size, the domain, and the range
   unsigned computeHash();
   unsigned hash() const { return hashValue; }
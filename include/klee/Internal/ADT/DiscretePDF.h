@@ -7,7 +7,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <ciso646>
+#ifdef _LIBCPP_VERSION
+#include <unordered_map>
+#define unordered_map std::unordered_map
+#else
+#include <tr1/unordered_map>
+#define unordered_map std::tr1::unordered_map
+#endif
+#include <vector>
+
 namespace klee {
+  /// DiscretePDF - A set of weighted items from which an item can be drawn
+  /// with probability proportional to its weight.
+  ///
+  /// Items live in the slots of an implicit binary tree stored in an array:
+  /// the leaves hold the weights and every inner node holds the sum of its
+  /// children, so drawing and changing a weight both walk one root-to-leaf
+  /// path. The slots of removed items are reused.
   template <class T>
   class DiscretePDF {
     // not perfectly parameterized, but float/double/int should work ok,
@@ -32,16 +49,25 @@ namespace klee {
     T choose(double p);
     
   private:
-    class Node;
-    Node *m_root;
-    
-    Node **lookup(T item, Node **parent_out);
-    void split(Node *node);
-    void rotate(Node *node);
-    void lengthen(Node *node);
-    void propogateSumsUp(Node *n);
+    /// The number of leaves, always zero or a power of two.
+    unsigned capacity;
+    /// The number of slots handed out so far.
+    unsigned numSlots;
+    /// The tree of sums: node i has children 2i and 2i+1, and the leaf of
+    /// slot s is at capacity + s.
+    std::vector<weight_type> sums;
+    std::vector<T> items;
+    std::vector<unsigned> freeSlots;
+    /// The slot of each item, hashed since every update looks it up.
+    unordered_map<T, unsigned> slots;
+
+    unsigned getSlot(T item);
+    void setWeight(unsigned slot, weight_type weight);
+    void grow();
   };
 
 }
 
 #include "DiscretePDF.inc"
+
+#undef unordered_map
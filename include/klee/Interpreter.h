@@ -39,6 +39,7 @@ public:
   virtual llvm::raw_fd_ostream *openOutputFile(const std::string &filename) = 0;
 
   virtual void incPathsExplored() = 0;
+  virtual unsigned getNumTestCases() const = 0;
 
   virtual void processTestCase(const ExecutionState &state,
                                const char *err, 
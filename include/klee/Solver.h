@@ -295,6 +295,13 @@ namespace klee {
   ///
   /// \param s - The underlying solver to use.
   Solver *createIndependentSolver(Solver *s);
+
+  /// createBitWidthReductionSolver - Create a solver which narrows the
+  /// comparisons in a query to the bits their operands can actually use
+  /// before propagating it to the underlying solver.
+  ///
+  /// \param s - The underlying solver to use.
+  Solver *createBitWidthReductionSolver(Solver *s);
   
   /// createPCLoggingSolver - Create a solver which will forward all queries
   /// after writing them to the given path in .pc format.
@@ -19,6 +19,7 @@ namespace stats {
   extern Statistic queries;
   extern Statistic queriesInvalid;
   extern Statistic queriesValid;
+  extern Statistic queryBitWidthReductions;
   extern Statistic queryCacheHits;
   extern Statistic queryCacheMisses;
   extern Statistic queryCexCacheHits;
@@ -26,6 +27,8 @@ namespace stats {
   extern Statistic queryConstructTime;
   extern Statistic queryConstructs;
   extern Statistic queryCounterexamples;
+  extern Statistic queryReadsAsArrays;
+  extern Statistic queryReadsLoweredToITE;
   extern Statistic queryTime;
   
 #ifdef DEBUG
@@ -0,0 +1,124 @@
+//===-- AbstractDomain.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_UTIL_ABSTRACTDOMAIN_H
+#define KLEE_UTIL_ABSTRACTDOMAIN_H
+
+#include "klee/Expr.h"
+#include "klee/Internal/ADT/ImmutableMap.h"
+
+#include <stdint.h>
+#include <utility>
+
+namespace klee {
+  class Array;
+
+  /// AbstractValue - An over-approximation of the values an expression of at
+  /// most 64 bits may take: an unsigned interval together with the bits
+  /// known to be zero and known to be one.
+  ///
+  /// A value with min > max is empty, i.e. no value is possible.
+  class AbstractValue {
+  public:
+    Expr::Width width;
+    uint64_t min, max;
+    uint64_t knownZero, knownOne;
+
+  public:
+    AbstractValue()
+      : width(Expr::Bool), min(0), max(1), knownZero(0), knownOne(0) {}
+    AbstractValue(Expr::Width _width, uint64_t _min, uint64_t _max,
+                  uint64_t _knownZero = 0, uint64_t _knownOne = 0)
+      : width(_width), min(_min), max(_max),
+        knownZero(_knownZero), knownOne(_knownOne) {
+      normalize();
+    }
+
+    static AbstractValue top(Expr::Width w) {
+      return AbstractValue(w, 0, mask(w));
+    }
+    static AbstractValue constant(uint64_t value, Expr::Width w) {
+      return AbstractValue(w, value & mask(w), value & mask(w));
+    }
+    static AbstractValue fromKnownBits(Expr::Width w, uint64_t knownZero,
+                                       uint64_t knownOne) {
+      return AbstractValue(w, 0, mask(w), knownZero, knownOne);
+    }
+
+    static uint64_t mask(Expr::Width w) {
+      return w >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << w) - 1;
+    }
+
+    bool isEmpty() const { return min > max; }
+    bool isConstant() const { return min == max; }
+    bool isTop() const {
+      return !min && max == mask(width) && !knownZero && !knownOne;
+    }
+    bool mustBeTrue() const {
+      return width == Expr::Bool && min == 1 && max == 1;
+    }
+    bool mustBeFalse() const {
+      return width == Expr::Bool && min == 0 && max == 0;
+    }
+
+    /// meet - The values possible in both this and \a b.
+    AbstractValue meet(const AbstractValue &b) const;
+    /// join - The values possible in either this or \a b.
+    AbstractValue join(const AbstractValue &b) const;
+
+    bool operator==(const AbstractValue &b) const {
+      return width == b.width && min == b.min && max == b.max &&
+             knownZero == b.knownZero && knownOne == b.knownOne;
+    }
+    bool operator!=(const AbstractValue &b) const { return !(*this == b); }
+
+  private:
+    /// Tighten the interval and the known bits against each other.
+    void normalize();
+  };
+
+  /// AbstractDomain - An abstraction of the path constraints of a state, as
+  /// an AbstractValue for each symbolic byte the constraints restrict.
+  ///
+  /// The domain is refined incrementally as constraints are added, and is
+  /// cheap to copy. It is always sound with respect to the constraints it
+  /// has seen, but it does not keep any relations between bytes, so most
+  /// conditions cannot be decided by it.
+  class AbstractDomain {
+  public:
+    typedef std::pair<const Array*, unsigned> byte_ty;
+    typedef ImmutableMap<byte_ty, AbstractValue> bytes_ty;
+
+  private:
+    bytes_ty bytes;
+
+    class Evaluator;
+    class Refiner;
+
+  public:
+    AbstractDomain() {}
+
+    /// evaluate - Return the values \a e may take under the domain. Wider
+    /// expressions than 64 bits are not supported and are never decided.
+    AbstractValue evaluate(const ref<Expr> &e) const;
+
+    /// getByte - Return the values the given symbolic byte may take.
+    AbstractValue getByte(const Array *array, unsigned index) const;
+
+    /// addConstraint - Refine the domain with the knowledge that \a e holds.
+    void addConstraint(const ref<Expr> &e);
+
+    /// join - Return a domain covering the states of both this and \a b.
+    AbstractDomain join(const AbstractDomain &b) const;
+
+    unsigned getNumBytes() const { return bytes.size(); }
+  };
+}
+
+#endif
@@ -0,0 +1,108 @@
+//===-- ConstraintProgram.h -------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_UTIL_CONSTRAINTPROGRAM_H
+#define KLEE_UTIL_CONSTRAINTPROGRAM_H
+
+#include "klee/Expr.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace klee {
+  class Array;
+  class Assignment;
+
+  /// ConstraintProgram - A set of constraints compiled into a straight-line
+  /// register program, for checking many assignments against the same
+  /// constraints.
+  ///
+  /// Each distinct subexpression is computed exactly once into its own
+  /// register, and a batch of assignments is evaluated in lock step, one
+  /// instruction at a time across all lanes of the batch. Only expressions of
+  /// at most 64 bits are supported; if a constraint cannot be compiled, the
+  /// program is not valid and every query falls back to Assignment.
+  ///
+  /// The result of a check is always the same as that of
+  /// Assignment::satisfies: lanes which divide by zero, or read a value the
+  /// assignment leaves free, are rechecked with the tree evaluator.
+  class ConstraintProgram {
+  public:
+    /// The number of assignments evaluated together by satisfies().
+    enum { BatchSize = 8 };
+
+  private:
+    enum Opcode {
+      Const, Read,
+      Select, Concat, Extract, ZExt, SExt, Not,
+      Add, Sub, Mul, UDiv, SDiv, URem, SRem,
+      And, Or, Xor, Shl, LShr, AShr,
+      Eq, Ne, Ult, Ule, Ugt, Uge, Slt, Sle, Sgt, Sge
+    };
+
+    struct Instruction {
+      Opcode opcode;
+      /// Width of the result, in bits.
+      unsigned width;
+      /// Operand registers; for Extract and SExt, \a b holds the bit offset
+      /// and source width respectively, and for Read, \a b is the array slot.
+      unsigned a, b, c;
+      uint64_t imm;
+
+      Instruction(Opcode _opcode, unsigned _width, unsigned _a = 0,
+                  unsigned _b = 0, unsigned _c = 0, uint64_t _imm = 0)
+        : opcode(_opcode), width(_width), a(_a), b(_b), c(_c), imm(_imm) {}
+    };
+
+    std::vector<ref<Expr> > constraints;
+    std::vector<Instruction> instructions;
+    /// The registers holding the value of each constraint.
+    std::vector<unsigned> roots;
+    /// The arrays read by the program, indexed by slot.
+    std::vector<const Array*> arrays;
+    bool valid;
+
+    class Compiler;
+
+    void run(const Assignment * const *batch, unsigned count,
+             bool *satisfied) const;
+
+  public:
+    template<typename InputIterator>
+    ConstraintProgram(InputIterator begin, InputIterator end)
+      : constraints(begin, end), valid(false) {
+      compile();
+    }
+
+    /// isValid - Whether every constraint was compiled.
+    bool isValid() const { return valid; }
+
+    unsigned getNumInstructions() const { return instructions.size(); }
+
+    /// satisfies - Return true if \a a satisfies all of the constraints.
+    bool satisfies(const Assignment &a) const;
+
+    /// satisfies - Check a batch of assignments, setting \a result[i] to
+    /// whether \a assignments[i] satisfies all of the constraints.
+    void satisfies(const std::vector<const Assignment*> &assignments,
+                   std::vector<bool> &result) const;
+
+    /// findSatisfying - Return the index of the first assignment in \a
+    /// assignments which satisfies all of the constraints, or the number of
+    /// assignments if there is none. Evaluation stops after the first batch
+    /// containing a satisfying assignment.
+    unsigned
+    findSatisfying(const std::vector<const Assignment*> &assignments) const;
+
+  private:
+    void compile();
+  };
+}
+
+#endif
@@ -0,0 +1,42 @@
+//===-- ExprRewriter.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_UTIL_EXPRREWRITER_H
+#define KLEE_UTIL_EXPRREWRITER_H
+
+#include "klee/Expr.h"
+
+#include <stdint.h>
+
+namespace klee {
+  /// ExprRewriter - A table of local rewrite rules which shrink expressions
+  /// beyond the folds done by the Expr::create functions themselves.
+  ///
+  /// Each rule matches on the kind of the expression and the shape of its
+  /// operands, and builds its result through Expr::create again, so the
+  /// result is itself fully rewritten. Results are memoized in a bounded
+  /// cache, and the number of times each rule fired is kept for reporting.
+  class ExprRewriter {
+  public:
+    /// rewrite - Return the result of applying the rules to \a e, or \a e
+    /// if none of them match.
+    static ref<Expr> rewrite(const ref<Expr> &e);
+
+    static unsigned getNumRules();
+    static const char *getRuleName(unsigned rule);
+    /// getRuleHits - Return how many times \a rule has rewritten an
+    /// expression.
+    static uint64_t getRuleHits(unsigned rule);
+    /// getMemoHits - Return how many rewrites were answered from the memo
+    /// cache.
+    static uint64_t getMemoHits();
+  };
+}
+
+#endif
@@ -36,6 +36,11 @@ UseIndependentSolver("use-independent-solver",
                      llvm::cl::init(true),
                      llvm::cl::desc("Use constraint independence (default=on)"));
 
+llvm::cl::opt<bool>
+UseBitWidthReduction("use-bitwidth-reduction",
+                     llvm::cl::init(false),
+                     llvm::cl::desc("Narrow comparisons to the bits their operands use before querying the core solver (default=off)"));
+
 llvm::cl::opt<bool>
 DebugValidateSolver("debug-validate-solver",
 		             llvm::cl::init(false));
@@ -42,6 +42,9 @@ namespace klee
 			  << baseSolverQuerySMT2LogPath.c_str() << "\n";
 	  }
 
+	  if (UseBitWidthReduction)
+		solver = createBitWidthReductionSolver(solver);
+
 	  if (UseFastCexSolver)
 		solver = createFastCexSolver(solver);
 
@@ -12,10 +12,33 @@
 #include "Memory.h"
 #include "TimingSolver.h"
 
+#include "klee/ExecutionState.h"
 #include "klee/Expr.h"
 #include "klee/TimerStatIncrementer.h"
+#include "klee/util/AbstractDomain.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <cstring>
+#include <set>
 
 using namespace klee;
+using namespace llvm;
+
+namespace {
+  cl::opt<bool>
+  ResolveByRange("resolve-by-range",
+                 cl::init(false),
+                 cl::desc("Resolve symbolic pointers by bounding their range before checking the objects within it (default=off)"));
+
+  /// The largest number of candidate objects which are checked to cover a
+  /// symbolic address with a single query.
+  const unsigned MaxCoverCandidates = 16;
+
+  /// The number of accesses kept in the resolution cache of each address
+  /// space before it is flushed.
+  const unsigned MaxResolutionCacheSize = 256;
+}
 
 ///
 
@@ -49,6 +72,45 @@ ObjectState *AddressSpace::getWriteable(const MemoryObject *mo,
   }
 }
 
+const MemoryObject *
+AddressSpace::lookupResolution(const KInstruction *ki,
+                               const ref<Expr> &address) const {
+  const ResolutionCache::value_type *res =
+    resolutionCache.lookup(std::make_pair(ki, address));
+  if (!res)
+    return 0;
+
+  // The object may have been freed since.
+  const MemoryObject *mo = res->second;
+  const MemoryMap::value_type *bound = objects.lookup(mo);
+  return bound && bound->first == mo ? mo : 0;
+}
+
+void AddressSpace::cacheResolution(const KInstruction *ki,
+                                   const ref<Expr> &address,
+                                   const ObjectPair &op) {
+  if (resolutionCache.size() >= MaxResolutionCacheSize)
+    resolutionCache = ResolutionCache();
+  resolutionCache = resolutionCache.replace(
+    std::make_pair(std::make_pair(ki, address),
+                   MemoryObjectHolder(op.first)));
+}
+
+void AddressSpace::keepCommonResolutions(const AddressSpace &b) {
+  ResolutionCache common;
+  for (ResolutionCache::iterator it = resolutionCache.begin(),
+         ie = resolutionCache.end(); it != ie; ++it) {
+    const ResolutionCache::value_type *other =
+      b.resolutionCache.lookup(it->first);
+    if (!other)
+      continue;
+    const MemoryObject *mo = it->second, *otherMO = other->second;
+    if (mo == otherMO)
+      common = common.insert(*it);
+  }
+  resolutionCache = common;
+}
+
 /// 
 
 bool AddressSpace::resolveOne(const ref<ConstantExpr> &addr, 
@@ -84,6 +146,7 @@ bool AddressSpace::resolveOne(ExecutionState &state,
     // try cheap search, will succeed for any inbounds pointer
 
     ref<ConstantExpr> cex;
+    ++stats::resolveQueries;
     if (!solver->getValue(state, address, cex))
       return false;
     uint64_t example = cex->getZExtValue();
@@ -100,6 +163,17 @@ bool AddressSpace::resolveOne(ExecutionState &state,
     }
 
     // didn't work, now we have to search
+
+    if (ResolveByRange) {
+      ResolutionList rl;
+      if (resolveByRange(state, solver, address, rl, 1, 0, timer) &&
+          rl.empty())
+        return false;
+      success = !rl.empty();
+      if (success)
+        result = rl[0];
+      return true;
+    }
        
     MemoryMap::iterator oi = objects.upper_bound(&hack);
     MemoryMap::iterator begin = objects.begin();
@@ -111,6 +185,7 @@ bool AddressSpace::resolveOne(ExecutionState &state,
       const MemoryObject *mo = oi->first;
         
       bool mayBeTrue;
+      ++stats::resolveQueries;
       if (!solver->mayBeTrue(state, 
                              mo->getBoundsCheckPointer(address), mayBeTrue))
         return false;
@@ -120,6 +195,7 @@ bool AddressSpace::resolveOne(ExecutionState &state,
         return true;
       } else {
         bool mustBeTrue;
+        ++stats::resolveQueries;
         if (!solver->mustBeTrue(state, 
                                 UgeExpr::create(address, mo->getBaseExpr()),
                                 mustBeTrue))
@@ -134,6 +210,7 @@ bool AddressSpace::resolveOne(ExecutionState &state,
       const MemoryObject *mo = oi->first;
 
       bool mustBeTrue;
+      ++stats::resolveQueries;
       if (!solver->mustBeTrue(state, 
                               UltExpr::create(address, mo->getBaseExpr()),
                               mustBeTrue))
@@ -143,6 +220,7 @@ bool AddressSpace::resolveOne(ExecutionState &state,
       } else {
         bool mayBeTrue;
 
+        ++stats::resolveQueries;
         if (!solver->mayBeTrue(state, 
                                mo->getBoundsCheckPointer(address),
                                mayBeTrue))
@@ -175,6 +253,10 @@ bool AddressSpace::resolve(ExecutionState &state,
     TimerStatIncrementer timer(stats::resolveTime);
     uint64_t timeout_us = (uint64_t) (timeout*1000000.);
 
+    if (ResolveByRange)
+      return resolveByRange(state, solver, p, rl, maxResolutions, timeout_us,
+                            timer);
+
     // XXX in general this isn't exactly what we want... for
     // a multiple resolution case (or for example, a \in {b,c,0})
     // we want to find the first object, find a cex assuming
@@ -191,6 +273,7 @@ bool AddressSpace::resolve(ExecutionState &state,
     // just get this by inspection of the expr.
     
     ref<ConstantExpr> cex;
+    ++stats::resolveQueries;
     if (!solver->getValue(state, p, cex))
       return true;
     uint64_t example = cex->getZExtValue();
@@ -219,6 +302,7 @@ bool AddressSpace::resolve(ExecutionState &state,
       // XXX I think there is some query wasteage here?
       ref<Expr> inBounds = mo->getBoundsCheckPointer(p);
       bool mayBeTrue;
+      ++stats::resolveQueries;
       if (!solver->mayBeTrue(state, inBounds, mayBeTrue))
         return true;
       if (mayBeTrue) {
@@ -228,6 +312,7 @@ bool AddressSpace::resolve(ExecutionState &state,
         unsigned size = rl.size();
         if (size==1) {
           bool mustBeTrue;
+          ++stats::resolveQueries;
           if (!solver->mustBeTrue(state, inBounds, mustBeTrue))
             return true;
           if (mustBeTrue)
@@ -238,6 +323,7 @@ bool AddressSpace::resolve(ExecutionState &state,
       }
         
       bool mustBeTrue;
+      ++stats::resolveQueries;
       if (!solver->mustBeTrue(state, 
                               UgeExpr::create(p, mo->getBaseExpr()),
                               mustBeTrue))
@@ -252,6 +338,7 @@ bool AddressSpace::resolve(ExecutionState &state,
         return true;
 
       bool mustBeTrue;
+      ++stats::resolveQueries;
       if (!solver->mustBeTrue(state, 
                               UltExpr::create(p, mo->getBaseExpr()),
                               mustBeTrue))
@@ -262,6 +349,7 @@ bool AddressSpace::resolve(ExecutionState &state,
       // XXX I think there is some query wasteage here?
       ref<Expr> inBounds = mo->getBoundsCheckPointer(p);
       bool mayBeTrue;
+      ++stats::resolveQueries;
       if (!solver->mayBeTrue(state, inBounds, mayBeTrue))
         return true;
       if (mayBeTrue) {
@@ -271,6 +359,7 @@ bool AddressSpace::resolve(ExecutionState &state,
         unsigned size = rl.size();
         if (size==1) {
           bool mustBeTrue;
+          ++stats::resolveQueries;
           if (!solver->mustBeTrue(state, inBounds, mustBeTrue))
             return true;
           if (mustBeTrue)
@@ -285,46 +374,216 @@ bool AddressSpace::resolve(ExecutionState &state,
   return false;
 }
 
+bool AddressSpace::resolveByRange(ExecutionState &state,
+                                  TimingSolver *solver,
+                                  ref<Expr> p,
+                                  ResolutionList &rl,
+                                  unsigned maxResolutions,
+                                  uint64_t timeout_us,
+                                  TimerStatIncrementer &timer) {
+  // Bound the address with the state's abstract domain, which needs no
+  // queries at all.
+  uint64_t lo = 0, hi = ~(uint64_t) 0;
+  if (p->getWidth() <= 64) {
+    AbstractValue range = state.abstractDomain.evaluate(p);
+    if (range.isEmpty())
+      return false;
+    lo = range.min;
+    hi = range.max;
+  }
+
+  // Collect the objects overlapping the range, starting with the one which
+  // may contain its lower end.
+  std::vector<ObjectPair> candidates;
+  MemoryObject hack(lo);
+  MemoryMap::iterator oi = objects.upper_bound(&hack);
+  MemoryMap::iterator begin = objects.begin();
+  MemoryMap::iterator end = objects.end();
+  if (oi != begin) {
+    --oi;
+    const MemoryObject *mo = oi->first;
+    if (lo - mo->address >= std::max(mo->size, 1U))
+      ++oi;
+  }
+  for (; oi != end && oi->first->address <= hi; ++oi)
+    candidates.push_back(*oi);
+
+  // The objects are disjoint and sorted by address, so both their starts
+  // and their ends are increasing. Narrow the candidates down with binary
+  // searches for the first object whose end the address may be below, and
+  // for the last object whose start it may be at or above.
+  unsigned first = 0, last = candidates.size();
+  if (last > 2) {
+    unsigned a = 0, b = last;
+    while (a < b) {
+      unsigned mid = a + (b - a) / 2;
+      const MemoryObject *mo = candidates[mid].first;
+      ref<Expr> limit =
+        ConstantExpr::create(mo->address + std::max(mo->size, 1U),
+                             Context::get().getPointerWidth());
+      bool mayBeTrue;
+      ++stats::resolveQueries;
+      if (!solver->mayBeTrue(state, UltExpr::create(p, limit), mayBeTrue))
+        return true;
+      if (mayBeTrue)
+        b = mid;
+      else
+        a = mid + 1;
+    }
+    first = a;
+
+    b = last;
+    while (a < b) {
+      unsigned mid = a + (b - a) / 2;
+      const MemoryObject *mo = candidates[mid].first;
+      bool mayBeTrue;
+      ++stats::resolveQueries;
+      if (!solver->mayBeTrue(state, UgeExpr::create(p, mo->getBaseExpr()),
+                             mayBeTrue))
+        return true;
+      if (mayBeTrue)
+        a = mid + 1;
+      else
+        b = mid;
+    }
+    last = a;
+  }
+
+  if (first == last)
+    return false;
+
+  // If there are few candidates left, check with a single query whether
+  // the address always points into one of them.
+  bool covered = false;
+  if (last - first <= MaxCoverCandidates) {
+    ref<Expr> cover = ConstantExpr::alloc(0, Expr::Bool);
+    for (unsigned i = first; i != last; ++i)
+      cover = OrExpr::create(cover,
+                             candidates[i].first->getBoundsCheckPointer(p));
+    ++stats::resolveQueries;
+    if (!solver->mustBeTrue(state, cover, covered))
+      return true;
+  }
+
+  for (unsigned i = first; i != last; ++i) {
+    if (timeout_us && timeout_us < timer.check())
+      return true;
+
+    // The last candidate must be feasible if the address is covered and
+    // none of the others are.
+    bool mayBeTrue = covered && rl.empty() && i + 1 == last;
+    if (!mayBeTrue) {
+      ++stats::resolveQueries;
+      if (!solver->mayBeTrue(state,
+                             candidates[i].first->getBoundsCheckPointer(p),
+                             mayBeTrue))
+        return true;
+    }
+    if (mayBeTrue) {
+      rl.push_back(candidates[i]);
+      if (rl.size() == maxResolutions)
+        return true;
+    }
+  }
+
+  return false;
+}
+
 // These two are pretty big hack so we can sort of pass memory back
 // and forth to externals. They work by abusing the concrete cache
 // store inside of the object states, which allows them to
 // transparently avoid screwing up symbolics (if the byte is symbolic
 // then its concrete cache byte isn't being used) but is just a hack.
 
-void AddressSpace::copyOutConcretes() {
-  for (MemoryMap::iterator it = objects.begin(), ie = objects.end(); 
-       it != ie; ++it) {
-    const MemoryObject *mo = it->first;
+void AddressSpace::copyOutConcrete(const MemoryObject *mo,
+                                   const ObjectState *os) const {
+  if (!mo->isUserSpecified) {
+    uint8_t *address = (uint8_t*) (unsigned long) mo->address;
 
-    if (!mo->isUserSpecified) {
-      ObjectState *os = it->second;
-      uint8_t *address = (uint8_t*) (unsigned long) mo->address;
+    if (!os->readOnly)
+      memcpy(address, os->concreteStore, mo->size);
+  }
+}
+
+bool AddressSpace::copyInConcrete(const MemoryObject *mo,
+                                  const ObjectState *os) {
+  if (!mo->isUserSpecified) {
+    uint8_t *address = (uint8_t*) (unsigned long) mo->address;
 
-      if (!os->readOnly)
-        memcpy(address, os->concreteStore, mo->size);
+    if (memcmp(address, os->concreteStore, mo->size)!=0) {
+      if (os->readOnly) {
+        return false;
+      } else {
+        ObjectState *wos = getWriteable(mo, os);
+        memcpy(wos->concreteStore, address, mo->size);
+        wos->invalidateContentCaches();
+      }
     }
   }
+
+  return true;
+}
+
+void AddressSpace::copyOutConcretes() {
+  for (MemoryMap::iterator it = objects.begin(), ie = objects.end(); 
+       it != ie; ++it)
+    copyOutConcrete(it->first, it->second);
 }
 
 bool AddressSpace::copyInConcretes() {
   for (MemoryMap::iterator it = objects.begin(), ie = objects.end(); 
-       it != ie; ++it) {
-    const MemoryObject *mo = it->first;
+       it != ie; ++it)
+    if (!copyInConcrete(it->first, it->second))
+      return false;
 
-    if (!mo->isUserSpecified) {
-      const ObjectState *os = it->second;
-      uint8_t *address = (uint8_t*) (unsigned long) mo->address;
+  return true;
+}
 
-      if (memcmp(address, os->concreteStore, mo->size)!=0) {
-        if (os->readOnly) {
-          return false;
-        } else {
-          ObjectState *wos = getWriteable(mo, os);
-          memcpy(wos->concreteStore, address, mo->size);
-        }
-      }
+void AddressSpace::getReachableObjects(const std::vector<uint64_t> &roots,
+                                       std::vector<const MemoryObject*> &
+                                         result) {
+  Expr::Width width = Context::get().getPointerWidth();
+  unsigned pointerBytes = width / 8;
+  std::set<const MemoryObject*> seen;
+  std::vector<uint64_t> worklist(roots);
+
+  while (!worklist.empty()) {
+    uint64_t address = worklist.back();
+    worklist.pop_back();
+
+    ObjectPair op;
+    if (!resolveOne(ConstantExpr::create(address, width), op) ||
+        !seen.insert(op.first).second)
+      continue;
+
+    const MemoryObject *mo = op.first;
+    const ObjectState *os = op.second;
+    result.push_back(mo);
+
+    // Any word of the object could be a pointer which is followed; a word
+    // which is not a pointer just adds one more object.
+    for (unsigned i = 0; i + pointerBytes <= mo->size; i += pointerBytes) {
+      uint64_t value = 0;
+      memcpy(&value, os->concreteStore + i, pointerBytes);
+      if (value)
+        worklist.push_back(value);
     }
   }
+}
+
+void AddressSpace::copyOutConcretes(const std::vector<const MemoryObject*> &
+                                      objects) {
+  for (std::vector<const MemoryObject*>::const_iterator it = objects.begin(),
+         ie = objects.end(); it != ie; ++it)
+    copyOutConcrete(*it, findObject(*it));
+}
+
+bool AddressSpace::copyInConcretes(const std::vector<const MemoryObject*> &
+                                     objects) {
+  for (std::vector<const MemoryObject*>::const_iterator it = objects.begin(),
+         ie = objects.end(); it != ie; ++it)
+    if (!copyInConcrete(*it, findObject(*it)))
+      return false;
 
   return true;
 }
@@ -17,8 +17,10 @@
 
 namespace klee {
   class ExecutionState;
+  struct KInstruction;
   class MemoryObject;
   class ObjectState;
+  class TimerStatIncrementer;
   class TimingSolver;
 
   template<class T> class ref;
@@ -32,12 +34,44 @@ namespace klee {
   };
   
   typedef ImmutableMap<const MemoryObject*, ObjectHolder, MemoryObjectLT> MemoryMap;
+
+  /// Maps a memory instruction and the address it accessed to the object
+  /// the access was shown to always be within. The object is held so that
+  /// it cannot be deleted and its address reused while it is cached; its
+  /// contents are looked up in the address space.
+  typedef ImmutableMap<std::pair<const KInstruction*, ref<Expr> >,
+                       MemoryObjectHolder> ResolutionCache;
   
   class AddressSpace {
   private:
     /// Epoch counter used to control ownership of objects.
     mutable unsigned cowKey;
 
+    /// Accesses which are known to be in bounds of a single object. These
+    /// stay valid as constraints are added and objects are allocated, and
+    /// only go stale once their object is freed.
+    ResolutionCache resolutionCache;
+
+    /// Resolve a symbolic address by first bounding the range of values it
+    /// may take, and then only checking the objects within that range.
+    ///
+    /// \return true iff the resolution is incomplete, as for resolve().
+    bool resolveByRange(ExecutionState &state,
+                        TimingSolver *solver,
+                        ref<Expr> address,
+                        ResolutionList &rl,
+                        unsigned maxResolutions,
+                        uint64_t timeout_us,
+                        TimerStatIncrementer &timer);
+
+    /// Copy the concrete values of \a mo to its system memory location,
+    /// as copyOutConcretes does for every object.
+    void copyOutConcrete(const MemoryObject *mo, const ObjectState *os) const;
+
+    /// Copy the concrete values of \a mo back from its system memory
+    /// location, as copyInConcretes does for every object.
+    bool copyInConcrete(const MemoryObject *mo, const ObjectState *os);
+
     /// Unsupported, use copy constructor
     AddressSpace &operator=(const AddressSpace&); 
     
@@ -53,7 +87,9 @@ namespace klee {
     
   public:
     AddressSpace() : cowKey(1) {}
-    AddressSpace(const AddressSpace &b) : cowKey(++b.cowKey), objects(b.objects) { }
+    AddressSpace(const AddressSpace &b)
+      : cowKey(++b.cowKey), resolutionCache(b.resolutionCache),
+        objects(b.objects) { }
     ~AddressSpace() {}
 
     /// Resolve address to an ObjectPair in result.
@@ -89,6 +125,21 @@ namespace klee {
                  unsigned maxResolutions=0,
                  double timeout=0.);
 
+    /// Return the object the access by \a ki to \a address was recorded to
+    /// always be within, or null.
+    const MemoryObject *lookupResolution(const KInstruction *ki,
+                                         const ref<Expr> &address) const;
+
+    /// Record that the access by \a ki to \a address is always within the
+    /// object of \a op.
+    void cacheResolution(const KInstruction *ki, const ref<Expr> &address,
+                         const ObjectPair &op);
+
+    /// Drop the recorded resolutions which \a b does not record to the
+    /// same object, as they need not hold when this space is merged with
+    /// \a b.
+    void keepCommonResolutions(const AddressSpace &b);
+
     /***/
 
     /// Add a binding to the address space.
@@ -125,6 +176,19 @@ namespace klee {
     /// \retval true The copy succeeded. 
     /// \retval false The copy failed because a read-only object was modified.
     bool copyInConcretes();
+
+    /// Find the objects reachable from the addresses in \a roots: the
+    /// objects they point into, and transitively the objects pointed into
+    /// by any pointer-sized word of the concrete values of a reachable
+    /// object.
+    void getReachableObjects(const std::vector<uint64_t> &roots,
+                             std::vector<const MemoryObject*> &result);
+
+    /// Copy out, as copyOutConcretes does, only the given \a objects.
+    void copyOutConcretes(const std::vector<const MemoryObject*> &objects);
+
+    /// Copy in, as copyInConcretes does, only the given \a objects.
+    bool copyInConcretes(const std::vector<const MemoryObject*> &objects);
   };
 } // End klee namespace
 
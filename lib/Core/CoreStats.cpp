@@ -11,19 +11,39 @@
 
 using namespace klee;
 
+Statistic stats::abstractDomainPrunedQueries("AbstractDomainPrunedQueries",
+                                             "ADpruned");
 Statistic stats::allocations("Allocations", "Alloc");
+Statistic stats::concolicModelHits("ConcolicModelHits", "CMhits");
+Statistic stats::concreteFastPathInstructions("ConcreteFastPathInstructions",
+                                               "IFast");
 Statistic stats::coveredInstructions("CoveredInstructions", "Icov");
+Statistic stats::duplicateStatesPruned("DuplicateStatesPruned", "DupPruned");
+Statistic stats::externalCallsFastPath("ExternalCallsFastPath", "ExtFast");
 Statistic stats::falseBranches("FalseBranches", "Bf");
 Statistic stats::forkTime("ForkTime", "Ftime");
 Statistic stats::forks("Forks", "Forks");
 Statistic stats::instructionRealTime("InstructionRealTimes", "Ireal");
 Statistic stats::instructionTime("InstructionTimes", "Itime");
 Statistic stats::instructions("Instructions", "I");
+Statistic stats::mergeQueriesSaved("MergeQueriesSaved", "MQsaved");
+Statistic stats::mergedStates("MergedStates", "Merged");
 Statistic stats::minDistToReturn("MinDistToReturn", "Rdist");
+Statistic stats::minDistToTarget("MinDistToTarget", "Tdist");
 Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist");
+Statistic stats::nativeCallBailouts("NativeCallBailouts", "NatBail");
+Statistic stats::nativeCalls("NativeCalls", "NatCalls");
 Statistic stats::reachableUncovered("ReachableUncovered", "IuncovReach");
+Statistic stats::replayedBranches("ReplayedBranches", "RepBr");
+Statistic stats::resolutionCacheHits("ResolutionCacheHits", "RChits");
+Statistic stats::resolutionCacheMisses("ResolutionCacheMisses", "RCmisses");
+Statistic stats::resolutions("Resolutions", "Res");
+Statistic stats::resolveQueries("ResolveQueries", "ResQ");
 Statistic stats::resolveTime("ResolveTime", "Rtime");
+Statistic stats::segmentedAccesses("SegmentedAccesses", "SegAcc");
+Statistic stats::segmentedForksAvoided("SegmentedForksAvoided", "SegFAvoid");
 Statistic stats::solverTime("SolverTime", "Stime");
 Statistic stats::states("States", "States");
+Statistic stats::targetUnreachableStates("TargetUnreachableStates", "TUnreach");
 Statistic stats::trueBranches("TrueBranches", "Bt");
 Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov");
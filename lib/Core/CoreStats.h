@@ -17,7 +17,21 @@ namespace stats {
 
   extern Statistic allocations;
   extern Statistic resolveTime;
+
+  /// The number of memory accesses through symbolic addresses, and the
+  /// number of solver queries issued to resolve them.
+  extern Statistic resolutions;
+  extern Statistic resolveQueries;
+
+  /// The number of symbolic loads and stores whose object and bounds check
+  /// were found in the per-state resolution cache, and those which were not.
+  extern Statistic resolutionCacheHits;
+  extern Statistic resolutionCacheMisses;
+
   extern Statistic instructions;
+  /// The number of instructions run by the concrete basic block fast
+  /// path, without bookkeeping after them.
+  extern Statistic concreteFastPathInstructions;
   extern Statistic instructionTime;
   extern Statistic instructionRealTime;
   extern Statistic coveredInstructions;
@@ -30,6 +44,47 @@ namespace stats {
   /// The number of process forks.
   extern Statistic forks;
 
+  /// The number of branches where one side was shown feasible by the
+  /// state's concolic model instead of by a solver query.
+  extern Statistic concolicModelHits;
+
+  /// The number of branch and bounds check queries decided by the
+  /// state's abstract domain without calling the solver.
+  extern Statistic abstractDomainPrunedQueries;
+
+  /// The number of memory accesses done over several objects at once by
+  /// the segmented memory model, and the number of forks this avoided.
+  extern Statistic segmentedAccesses;
+  extern Statistic segmentedForksAvoided;
+
+  /// The number of external calls to pure functions which were evaluated
+  /// directly instead of through the external dispatcher.
+  extern Statistic externalCallsFastPath;
+
+  /// The number of calls to module functions which were run natively, and
+  /// the number which could have been but were found to reach symbolic
+  /// memory or failed, and were interpreted instead.
+  extern Statistic nativeCalls;
+  extern Statistic nativeCallBailouts;
+
+  /// The number of states the directed searcher dropped because they could
+  /// no longer reach the --target.
+  extern Statistic targetUnreachableStates;
+
+  /// The number of states terminated by --prune-duplicate-states for being
+  /// equal to a state seen before.
+  extern Statistic duplicateStatesPruned;
+
+  /// The number of states --use-qce-merge merged into others, and the
+  /// number of queries those states were estimated to issue after the
+  /// merge point.
+  extern Statistic mergedStates;
+  extern Statistic mergeQueriesSaved;
+
+  /// The number of symbolic branches --fast-replay-path took from the
+  /// replay path without asking the solver.
+  extern Statistic replayedBranches;
+
   /// Number of states, this is a "fake" statistic used by istats, it
   /// isn't normally up-to-date.
   extern Statistic states;
@@ -47,6 +102,10 @@ namespace stats {
   /// distance to a function return.
   extern Statistic minDistToReturn;
 
+  /// Instruction level statistic tracking the minimum interprocedural
+  /// distance to the --target instructions; computed once.
+  extern Statistic minDistToTarget;
+
 }
 }
 
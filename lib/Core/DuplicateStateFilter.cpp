@@ -0,0 +1,186 @@
+//===-- DuplicateStateFilter.cpp ------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DuplicateStateFilter.h"
+
+#include "Memory.h"
+
+#include "klee/Internal/Module/Cell.h"
+#include "klee/Internal/Module/KInstruction.h"
+#include "klee/Internal/Module/KModule.h"
+#include "klee/util/ExprUtil.h"
+
+#include <set>
+
+using namespace klee;
+
+static inline unsigned combine(unsigned res, unsigned value) {
+  return res * Expr::MAGIC_HASH_CONSTANT + value;
+}
+
+static inline unsigned hashPointer(const void *p) {
+  return (unsigned) (((unsigned long) p) >> 3);
+}
+
+static bool equalCells(const Cell &a, const Cell &b) {
+  if (a.value.isNull() || b.value.isNull())
+    return a.value.isNull() == b.value.isNull();
+  return a.value == b.value;
+}
+
+DuplicateStateFilter::Snapshot::Snapshot(const ExecutionState &state,
+                                         const constraints_ty &_constraints)
+  : pc(state.pc),
+    stack(state.stack),
+    addressSpace(state.addressSpace),
+    constraints(_constraints),
+    symbolics(state.symbolics) {}
+
+DuplicateStateFilter::~DuplicateStateFilter() {
+  for (snapshots_ty::iterator it = snapshots.begin(), ie = snapshots.end();
+       it != ie; ++it)
+    delete it->second;
+}
+
+void DuplicateStateFilter::getLiveConstraints(const ExecutionState &state,
+                                              constraints_ty &result) {
+  if (state.constraints.empty())
+    return;
+
+  std::vector<const Array*> arrays;
+  for (ExecutionState::stack_ty::const_iterator it = state.stack.begin(),
+         ie = state.stack.end(); it != ie; ++it)
+    for (unsigned i = 0; i != it->kf->numRegisters; ++i)
+      if (!it->locals[i].value.isNull() &&
+          !isa<ConstantExpr>(it->locals[i].value))
+        findSymbolicObjects(it->locals[i].value, arrays);
+  for (MemoryMap::iterator it = state.addressSpace.objects.begin(),
+         ie = state.addressSpace.objects.end(); it != ie; ++it) {
+    const ObjectState *os = it->second;
+    os->findSymbolicArrays(arrays);
+  }
+  std::set<const Array*> live(arrays.begin(), arrays.end());
+
+  // Grow the live arrays through the constraints until nothing changes.
+  unsigned numConstraints = state.constraints.size();
+  std::vector< std::vector<const Array*> > reads(numConstraints);
+  std::vector<bool> isLive(numConstraints, false);
+  for (unsigned i = 0; i != numConstraints; ++i)
+    findSymbolicObjects(state.constraints.begin()[i], reads[i]);
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (unsigned i = 0; i != numConstraints; ++i) {
+      if (isLive[i])
+        continue;
+      for (unsigned j = 0; j != reads[i].size(); ++j) {
+        if (live.count(reads[i][j])) {
+          isLive[i] = changed = true;
+          live.insert(reads[i].begin(), reads[i].end());
+          break;
+        }
+      }
+    }
+  }
+
+  for (unsigned i = 0; i != numConstraints; ++i)
+    if (isLive[i])
+      result.push_back(state.constraints.begin()[i]);
+}
+
+unsigned
+DuplicateStateFilter::computeFingerprint(const ExecutionState &state,
+                                         const constraints_ty &constraints) {
+  unsigned res = hashPointer((KInstruction*) state.pc);
+
+  for (ExecutionState::stack_ty::const_iterator it = state.stack.begin(),
+         ie = state.stack.end(); it != ie; ++it) {
+    res = combine(res, hashPointer(it->kf));
+    res = combine(res, hashPointer((KInstruction*) it->caller));
+    for (unsigned i = 0; i != it->kf->numRegisters; ++i) {
+      const ref<Expr> &value = it->locals[i].value;
+      res = combine(res, value.isNull() ? 0 : value->hash());
+    }
+  }
+
+  // Objects are visited in address order, so equal address spaces combine
+  // their hashes in the same order.
+  for (MemoryMap::iterator it = state.addressSpace.objects.begin(),
+         ie = state.addressSpace.objects.end(); it != ie; ++it) {
+    const ObjectState *os = it->second;
+    res = combine(res, it->first->id);
+    res = combine(res, os->getContentHash());
+  }
+
+  for (constraints_ty::const_iterator it = constraints.begin(),
+         ie = constraints.end(); it != ie; ++it)
+    res = combine(res, (*it)->hash());
+
+  return res;
+}
+
+bool DuplicateStateFilter::equals(const Snapshot &snapshot,
+                                  const ExecutionState &state,
+                                  const constraints_ty &constraints) {
+  if (snapshot.pc != state.pc ||
+      snapshot.stack.size() != state.stack.size() ||
+      snapshot.constraints.size() != constraints.size() ||
+      snapshot.symbolics != state.symbolics ||
+      snapshot.addressSpace.objects.size() !=
+        state.addressSpace.objects.size())
+    return false;
+
+  for (unsigned i = 0, e = state.stack.size(); i != e; ++i) {
+    const StackFrame &a = snapshot.stack[i], &b = state.stack[i];
+    if (a.kf != b.kf || a.caller != b.caller || a.varargs != b.varargs ||
+        a.allocas != b.allocas)
+      return false;
+    for (unsigned j = 0; j != a.kf->numRegisters; ++j)
+      if (!equalCells(a.locals[j], b.locals[j]))
+        return false;
+  }
+
+  for (unsigned i = 0, e = constraints.size(); i != e; ++i)
+    if (snapshot.constraints[i] != constraints[i])
+      return false;
+
+  for (MemoryMap::iterator it = snapshot.addressSpace.objects.begin(),
+         ie = snapshot.addressSpace.objects.end(),
+         it2 = state.addressSpace.objects.begin(); it != ie; ++it, ++it2) {
+    if (it->first != it2->first)
+      return false;
+    const ObjectState *a = it->second, *b = it2->second;
+    if (!a->equals(*b))
+      return false;
+  }
+
+  return true;
+}
+
+bool DuplicateStateFilter::isDuplicate(const ExecutionState &state) {
+  constraints_ty constraints;
+  getLiveConstraints(state, constraints);
+  unsigned fingerprint = computeFingerprint(state, constraints);
+
+  std::pair<snapshots_ty::iterator, snapshots_ty::iterator> range =
+    snapshots.equal_range(fingerprint);
+  for (snapshots_ty::iterator it = range.first; it != range.second; ++it)
+    if (equals(*it->second, state, constraints))
+      return true;
+
+  if (!maxSnapshots)
+    return false;
+  if (order.size() == maxSnapshots) {
+    delete order.front()->second;
+    snapshots.erase(order.front());
+    order.pop_front();
+  }
+  Snapshot *snapshot = new Snapshot(state, constraints);
+  order.push_back(snapshots.insert(std::make_pair(fingerprint, snapshot)));
+  return false;
+}
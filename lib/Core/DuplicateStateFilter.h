@@ -0,0 +1,75 @@
+//===-- DuplicateStateFilter.h ----------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_DUPLICATESTATEFILTER_H
+#define KLEE_DUPLICATESTATEFILTER_H
+
+#include "klee/ExecutionState.h"
+
+#include <deque>
+#include <map>
+
+namespace klee {
+  /// DuplicateStateFilter - Remembers snapshots of the states which passed
+  /// through it, so that a state which is equal to an earlier one can be
+  /// recognized as redundant: everything it would go on to explore is
+  /// already explored by the state it duplicates.
+  ///
+  /// Snapshots are looked up by a fingerprint of the program counter, the
+  /// stack, the memory contents and the path constraints, and only then
+  /// compared in full. The hashes of the memory objects are cached in the
+  /// objects, so fingerprinting a state only rehashes objects written to
+  /// since they were last hashed.
+  ///
+  /// Only the constraints on values which the state can still read take
+  /// part. States which forked on a value which is dead by now, such as a
+  /// symbolic local of a function which has returned, differ only in
+  /// constraints which can no longer affect their execution.
+  class DuplicateStateFilter {
+    typedef std::vector< ref<Expr> > constraints_ty;
+
+    struct Snapshot {
+      KInstIterator pc;
+      ExecutionState::stack_ty stack;
+      AddressSpace addressSpace;
+      constraints_ty constraints;
+      std::vector<std::pair<const MemoryObject*, const Array*> > symbolics;
+
+      Snapshot(const ExecutionState &state, const constraints_ty &_constraints);
+    };
+
+    typedef std::multimap<unsigned, Snapshot*> snapshots_ty;
+
+    snapshots_ty snapshots;
+    /// The snapshots in the order they were taken, oldest first.
+    std::deque<snapshots_ty::iterator> order;
+    unsigned maxSnapshots;
+
+    /// Collect the constraints of \a state which share arrays, directly or
+    /// through other constraints, with its memory or stack.
+    static void getLiveConstraints(const ExecutionState &state,
+                                   constraints_ty &result);
+    static unsigned computeFingerprint(const ExecutionState &state,
+                                       const constraints_ty &constraints);
+    static bool equals(const Snapshot &snapshot, const ExecutionState &state,
+                       const constraints_ty &constraints);
+
+  public:
+    explicit DuplicateStateFilter(unsigned _maxSnapshots)
+      : maxSnapshots(_maxSnapshots) {}
+    ~DuplicateStateFilter();
+
+    /// isDuplicate - Return true if \a state is equal to a state seen
+    /// before, or remember it and return false. Once the limit on the
+    /// number of snapshots is reached the oldest ones are forgotten.
+    bool isDuplicate(const ExecutionState &state);
+  };
+}
+
+#endif
@@ -70,6 +70,10 @@ ExecutionState::ExecutionState(KFunction *kf) :
     pc(kf->instructions),
     prevPC(pc),
 
+    concolicModelValid(false),
+    useAbstractDomain(false),
+    uncheckedConstraints(false),
+
     queryCost(0.), 
     weight(1),
     depth(0),
@@ -77,12 +81,17 @@ ExecutionState::ExecutionState(KFunction *kf) :
     instsSinceCovNew(0),
     coveredNew(false),
     forkDisabled(false),
-    ptreeNode(0) {
+    ptreeNode(0),
+    registryIndex(~0U),
+    seedSlot(~0U) {
   pushFrame(0, kf);
 }
 
 ExecutionState::ExecutionState(const std::vector<ref<Expr> > &assumptions)
-    : constraints(assumptions), queryCost(0.), ptreeNode(0) {}
+    : constraints(assumptions), concolicModelValid(false),
+      useAbstractDomain(false), uncheckedConstraints(false), queryCost(0.),
+      ptreeNode(0),
+      registryIndex(~0U), seedSlot(~0U) {}
 
 ExecutionState::~ExecutionState() {
   for (unsigned int i=0; i<symbolics.size(); i++)
@@ -106,6 +115,11 @@ ExecutionState::ExecutionState(const ExecutionState& state):
 
     addressSpace(state.addressSpace),
     constraints(state.constraints),
+    concolicModel(state.concolicModel),
+    concolicModelValid(state.concolicModelValid),
+    abstractDomain(state.abstractDomain),
+    useAbstractDomain(state.useAbstractDomain),
+    uncheckedConstraints(state.uncheckedConstraints),
 
     queryCost(state.queryCost),
     weight(state.weight),
@@ -119,6 +133,8 @@ ExecutionState::ExecutionState(const ExecutionState& state):
     forkDisabled(state.forkDisabled),
     coveredLines(state.coveredLines),
     ptreeNode(state.ptreeNode),
+    registryIndex(~0U),
+    seedSlot(~0U),
     symbolics(state.symbolics),
     arrayNames(state.arrayNames)
 {
@@ -155,6 +171,20 @@ void ExecutionState::addSymbolic(const MemoryObject *mo, const Array *array) {
   mo->refCount++;
   symbolics.push_back(std::make_pair(mo, array));
 }
+
+void ExecutionState::addConstraint(ref<Expr> e) {
+  constraints.addConstraint(e);
+  if (useAbstractDomain)
+    abstractDomain.addConstraint(e);
+
+  // The model only stays usable as long as it satisfies every
+  // constraint we add; otherwise it must be recomputed.
+  if (concolicModelValid) {
+    ref<Expr> value = concolicModel.evaluate(e);
+    if (!isa<ConstantExpr>(value) || !cast<ConstantExpr>(value)->isTrue())
+      concolicModelValid = false;
+  }
+}
 ///
 
 std::string ExecutionState::getFnAlias(std::string fn) {
@@ -278,7 +308,8 @@ bool ExecutionState::merge(const ExecutionState &b) {
       }
       return false;
     }
-    if (ai->second != bi->second) {
+    const ObjectState *aos = ai->second, *bos = bi->second;
+    if (aos != bos && !aos->equals(*bos)) {
       if (DebugLogStateMerge)
         llvm::errs() << "\t\tmutated: " << ai->first->id << "\n";
       mutated.insert(ai->first);
@@ -344,6 +375,17 @@ bool ExecutionState::merge(const ExecutionState &b) {
          ie = commonConstraints.end(); it != ie; ++it)
     constraints.addConstraint(*it);
   constraints.addConstraint(OrExpr::create(inA, inB));
+  // The merged constraints hold if those of either state do.
+  uncheckedConstraints = uncheckedConstraints && b.uncheckedConstraints;
+
+  // An access shown to be in bounds under the constraints of one state may
+  // not be under the weaker merged ones.
+  addressSpace.keepCommonResolutions(b.addressSpace);
+
+  // The merged state may be in either of the two, so only what holds in
+  // both domains is kept.
+  if (useAbstractDomain)
+    abstractDomain = abstractDomain.join(b.abstractDomain);
 
   return true;
 }
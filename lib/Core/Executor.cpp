@@ -10,11 +10,13 @@
 #include "Executor.h"
 #include "Context.h"
 #include "CoreStats.h"
+#include "DuplicateStateFilter.h"
 #include "ExternalDispatcher.h"
 #include "ImpliedValue.h"
 #include "Memory.h"
 #include "MemoryManager.h"
 #include "PTree.h"
+#include "PureExternals.h"
 #include "Searcher.h"
 #include "SeedInfo.h"
 #include "SpecialFunctionHandler.h"
@@ -58,6 +60,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/TypeBuilder.h"
 #else
@@ -69,6 +72,7 @@
 #include "llvm/IntrinsicInst.h"
 #include "llvm/LLVMContext.h"
 #include "llvm/Module.h"
+#include "llvm/Operator.h"
 #if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
 #include "llvm/Target/TargetData.h"
 #else
@@ -125,6 +129,26 @@ namespace {
                 cl::init(false),
 		cl::desc("Randomly swap the true and false states on a fork (default=off)"));
  
+  cl::opt<bool>
+  ExternalCallsCopyReachable("external-calls-copy-reachable",
+                             cl::init(false),
+                             cl::desc("Only copy the objects reachable from the pointer arguments of an external call to and from native memory, instead of every object.  Objects the callee reaches through globals are not copied.  (default=off)"));
+
+  cl::opt<bool>
+  NativeConcreteCalls("native-concrete-calls",
+                      cl::init(false),
+                      cl::desc("Run calls to module functions natively when their arguments and all the memory they can reach are concrete, and they only call other such functions or pure library functions.  Only functions whose memory accesses are to their own stack objects or globals at constant offsets, and whose divisors are nonzero constants, are run natively, but they are not otherwise checked for errors, and a call which does not return cannot be stopped by --max-time.  Instructions run natively are not counted or covered.  (default=off)"));
+
+  cl::opt<bool>
+  PureExternalsFastPath("pure-externals-fast-path",
+                        cl::init(false),
+                        cl::desc("Evaluate calls to pure math, ctype, and string functions with concrete arguments directly, without the external dispatcher.  (default=off)"));
+
+  cl::opt<bool>
+  IsolateExternalCalls("isolate-external-calls",
+                       cl::init(false),
+                       cl::desc("Run each external call in a forked child process, so that it cannot crash or corrupt KLEE.  Changes to the objects copied out for the call are sent back; any other effect of the call, such as files it opens or memory it allocates, is lost when the child exits.  (default=off)"));
+
   cl::opt<bool>
   AllowExternalSymCalls("allow-external-sym-calls",
                         cl::init(false),
@@ -171,6 +195,21 @@ namespace {
   cl::opt<bool>
   DebugCheckForImpliedValues("debug-check-for-implied-values");
 
+  cl::opt<bool>
+  UseConcolicModel("use-concolic-model",
+                   cl::init(false),
+                   cl::desc("Keep a satisfying assignment for each state and use it to decide one side of each branch without the solver (default=off)"));
+
+  cl::opt<bool>
+  UseAbstractDomain("use-abstract-domain",
+                    cl::init(false),
+                    cl::desc("Track intervals and known bits of symbolic bytes for each state and use them to decide branches and bounds checks without the solver (default=off)"));
+
+  cl::opt<bool>
+  UseResolutionCache("use-resolution-cache",
+                     cl::init(false),
+                     cl::desc("Remember which object each load and store to a symbolic address was shown to be in bounds of (default=off)"));
+
 
   cl::opt<bool>
   SimplifySymIndices("simplify-sym-indices",
@@ -186,6 +225,16 @@ namespace {
   MaxSymArraySize("max-sym-array-size",
                   cl::init(0));
 
+  cl::opt<bool>
+  SegmentedMemory("segmented-memory",
+                  cl::init(false),
+                  cl::desc("Access memory through pointers which may point to several objects without forking, using select expressions over the objects (default=off)"));
+
+  cl::opt<unsigned>
+  SegmentedMemoryMaxCandidates("segmented-memory-max-candidates",
+                               cl::init(8),
+                               cl::desc("Maximum number of objects a pointer may point to for --segmented-memory to be used (default=8)"));
+
   cl::opt<bool>
   SuppressExternalWarnings("suppress-external-warnings",
 			   cl::init(false),
@@ -226,6 +275,16 @@ namespace {
 	   cl::init(false),
            cl::desc("Stop execution after seeding is done without doing regular search (default=off)."));
  
+  cl::opt<bool>
+  SeedTriage("seed-triage",
+             cl::init(false),
+             cl::desc("Replay the seeds concretely before seeding, and keep only those which cover instructions no other kept seed covers, rarest coverage first. Triage runs the external calls of every seed, such as printf, one more time, and does not count towards the explored paths or --stop-after-n-instructions (default=off)."));
+ 
+  cl::opt<bool>
+  FastReplayPath("fast-replay-path",
+                 cl::init(false),
+                 cl::desc("When replaying a path, trust its branch decisions and in-bounds accesses without asking the solver; the path is only solved for its test case (default=off)."));
+ 
   cl::opt<bool>
   AllowSeedExtension("allow-seed-extension",
 		     cl::init(false),
@@ -266,6 +325,21 @@ namespace {
 		      cl::init(1.),
 		      cl::desc("(default=1.0)"));
 
+  cl::opt<bool>
+  ConcreteBlockFastPath("concrete-block-fast-path",
+                        cl::init(false),
+                        cl::desc("Run the rest of a basic block without timers, memory checks, or searcher updates between instructions, while their operands are concrete and no call is made (default=off)"));
+
+  cl::opt<bool>
+  PruneDuplicateStates("prune-duplicate-states",
+                       cl::init(false),
+                       cl::desc("Terminate states which return from a function equal to a state which returned there before (default=off)"));
+
+  cl::opt<unsigned>
+  MaxDuplicateSnapshots("max-duplicate-snapshots",
+                        cl::init(4096),
+                        cl::desc("Number of states remembered by --prune-duplicate-states (default=4096)"));
+
   cl::opt<double>
   MaxInstructionTime("max-instruction-time",
                      cl::desc("Only allow a single instruction to take this much time (default=0s (off)). Enables --use-forked-solver"),
@@ -276,6 +350,11 @@ namespace {
            cl::desc("Amount of time to dedicate to seeds, before normal search (default=0 (off))"),
            cl::init(0));
   
+  cl::opt<double>
+  SeedUnseededShare("seed-unseeded-share",
+                    cl::desc("Fraction of the instructions run while seeding which are given to states without seeds (default=0 (off))"),
+                    cl::init(0));
+
   cl::opt<unsigned int>
   StopAfterNInstructions("stop-after-n-instructions",
                          cl::desc("Stop execution after specified number of instructions (default=0 (off))"),
@@ -311,7 +390,8 @@ Executor::Executor(const InterpreterOptions &opts, InterpreterHandler *ih)
     : Interpreter(opts), kmodule(0), interpreterHandler(ih), searcher(0),
       externalDispatcher(new ExternalDispatcher()), statsTracker(0),
       pathWriter(0), symPathWriter(0), specialFunctionHandler(0),
-      processTree(0), replayKTest(0), replayPath(0), usingSeeds(0),
+      processTree(0), duplicateStateFilter(0), replayKTest(0), replayPath(0), usingSeeds(0),
+      triageCoverage(0),
       atMemoryLimit(false), inhibitForking(false), haltExecution(false),
       ivcEnabled(false),
       coreSolverTimeout(MaxCoreSolverTime != 0 && MaxInstructionTime != 0
@@ -319,6 +399,10 @@ Executor::Executor(const InterpreterOptions &opts, InterpreterHandler *ih)
                             : std::max(MaxCoreSolverTime, MaxInstructionTime)),
       debugInstFile(0), debugLogBuffer(debugBufferString) {
 
+  // With all of the steps going to unseeded states the seeds never run.
+  if (SeedUnseededShare < 0. || SeedUnseededShare >= 1.)
+    klee_error("--seed-unseeded-share must be at least 0 and below 1");
+
   if (coreSolverTimeout) UseForkedCoreSolver = true;
   Solver *coreSolver = klee::createCoreSolver(CoreSolverToUse);
   if (!coreSolver) {
@@ -335,6 +419,9 @@ Executor::Executor(const InterpreterOptions &opts, InterpreterHandler *ih)
   this->solver = new TimingSolver(solver, EqualitySubstitution);
   memory = new MemoryManager(&arrayCache);
 
+  if (PruneDuplicateStates)
+    duplicateStateFilter = new DuplicateStateFilter(MaxDuplicateSnapshots);
+
   if (optionIsSet(DebugPrintInstructions, FILE_ALL) ||
       optionIsSet(DebugPrintInstructions, FILE_COMPACT) ||
       optionIsSet(DebugPrintInstructions, FILE_SRC)) {
@@ -387,7 +474,9 @@ const Module *Executor::setModule(llvm::Module *module,
   kmodule->prepare(opts, interpreterHandler);
   specialFunctionHandler->bind();
 
-  if (StatsTracker::useStatistics() || userSearcherRequiresMD2U()) {
+  if (StatsTracker::useStatistics() || userSearcherRequiresMD2U() ||
+      userSearcherRequiresTargetDistances() ||
+      userSearcherWeightRefreshInterval() > 0) {
     statsTracker = 
       new StatsTracker(*this,
                        interpreterHandler->getOutputFilename("assembly.ll"),
@@ -398,6 +487,13 @@ const Module *Executor::setModule(llvm::Module *module,
 }
 
 Executor::~Executor() {
+  // Written once for all the runs, before the memory they report on goes.
+  if (statsTracker)
+    statsTracker->done();
+
+  // The remembered states hold on to memory objects.
+  if (duplicateStateFilter)
+    delete duplicateStateFilter;
   delete memory;
   delete externalDispatcher;
   if (processTree)
@@ -679,29 +775,38 @@ void Executor::branch(ExecutionState &state,
   // states if necessary due to OnlyReplaySeeds (inefficient but
   // simple).
   
-  std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
-    seedMap.find(&state);
-  if (it != seedMap.end()) {
-    std::vector<SeedInfo> seeds = it->second;
-    seedMap.erase(it);
+  if (seedMap.count(&state)) {
+    SeedMap::seeds_ty seeds;
+    seedMap.take(&state, seeds);
 
     // Assume each seed only satisfies one condition (necessarily true
     // when conditions are mutually exclusive and their conjunction is
     // a tautology).
-    for (std::vector<SeedInfo>::iterator siit = seeds.begin(), 
-           siie = seeds.end(); siit != siie; ++siit) {
-      unsigned i;
-      for (i=0; i<N; ++i) {
-        ref<ConstantExpr> res;
-        bool success = 
-          solver->getValue(state, siit->assignment.evaluate(conditions[i]), 
-                           res);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        if (res->isTrue())
-          break;
+    std::vector<unsigned> choice(seeds.size(), N);
+    SeedMap::seeds_ty remaining(seeds);
+    std::vector<unsigned> remainingIndex(seeds.size());
+    for (unsigned j=0; j<seeds.size(); ++j)
+      remainingIndex[j] = j;
+    for (unsigned i=0; i<N && !remaining.empty(); ++i) {
+      std::vector< ref<ConstantExpr> > values;
+      getSeedValues(state, remaining, conditions[i], values);
+
+      SeedMap::seeds_ty stillRemaining;
+      std::vector<unsigned> stillRemainingIndex;
+      for (unsigned j=0; j<remaining.size(); ++j) {
+        if (values[j]->isTrue()) {
+          choice[remainingIndex[j]] = i;
+        } else {
+          stillRemaining.push_back(remaining[j]);
+          stillRemainingIndex.push_back(remainingIndex[j]);
+        }
       }
-      
+      remaining.swap(stillRemaining);
+      remainingIndex.swap(stillRemainingIndex);
+    }
+
+    for (unsigned j=0; j<seeds.size(); ++j) {
+      unsigned i = choice[j];
       // If we didn't find a satisfying condition randomly pick one
       // (the seed will be patched).
       if (i==N)
@@ -709,7 +814,7 @@ void Executor::branch(ExecutionState &state,
 
       // Extra check in case we're replaying seeds with a max-fork
       if (result[i])
-        seedMap[result[i]].push_back(*siit);
+        seedMap.add(result[i], seeds[j]);
     }
 
     if (OnlyReplaySeeds) {
@@ -727,17 +832,39 @@ void Executor::branch(ExecutionState &state,
       addConstraint(*result[i], conditions[i]);
 }
 
+void Executor::getSeedValues(ExecutionState &state,
+                             const SeedMap::seeds_ty &seeds, ref<Expr> e,
+                             std::vector< ref<ConstantExpr> > &result) {
+  std::vector< ref<Expr> > values;
+  std::vector<unsigned> classes;
+  seedMap.evaluate(seeds, e, values, classes);
+
+  std::vector< ref<ConstantExpr> > constants(values.size());
+  for (unsigned i=0; i<values.size(); ++i) {
+    bool success = solver->getValue(state, values[i], constants[i]);
+    assert(success && "FIXME: Unhandled solver failure");
+    (void) success;
+  }
+
+  result.resize(seeds.size());
+  for (unsigned i=0; i<seeds.size(); ++i)
+    result[i] = constants[classes[i]];
+}
+
 Executor::StatePair 
 Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
   Solver::Validity res;
-  std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
-    seedMap.find(&current);
-  bool isSeeding = it != seedMap.end();
+  bool isSeeding = seedMap.count(&current);
+
+  if (FastReplayPath && replayPath && !isInternal && !isSeeding)
+    return forkReplayed(current, condition);
+  if (!isa<ConstantExpr>(condition) && !checkUncheckedConstraints(current))
+    return StatePair(0, 0);
 
   if (!isSeeding && !isa<ConstantExpr>(condition) && 
       (MaxStaticForkPct!=1. || MaxStaticSolvePct != 1. ||
        MaxStaticCPForkPct!=1. || MaxStaticCPSolvePct != 1.) &&
-      statsTracker->elapsed() > 60.) {
+      statsTracker && statsTracker->elapsed() > 60.) {
     StatisticManager &sm = *theStatisticManager;
     CallPathNode *cpn = current.stack.back().callPathNode;
     if ((MaxStaticForkPct<1. &&
@@ -763,10 +890,19 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
 
   double timeout = coreSolverTimeout;
   if (isSeeding)
-    timeout *= it->second.size();
-  solver->setTimeout(timeout);
-  bool success = solver->evaluate(current, condition, res);
-  solver->setTimeout(0);
+    timeout *= seedMap.getSeeds(&current).size();
+  bool useModel = UseConcolicModel && !isSeeding &&
+                  !interpreterOpts.MakeConcreteSymbolic;
+  bool modelSide = false;
+  Assignment flippedModel;
+  bool success = true;
+  if (!evaluateWithDomain(current, condition, res)) {
+    solver->setTimeout(timeout);
+    success = useModel ? evaluateWithModel(current, condition, res,
+                                           modelSide, flippedModel)
+                       : solver->evaluate(current, condition, res);
+    solver->setTimeout(0);
+  }
   if (!success) {
     current.pc = current.prevPC;
     terminateStateEarly(current, "Query timed out (fork).");
@@ -829,20 +965,14 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
       res == Solver::Unknown) {
     bool trueSeed=false, falseSeed=false;
     // Is seed extension still ok here?
-    for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
-           siie = it->second.end(); siit != siie; ++siit) {
-      ref<ConstantExpr> res;
-      bool success = 
-        solver->getValue(current, siit->assignment.evaluate(condition), res);
-      assert(success && "FIXME: Unhandled solver failure");
-      (void) success;
-      if (res->isTrue()) {
+    std::vector< ref<ConstantExpr> > values;
+    getSeedValues(current, seedMap.getSeeds(&current), condition, values);
+    for (unsigned i=0; i<values.size() && !(trueSeed && falseSeed); ++i) {
+      if (values[i]->isTrue()) {
         trueSeed = true;
       } else {
         falseSeed = true;
       }
-      if (trueSeed && falseSeed)
-        break;
     }
     if (!(trueSeed && falseSeed)) {
       assert(trueSeed || falseSeed);
@@ -888,34 +1018,27 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     if (RandomizeFork && theRNG.getBool())
       std::swap(trueState, falseState);
 
-    if (it != seedMap.end()) {
-      std::vector<SeedInfo> seeds = it->second;
-      it->second.clear();
-      std::vector<SeedInfo> &trueSeeds = seedMap[trueState];
-      std::vector<SeedInfo> &falseSeeds = seedMap[falseState];
-      for (std::vector<SeedInfo>::iterator siit = seeds.begin(), 
-             siie = seeds.end(); siit != siie; ++siit) {
-        ref<ConstantExpr> res;
-        bool success = 
-          solver->getValue(current, siit->assignment.evaluate(condition), res);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        if (res->isTrue()) {
-          trueSeeds.push_back(*siit);
-        } else {
-          falseSeeds.push_back(*siit);
-        }
-      }
+    // The current model only satisfies one side of the branch, the
+    // state taking the other side gets the solver's counterexample.
+    if (useModel && res==Solver::Unknown) {
+      ExecutionState *flipped = modelSide ? falseState : trueState;
+      flipped->concolicModel = flippedModel;
+      flipped->concolicModelValid = true;
+    }
+
+    if (isSeeding) {
+      SeedMap::seeds_ty seeds;
+      seedMap.take(&current, seeds);
+      std::vector< ref<ConstantExpr> > values;
+      getSeedValues(current, seeds, condition, values);
+      for (unsigned i=0; i<seeds.size(); ++i)
+        seedMap.add(values[i]->isTrue() ? trueState : falseState, seeds[i]);
       
       bool swapInfo = false;
-      if (trueSeeds.empty()) {
-        if (&current == trueState) swapInfo = true;
-        seedMap.erase(trueState);
-      }
-      if (falseSeeds.empty()) {
-        if (&current == falseState) swapInfo = true;
-        seedMap.erase(falseState);
-      }
+      if (!seedMap.count(trueState) && &current == trueState)
+        swapInfo = true;
+      if (!seedMap.count(falseState) && &current == falseState)
+        swapInfo = true;
       if (swapInfo) {
         std::swap(trueState->coveredNew, falseState->coveredNew);
         std::swap(trueState->coveredLines, falseState->coveredLines);
@@ -955,6 +1078,130 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
   }
 }
 
+Executor::StatePair
+Executor::forkReplayed(ExecutionState &current, ref<Expr> condition) {
+  if (replayPosition >= replayPath->size()) {
+    current.pc = current.prevPC;
+    terminateStateEarly(current, "ran out of branches in replay path.");
+    return StatePair(0, 0);
+  }
+  bool branch = (*replayPath)[replayPosition++];
+
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(condition)) {
+    if (CE->isTrue() != branch) {
+      current.pc = current.prevPC;
+      terminateStateEarly(current, "replay path diverged.");
+      return StatePair(0, 0);
+    }
+  } else {
+    // Whether the path is feasible is only found out when its test case
+    // is generated, or by the next query which needs a solution.
+    addConstraint(current, branch ? condition : Expr::createIsZero(condition));
+    current.uncheckedConstraints = true;
+    ++stats::replayedBranches;
+    if (symPathWriter)
+      current.symPathOS << (branch ? "1" : "0");
+  }
+
+  if (pathWriter)
+    current.pathOS << (branch ? "1" : "0");
+
+  return branch ? StatePair(&current, 0) : StatePair(0, &current);
+}
+
+bool Executor::checkUncheckedConstraints(ExecutionState &state) {
+  if (!state.uncheckedConstraints)
+    return true;
+
+  // Queries for a solution assume the constraints can be satisfied.
+  std::vector<const Array*> objects;
+  std::vector< std::vector<unsigned char> > values;
+  bool hasSolution;
+  solver->setTimeout(coreSolverTimeout);
+  bool success = solver->getModel(state, ConstantExpr::alloc(1, Expr::Bool),
+                                  objects, values, hasSolution);
+  solver->setTimeout(0);
+  if (!success) {
+    state.pc = state.prevPC;
+    terminateStateEarly(state, "Query timed out (replay path).");
+    return false;
+  }
+  if (!hasSolution) {
+    state.pc = state.prevPC;
+    terminateStateEarly(state, "replay path diverged.");
+    return false;
+  }
+
+  state.uncheckedConstraints = false;
+  return true;
+}
+
+bool Executor::evaluateWithDomain(const ExecutionState &state,
+                                  ref<Expr> condition,
+                                  Solver::Validity &result) {
+  if (!state.useAbstractDomain || isa<ConstantExpr>(condition))
+    return false;
+
+  AbstractValue value = state.abstractDomain.evaluate(condition);
+  if (value.mustBeTrue()) {
+    result = Solver::True;
+  } else if (value.mustBeFalse()) {
+    result = Solver::False;
+  } else {
+    return false;
+  }
+  ++stats::abstractDomainPrunedQueries;
+  return true;
+}
+
+bool Executor::evaluateWithModel(ExecutionState &state, ref<Expr> condition,
+                                 Solver::Validity &result, bool &modelSide,
+                                 Assignment &flipped) {
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(condition)) {
+    result = CE->isTrue() ? Solver::True : Solver::False;
+    return true;
+  }
+
+  std::vector<const Array*> objects;
+  for (unsigned i = 0; i != state.symbolics.size(); ++i)
+    objects.push_back(state.symbolics[i].second);
+
+  std::vector< std::vector<unsigned char> > values;
+  bool hasSolution;
+
+  // Lazily recompute a model which was invalidated by a constraint it
+  // does not satisfy.
+  if (!state.concolicModelValid) {
+    if (!solver->getModel(state, ConstantExpr::alloc(1, Expr::Bool), objects,
+                          values, hasSolution))
+      return false;
+    if (!hasSolution)
+      return solver->evaluate(state, condition, result);
+    state.concolicModel = Assignment(objects, values);
+    state.concolicModelValid = true;
+    values.clear();
+  }
+
+  ref<Expr> value = state.concolicModel.evaluate(condition);
+  if (!isa<ConstantExpr>(value))
+    return solver->evaluate(state, condition, result);
+
+  // The model witnesses modelSide, only the other side needs a query.
+  ++stats::concolicModelHits;
+  modelSide = cast<ConstantExpr>(value)->isTrue();
+  ref<Expr> other = modelSide ? Expr::createIsZero(condition) : condition;
+  if (!solver->getModel(state, other, objects, values, hasSolution))
+    return false;
+
+  if (hasSolution) {
+    result = Solver::Unknown;
+    flipped = Assignment(objects, values);
+  } else {
+    result = modelSide ? Solver::True : Solver::False;
+  }
+  return true;
+}
+
 void Executor::addConstraint(ExecutionState &state, ref<Expr> condition) {
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(condition)) {
     if (!CE->isTrue())
@@ -963,19 +1210,25 @@ void Executor::addConstraint(ExecutionState &state, ref<Expr> condition) {
   }
 
   // Check to see if this constraint violates seeds.
-  std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
-    seedMap.find(&state);
-  if (it != seedMap.end()) {
-    bool warn = false;
-    for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
-           siie = it->second.end(); siit != siie; ++siit) {
+  if (seedMap.count(&state)) {
+    const SeedMap::seeds_ty &seeds = seedMap.getSeeds(&state);
+    std::vector< ref<Expr> > values;
+    std::vector<unsigned> classes;
+    seedMap.evaluate(seeds, condition, values, classes);
+
+    std::vector<bool> violated(values.size());
+    for (unsigned i=0; i<values.size(); ++i) {
       bool res;
-      bool success = 
-        solver->mustBeFalse(state, siit->assignment.evaluate(condition), res);
+      bool success = solver->mustBeFalse(state, values[i], res);
       assert(success && "FIXME: Unhandled solver failure");
       (void) success;
-      if (res) {
-        siit->patchSeed(state, condition, solver);
+      violated[i] = res;
+    }
+
+    bool warn = false;
+    for (unsigned i=0; i<seeds.size(); ++i) {
+      if (violated[classes[i]]) {
+        seedMap.getSeed(seeds[i]).patchSeed(state, condition, solver);
         warn = true;
       }
     }
@@ -1134,25 +1387,18 @@ void Executor::executeGetValue(ExecutionState &state,
                                ref<Expr> e,
                                KInstruction *target) {
   e = state.constraints.simplifyExpr(e);
-  std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
-    seedMap.find(&state);
-  if (it==seedMap.end() || isa<ConstantExpr>(e)) {
+  if (!isa<ConstantExpr>(e) && !checkUncheckedConstraints(state))
+    return;
+  if (!seedMap.count(&state) || isa<ConstantExpr>(e)) {
     ref<ConstantExpr> value;
     bool success = solver->getValue(state, e, value);
     assert(success && "FIXME: Unhandled solver failure");
     (void) success;
     bindLocal(target, state, value);
   } else {
-    std::set< ref<Expr> > values;
-    for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
-           siie = it->second.end(); siit != siie; ++siit) {
-      ref<ConstantExpr> value;
-      bool success = 
-        solver->getValue(state, siit->assignment.evaluate(e), value);
-      assert(success && "FIXME: Unhandled solver failure");
-      (void) success;
-      values.insert(value);
-    }
+    std::vector< ref<ConstantExpr> > seedValues;
+    getSeedValues(state, seedMap.getSeeds(&state), e, seedValues);
+    std::set< ref<Expr> > values(seedValues.begin(), seedValues.end());
     
     std::vector< ref<Expr> > conditions;
     for (std::set< ref<Expr> >::iterator vit = values.begin(), 
@@ -1210,15 +1456,47 @@ void Executor::stepInstruction(ExecutionState &state) {
   printDebugInstructions(state);
   if (statsTracker)
     statsTracker->stepInstruction(state);
-
-  ++stats::instructions;
   state.prevPC = state.pc;
   ++state.pc;
 
+  // Triage replays are not part of the exploration, so they only record
+  // coverage.
+  if (triageCoverage) {
+    (*triageCoverage)[state.prevPC->info->id] = true;
+    return;
+  }
+
+  ++stats::instructions;
   if (stats::instructions==StopAfterNInstructions)
     haltExecution = true;
 }
 
+bool Executor::canRunConcretely(ExecutionState &state,
+                                llvm::BasicBlock *bb) const {
+  if (haltExecution || !addedStates.empty() || !removedStates.empty())
+    return false;
+
+  KInstruction *ki = state.pc;
+  Instruction *i = ki->inst;
+  // Block terminators go through the bookkeeping, so that a loop whose body
+  // is a single block still runs the timers on every iteration.
+  if (i->getParent() != bb || isa<CallInst>(i) || isa<InvokeInst>(i) ||
+      isa<TerminatorInst>(i))
+    return false;
+
+  StackFrame &sf = state.stack.back();
+  for (unsigned j = 0, e = i->getNumOperands(); j != e; ++j) {
+    // Operands which are constants, or not values, are always concrete.
+    int vnumber = ki->operands[j];
+    if (vnumber >= 0) {
+      const ref<Expr> &value = sf.locals[vnumber].value;
+      if (value.isNull() || !isa<ConstantExpr>(value))
+        return false;
+    }
+  }
+  return true;
+}
+
 void Executor::executeCall(ExecutionState &state, 
                            KInstruction *ki,
                            Function *f,
@@ -1288,6 +1566,9 @@ void Executor::executeCall(ExecutionState &state,
     if (InvokeInst *ii = dyn_cast<InvokeInst>(i))
       transferToBasicBlock(ii->getNormalDest(), i->getParent(), state);
   } else {
+    if (NativeConcreteCalls && callNative(state, ki, f, arguments))
+      return;
+
     // FIXME: I'm not really happy about this reliance on prevPC but it is ok, I
     // guess. This just done to avoid having to pass KInstIterator everywhere
     // instead of the actual instruction, since we can't make a KInstIterator
@@ -1547,8 +1828,18 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         // undeclared functions.
         if (!caller->use_empty()) {
           terminateStateOnExecError(state, "return void when caller expected a result");
+          break;
         }
       }
+
+      // A state equal to one which already returned here has nothing left
+      // to explore that the other state will not. Seeded states are kept,
+      // as they may follow their seeds where the other state does not.
+      if (duplicateStateFilter && !seedMap.count(&state) &&
+          duplicateStateFilter->isDuplicate(state)) {
+        ++stats::duplicateStatesPruned;
+        terminateState(state);
+      }
     }      
     break;
   }
@@ -1605,6 +1896,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     ref<Expr> cond = eval(ki, 0, state).value;
     BasicBlock *bb = si->getParent();
 
+    if (!isa<ConstantExpr>(cond) && !checkUncheckedConstraints(state))
+      break;
     cond = toUnique(state, cond);
     if (ConstantExpr *CE = dyn_cast<ConstantExpr>(cond)) {
       // Somewhat gross to create these all the time, but fine till we
@@ -2525,20 +2818,18 @@ void Executor::updateStates(ExecutionState *current) {
     searcher->update(current, addedStates, removedStates);
   }
   
-  states.insert(addedStates.begin(), addedStates.end());
+  for (std::vector<ExecutionState *>::iterator it = addedStates.begin(),
+                                               ie = addedStates.end();
+       it != ie; ++it)
+    states.insert(*it);
   addedStates.clear();
 
   for (std::vector<ExecutionState *>::iterator it = removedStates.begin(),
                                                ie = removedStates.end();
        it != ie; ++it) {
     ExecutionState *es = *it;
-    std::set<ExecutionState*>::iterator it2 = states.find(es);
-    assert(it2!=states.end());
-    states.erase(it2);
-    std::map<ExecutionState*, std::vector<SeedInfo> >::iterator it3 = 
-      seedMap.find(es);
-    if (it3 != seedMap.end())
-      seedMap.erase(it3);
+    states.erase(es);
+    seedMap.erase(es);
     processTree->remove(es->ptreeNode);
     delete es;
   }
@@ -2600,6 +2891,9 @@ void Executor::bindModuleConstants() {
       bindInstructionConstants(kf->instructions[i]);
   }
 
+  // The constants include the addresses of globals, which differ between
+  // runs.
+  delete[] kmodule->constantTable;
   kmodule->constantTable = new Cell[kmodule->constants.size()];
   for (unsigned i=0; i<kmodule->constants.size(); ++i) {
     Cell &c = kmodule->constantTable[i];
@@ -2623,16 +2917,17 @@ void Executor::checkMemoryUsage() {
         unsigned numStates = states.size();
         unsigned toKill = std::max(1U, numStates - numStates * MaxMemory / mbs);
         klee_warning("killing %d states (over memory cap)", toKill);
-        std::vector<ExecutionState *> arr(states.begin(), states.end());
-        for (unsigned i = 0, N = arr.size(); N && i < toKill; ++i, --N) {
+        // Victims are moved to the end of the registry, which stays put
+        // until they are removed by updateStates().
+        for (unsigned i = 0, N = states.size(); N && i < toKill; ++i, --N) {
           unsigned idx = rand() % N;
           // Make two pulls to try and not hit a state that
           // covered new code.
-          if (arr[idx]->coveredNew)
+          if (states[idx]->coveredNew)
             idx = rand() % N;
 
-          std::swap(arr[idx], arr[N - 1]);
-          terminateStateEarly(*arr[N - 1], "Memory limit exceeded.");
+          states.swap(idx, N - 1);
+          terminateStateEarly(*states[N - 1], "Memory limit exceeded.");
         }
       }
       atMemoryLimit = true;
@@ -2646,8 +2941,7 @@ void Executor::doDumpStates() {
   if (!DumpStatesOnHalt || states.empty())
     return;
   klee_message("halting execution, dumping remaining states");
-  for (std::set<ExecutionState *>::iterator it = states.begin(),
-                                            ie = states.end();
+  for (StateRegistry::iterator it = states.begin(), ie = states.end();
        it != ie; ++it) {
     ExecutionState &state = **it;
     stepInstruction(state); // keep stats rolling
@@ -2665,44 +2959,63 @@ void Executor::run(ExecutionState &initialState) {
 
   states.insert(&initialState);
 
+  if (triageCoverage) {
+    // A seed is being replayed concretely, so there is nothing to search.
+    while (!states.empty() && !haltExecution) {
+      ExecutionState &state = *states[0];
+      KInstruction *ki = state.pc;
+      stepInstruction(state);
+      executeInstruction(state, ki);
+      processTimers(&state, MaxInstructionTime);
+      updateStates(&state);
+    }
+    doDumpStates();
+    return;
+  }
+
   if (usingSeeds) {
-    std::vector<SeedInfo> &v = seedMap[&initialState];
-    
     for (std::vector<KTest*>::const_iterator it = usingSeeds->begin(), 
            ie = usingSeeds->end(); it != ie; ++it)
-      v.push_back(SeedInfo(*it));
+      seedMap.add(&initialState, seedMap.addSeed(*it));
 
     int lastNumSeeds = usingSeeds->size()+10;
     double lastTime, startTime = lastTime = util::getWallTime();
-    ExecutionState *lastState = 0;
+    // Unseeded states are run round-robin for their share of the steps.
+    uint64_t seededSteps = 0, unseededSteps = 0;
+    unsigned nextUnseeded = 0;
     while (!seedMap.empty()) {
       if (haltExecution) {
         doDumpStates();
         return;
       }
 
-      std::map<ExecutionState*, std::vector<SeedInfo> >::iterator it = 
-        seedMap.upper_bound(lastState);
-      if (it == seedMap.end())
-        it = seedMap.begin();
-      lastState = it->first;
-      unsigned numSeeds = it->second.size();
-      ExecutionState &state = *lastState;
+      ExecutionState *es;
+      unsigned numSeeds = 1;
+      if (SeedUnseededShare > 0. && states.size() > seedMap.getNumStates() &&
+          unseededSteps < SeedUnseededShare * (seededSteps + unseededSteps)) {
+        do {
+          if (nextUnseeded >= states.size())
+            nextUnseeded = 0;
+          es = states[nextUnseeded++];
+        } while (seedMap.count(es));
+        ++unseededSteps;
+      } else {
+        es = seedMap.selectState();
+        numSeeds = seedMap.getSeeds(es).size();
+        ++seededSteps;
+      }
+      ExecutionState &state = *es;
       KInstruction *ki = state.pc;
       stepInstruction(state);
 
       executeInstruction(state, ki);
       processTimers(&state, MaxInstructionTime * numSeeds);
+      seedMap.stepped(&state);
       updateStates(&state);
 
       if ((stats::instructions % 1000) == 0) {
-        int numSeeds = 0, numStates = 0;
-        for (std::map<ExecutionState*, std::vector<SeedInfo> >::iterator
-               it = seedMap.begin(), ie = seedMap.end();
-             it != ie; ++it) {
-          numSeeds += it->second.size();
-          numStates++;
-        }
+        int numSeeds = seedMap.getNumSeeds();
+        int numStates = seedMap.getNumStates();
         double time = util::getWallTime();
         if (SeedTime>0. && time > startTime + SeedTime) {
           klee_warning("seed time expired, %d seeds remain over %d states",
@@ -2722,8 +3035,7 @@ void Executor::run(ExecutionState &initialState) {
 
     // XXX total hack, just because I like non uniform better but want
     // seed results to be equally weighted.
-    for (std::set<ExecutionState*>::iterator
-           it = states.begin(), ie = states.end();
+    for (StateRegistry::iterator it = states.begin(), ie = states.end();
          it != ie; ++it) {
       (*it)->weight = 1.;
     }
@@ -2745,6 +3057,19 @@ void Executor::run(ExecutionState &initialState) {
     stepInstruction(state);
 
     executeInstruction(state, ki);
+
+    // The bookkeeping below is only needed once for a run of concrete
+    // instructions through the rest of the block.
+    if (ConcreteBlockFastPath) {
+      llvm::BasicBlock *bb = ki->inst->getParent();
+      while (canRunConcretely(state, bb)) {
+        ki = state.pc;
+        stepInstruction(state);
+        executeInstruction(state, ki);
+        ++stats::concreteFastPathInstructions;
+      }
+    }
+
     processTimers(&state, MaxInstructionTime);
 
     checkMemoryUsage();
@@ -2814,7 +3139,8 @@ void Executor::terminateState(ExecutionState &state) {
                       "replay did not consume all objects in test input.");
   }
 
-  interpreterHandler->incPathsExplored();
+  if (!triageCoverage)
+    interpreterHandler->incPathsExplored();
 
   std::vector<ExecutionState *>::iterator it =
       std::find(addedStates.begin(), addedStates.end(), &state);
@@ -2824,10 +3150,7 @@ void Executor::terminateState(ExecutionState &state) {
     removedStates.push_back(&state);
   } else {
     // never reached searcher, just delete immediately
-    std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it3 = 
-      seedMap.find(&state);
-    if (it3 != seedMap.end())
-      seedMap.erase(it3);
+    seedMap.erase(&state);
     addedStates.erase(it);
     processTree->remove(state.ptreeNode);
     delete &state;
@@ -2836,6 +3159,10 @@ void Executor::terminateState(ExecutionState &state) {
 
 void Executor::terminateStateEarly(ExecutionState &state, 
                                    const Twine &message) {
+  if (triageCoverage) {
+    terminateState(state);
+    return;
+  }
   if (!OnlyOutputStatesCoveringNew || state.coveredNew ||
       (AlwaysOutputSeeds && seedMap.count(&state)))
     interpreterHandler->processTestCase(state, (message + "\n").str().c_str(),
@@ -2844,6 +3171,10 @@ void Executor::terminateStateEarly(ExecutionState &state,
 }
 
 void Executor::terminateStateOnExit(ExecutionState &state) {
+  if (triageCoverage) {
+    terminateState(state);
+    return;
+  }
   if (!OnlyOutputStatesCoveringNew || state.coveredNew || 
       (AlwaysOutputSeeds && seedMap.count(&state)))
     interpreterHandler->processTestCase(state, 0, 0);
@@ -2896,8 +3227,12 @@ void Executor::terminateStateOnError(ExecutionState &state,
                                      const llvm::Twine &messaget,
                                      const char *suffix,
                                      const llvm::Twine &info) {
+  if (triageCoverage) {
+    terminateState(state);
+    return;
+  }
+
   std::string message = messaget.str();
-  static std::set< std::pair<Instruction*, std::string> > emittedErrors;
   Instruction * lastInst;
   const InstructionInfo &ii = getLastNonKleeInternalInstruction(state, &lastInst);
   
@@ -2941,10 +3276,246 @@ static std::set<std::string> okExternals(okExternalsList,
                                          okExternalsList + 
                                          (sizeof(okExternalsList)/sizeof(okExternalsList[0])));
 
+/// Add the global variables used by \a c to \a globals, or return false
+/// if it uses a function or alias, whose addresses in KLEE are not native
+/// addresses.
+static bool addNativeGlobals(Constant *c,
+                             std::set<const GlobalVariable*> &globals) {
+  if (GlobalVariable *gv = dyn_cast<GlobalVariable>(c)) {
+    globals.insert(gv);
+    return true;
+  }
+  if (isa<GlobalValue>(c))
+    return false;
+  for (unsigned i = 0, e = c->getNumOperands(); i != e; ++i)
+    if (!addNativeGlobals(cast<Constant>(c->getOperand(i)), globals))
+      return false;
+  return true;
+}
+
+/// Return true if \a ptr is the address of an alloca or a global variable,
+/// at a constant in-bounds offset, so that accessing it natively cannot
+/// touch memory outside the object.
+static bool isDirectNativeAddress(Value *ptr) {
+  ptr = ptr->stripPointerCasts();
+  if (GEPOperator *gep = dyn_cast<GEPOperator>(ptr))
+    return gep->isInBounds() && gep->hasAllConstantIndices() &&
+      isDirectNativeAddress(gep->getPointerOperand());
+  return isa<AllocaInst>(ptr) || isa<GlobalVariable>(ptr);
+}
+
+/// Return the number of bytes from \a ptr, a direct native address, to the
+/// end of the object it points into.
+static int64_t getDirectNativeExtent(Value *ptr, KModule *kmodule) {
+  ptr = ptr->stripPointerCasts();
+  if (GEPOperator *gep = dyn_cast<GEPOperator>(ptr)) {
+    SmallVector<Value*, 4> indices(gep->idx_begin(), gep->idx_end());
+    int64_t offset = kmodule->targetData->getIndexedOffset(
+      gep->getPointerOperandType(), indices);
+    return getDirectNativeExtent(gep->getPointerOperand(), kmodule) - offset;
+  }
+  if (AllocaInst *ai = dyn_cast<AllocaInst>(ptr)) {
+    ConstantInt *count = dyn_cast<ConstantInt>(ai->getArraySize());
+    if (!count)
+      return 0;
+    return kmodule->targetData->getTypeAllocSize(ai->getAllocatedType()) *
+      count->getZExtValue();
+  }
+  GlobalVariable *gv = cast<GlobalVariable>(ptr);
+  return kmodule->targetData->getTypeAllocSize(gv->getType()->getElementType());
+}
+
+/// Return true if \a i accesses memory or divides in a way that could
+/// fault, or go unchecked, when run natively.
+static bool isUncheckedNatively(Instruction *i, KModule *kmodule) {
+  switch (i->getOpcode()) {
+  case Instruction::Load:
+    return !isDirectNativeAddress(cast<LoadInst>(i)->getPointerOperand());
+  case Instruction::Store:
+    return !isDirectNativeAddress(cast<StoreInst>(i)->getPointerOperand());
+  case Instruction::UDiv:
+  case Instruction::SDiv:
+  case Instruction::URem:
+  case Instruction::SRem: {
+    ConstantInt *divisor = dyn_cast<ConstantInt>(i->getOperand(1));
+    return !divisor || divisor->isZero() ||
+      (divisor->isAllOnesValue() && i->getOpcode() != Instruction::UDiv &&
+       i->getOpcode() != Instruction::URem);
+  }
+  case Instruction::Call: {
+    // Library functions may access memory through any pointer they are
+    // passed. Memory intrinsics access as many bytes as their length says,
+    // which must be known to fit in the objects they are given.
+    CallInst *ci = cast<CallInst>(i);
+    MemIntrinsic *mi = dyn_cast<MemIntrinsic>(ci);
+    ConstantInt *length = mi ? dyn_cast<ConstantInt>(mi->getLength()) : 0;
+    if (mi && !length)
+      return true;
+    for (unsigned k = 0, e = ci->getNumArgOperands(); k != e; ++k) {
+      Value *arg = ci->getArgOperand(k);
+      if (!arg->getType()->isPointerTy())
+        continue;
+      if (!isDirectNativeAddress(arg))
+        return true;
+      if (length && getDirectNativeExtent(arg, kmodule) <
+                      (int64_t) length->getZExtValue())
+        return true;
+    }
+    return false;
+  }
+  default:
+    return isa<AtomicRMWInst>(i) || isa<AtomicCmpXchgInst>(i);
+  }
+}
+
+const Executor::NativeCallInfo &Executor::getNativeCallInfo(Function *f) {
+  std::map<const Function*, NativeCallInfo>::iterator it =
+    nativeCallInfo.find(f);
+  if (it != nativeCallInfo.end())
+    return it->second;
+
+  NativeCallInfo &info = nativeCallInfo[f];
+  info.callable = true;
+  std::set<Function*> visited;
+  std::vector<Function*> worklist(1, f);
+  while (info.callable && !worklist.empty()) {
+    Function *g = worklist.back();
+    worklist.pop_back();
+    if (!visited.insert(g).second)
+      continue;
+
+    // Declarations are only called natively if they are pure library
+    // functions, or intrinsics other than the variadic ones the interpreter
+    // implements itself.
+    if (g->isDeclaration()) {
+      switch (g->getIntrinsicID()) {
+      case Intrinsic::not_intrinsic:
+        info.callable = PureExternals::isPure(g->getName().str());
+        break;
+      case Intrinsic::vastart:
+      case Intrinsic::vaend:
+      case Intrinsic::vacopy:
+        info.callable = false;
+        break;
+      default:
+        break;
+      }
+      continue;
+    }
+
+    if (g->isVarArg()) {
+      info.callable = false;
+      break;
+    }
+
+    for (Function::iterator bb = g->begin(), be = g->end();
+         info.callable && bb != be; ++bb) {
+      for (BasicBlock::iterator ii = bb->begin(), ie = bb->end();
+           info.callable && ii != ie; ++ii) {
+        // Only direct calls: function pointers are not native addresses.
+        unsigned numOperands = ii->getNumOperands();
+        if (isa<InvokeInst>(ii) || isUncheckedNatively(ii, kmodule)) {
+          info.callable = false;
+        } else if (CallInst *ci = dyn_cast<CallInst>(ii)) {
+          if (Function *callee = dyn_cast<Function>(ci->getCalledValue())) {
+            worklist.push_back(callee);
+            --numOperands; // the callee is the last operand
+          } else {
+            info.callable = false;
+          }
+        }
+        for (unsigned k = 0; info.callable && k != numOperands; ++k)
+          if (Constant *c = dyn_cast<Constant>(ii->getOperand(k)))
+            info.callable = addNativeGlobals(c, info.globals);
+      }
+    }
+  }
+
+  if (!info.callable)
+    info.globals.clear();
+  return info;
+}
+
+bool Executor::callNative(ExecutionState &state, KInstruction *ki, Function *f,
+                          std::vector< ref<Expr> > &arguments) {
+  if (!isa<CallInst>(ki->inst) || f->isVarArg() ||
+      arguments.size() != f->arg_size())
+    return false;
+
+  const NativeCallInfo &info = getNativeCallInfo(f);
+  if (!info.callable)
+    return false;
+
+  // The arguments are passed as callExternalFunction passes them, and must
+  // all be constant.
+  uint64_t *args = (uint64_t*) alloca(2*sizeof(*args) * (arguments.size() + 1));
+  memset(args, 0, 2 * sizeof(*args) * (arguments.size() + 1));
+  unsigned wordIndex = 2;
+  std::vector<uint64_t> roots;
+  Expr::Width pointerWidth = Context::get().getPointerWidth();
+  for (std::vector<ref<Expr> >::iterator ai = arguments.begin(),
+         ae = arguments.end(); ai != ae; ++ai) {
+    ConstantExpr *ce = dyn_cast<ConstantExpr>(*ai);
+    if (!ce || ce->getWidth() > Expr::Int64)
+      return false;
+    ce->toMemory(&args[wordIndex]);
+    wordIndex += (ce->getWidth()+63)/64;
+    if (ce->getWidth() == pointerWidth)
+      roots.push_back(ce->getZExtValue());
+  }
+
+  ExternalDispatcher::GlobalAddresses globals;
+  for (std::set<const GlobalVariable*>::const_iterator it = info.globals.begin(),
+         ie = info.globals.end(); it != ie; ++it) {
+    uint64_t address = globalAddresses.find(*it)->second->getZExtValue();
+    globals[*it] = (void*) (unsigned long) address;
+    roots.push_back(address);
+  }
+
+  // Fall back to interpreting the call if any byte it can reach is
+  // symbolic.
+  std::vector<const MemoryObject*> objects;
+  state.addressSpace.getReachableObjects(roots, objects);
+  for (std::vector<const MemoryObject*>::iterator it = objects.begin(),
+         ie = objects.end(); it != ie; ++it) {
+    if (!state.addressSpace.findObject(*it)->isAllConcrete()) {
+      ++stats::nativeCallBailouts;
+      return false;
+    }
+  }
+
+  state.addressSpace.copyOutConcretes(objects);
+  if (!externalDispatcher->executeNative(f, ki->inst, args, globals)) {
+    // Nothing was copied back, so the interpreter can run the call again
+    // and report what went wrong.
+    ++stats::nativeCallBailouts;
+    return false;
+  }
+
+  if (!state.addressSpace.copyInConcretes(objects)) {
+    terminateStateOnError(state, "native call modified read-only object",
+                          "external.err");
+    return true;
+  }
+
+  ++stats::nativeCalls;
+  LLVM_TYPE_Q Type *resultType = ki->inst->getType();
+  if (resultType != Type::getVoidTy(getGlobalContext())) {
+    ref<Expr> e = ConstantExpr::fromMemory((void*) args,
+                                           getWidthForLLVMType(resultType));
+    bindLocal(ki, state, e);
+  }
+  return true;
+}
+
 void Executor::callExternalFunction(ExecutionState &state,
                                     KInstruction *target,
                                     Function *function,
                                     std::vector< ref<Expr> > &arguments) {
+  // Special and external functions may concretize their arguments.
+  if (!checkUncheckedConstraints(state))
+    return;
+
   // check if specialFunctionHandler wants it
   if (specialFunctionHandler->handle(state, function, target, arguments))
     return;
@@ -2956,6 +3527,18 @@ void Executor::callExternalFunction(ExecutionState &state,
     return;
   }
 
+  // The call site must use the result as the function returns it, which
+  // is not the case if the function was called through a bitcast.
+  ref<Expr> result;
+  LLVM_TYPE_Q Type *resultType = target->inst->getType();
+  if (PureExternalsFastPath &&
+      resultType == function->getFunctionType()->getReturnType() &&
+      PureExternals::evaluate(state, function, arguments, result)) {
+    ++stats::externalCallsFastPath;
+    bindLocal(target, state, result);
+    return;
+  }
+
   // normal external function handling path
   // allocate 128 bits for each argument (+return value) to support fp80's;
   // we could iterate through all the arguments first and determine the exact
@@ -2963,6 +3546,10 @@ void Executor::callExternalFunction(ExecutionState &state,
   uint64_t *args = (uint64_t*) alloca(2*sizeof(*args) * (arguments.size() + 1));
   memset(args, 0, 2 * sizeof(*args) * (arguments.size() + 1));
   unsigned wordIndex = 2;
+  // Values of the pointer-sized arguments, which may point to the objects
+  // the call touches.
+  std::vector<uint64_t> pointerArgs;
+  Expr::Width pointerWidth = Context::get().getPointerWidth();
   for (std::vector<ref<Expr> >::iterator ai = arguments.begin(), 
        ae = arguments.end(); ai!=ae; ++ai) {
     if (AllowExternalSymCalls) { // don't bother checking uniqueness
@@ -2972,12 +3559,16 @@ void Executor::callExternalFunction(ExecutionState &state,
       (void) success;
       ce->toMemory(&args[wordIndex]);
       wordIndex += (ce->getWidth()+63)/64;
+      if (ce->getWidth() == pointerWidth)
+        pointerArgs.push_back(ce->getZExtValue());
     } else {
       ref<Expr> arg = toUnique(state, *ai);
       if (ConstantExpr *ce = dyn_cast<ConstantExpr>(arg)) {
         // XXX kick toMemory functions from here
         ce->toMemory(&args[wordIndex]);
         wordIndex += (ce->getWidth()+63)/64;
+        if (ce->getWidth() == pointerWidth)
+          pointerArgs.push_back(ce->getZExtValue());
       } else {
         terminateStateOnExecError(state, 
                                   "external call with symbolic argument: " + 
@@ -2987,7 +3578,12 @@ void Executor::callExternalFunction(ExecutionState &state,
     }
   }
 
-  state.addressSpace.copyOutConcretes();
+  std::vector<const MemoryObject*> copied;
+  if (ExternalCallsCopyReachable) {
+    state.addressSpace.getReachableObjects(pointerArgs, copied);
+    state.addressSpace.copyOutConcretes(copied);
+  } else
+    state.addressSpace.copyOutConcretes();
 
   if (!SuppressExternalWarnings) {
 
@@ -3007,20 +3603,43 @@ void Executor::callExternalFunction(ExecutionState &state,
       klee_warning_once(function, "%s", os.str().c_str());
   }
   
-  bool success = externalDispatcher->executeCall(function, target->inst, args);
+  // The memory an isolated call may change and send back: the objects
+  // copied in after it.
+  ExternalDispatcher::MemoryRegions regions;
+  if (IsolateExternalCalls) {
+    std::vector<const MemoryObject*> objects;
+    if (ExternalCallsCopyReachable) {
+      objects = copied;
+    } else {
+      for (MemoryMap::iterator it = state.addressSpace.objects.begin(),
+             ie = state.addressSpace.objects.end(); it != ie; ++it)
+        objects.push_back(it->first);
+    }
+    for (std::vector<const MemoryObject*>::iterator it = objects.begin(),
+           ie = objects.end(); it != ie; ++it) {
+      const MemoryObject *mo = *it;
+      if (!mo->isUserSpecified)
+        regions.push_back(std::make_pair((uint8_t*) (unsigned long) mo->address,
+                                         (size_t) mo->size));
+    }
+  }
+
+  bool success = externalDispatcher->executeCall(function, target->inst, args,
+                                                 IsolateExternalCalls ?
+                                                 &regions : 0);
   if (!success) {
     terminateStateOnError(state, "failed external call: " + function->getName(),
                           "external.err");
     return;
   }
 
-  if (!state.addressSpace.copyInConcretes()) {
+  if (ExternalCallsCopyReachable ? !state.addressSpace.copyInConcretes(copied)
+                                 : !state.addressSpace.copyInConcretes()) {
     terminateStateOnError(state, "external modified read-only object",
                           "external.err");
     return;
   }
 
-  LLVM_TYPE_Q Type *resultType = target->inst->getType();
   if (resultType != Type::getVoidTy(getGlobalContext())) {
     ref<Expr> e = ConstantExpr::fromMemory((void*) args, 
                                            getWidthForLLVMType(resultType));
@@ -3080,6 +3699,8 @@ void Executor::executeAlloc(ExecutionState &state,
                             KInstruction *target,
                             bool zeroMemory,
                             const ObjectState *reallocFrom) {
+  if (!isa<ConstantExpr>(size) && !checkUncheckedConstraints(state))
+    return;
   size = toUnique(state, size);
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(size)) {
     MemoryObject *mo = memory->allocate(CE->getZExtValue(), isLocal, false, 
@@ -3265,15 +3886,38 @@ void Executor::executeMemoryOperation(ExecutionState &state,
       value = state.constraints.simplifyExpr(value);
   }
 
+  if (!isa<ConstantExpr>(address))
+    ++stats::resolutions;
+
+  // Loads and stores to a symbolic address which was already shown to be in
+  // bounds of a single object need neither resolution nor a bounds check.
+  bool useCache = UseResolutionCache && !isa<ConstantExpr>(address) &&
+    (isa<LoadInst>(state.prevPC->inst) || isa<StoreInst>(state.prevPC->inst));
+  const MemoryObject *cached = 0;
+  if (useCache) {
+    cached = state.addressSpace.lookupResolution(state.prevPC, address);
+    if (cached)
+      ++stats::resolutionCacheHits;
+    else
+      ++stats::resolutionCacheMisses;
+  }
+
   // fast path: single in-bounds resolution
   ObjectPair op;
   bool success;
-  solver->setTimeout(coreSolverTimeout);
-  if (!state.addressSpace.resolveOne(state, solver, address, op, success)) {
-    address = toConstant(state, address, "resolveOne failure");
-    success = state.addressSpace.resolveOne(cast<ConstantExpr>(address), op);
+  if (cached) {
+    op = ObjectPair(cached, state.addressSpace.findObject(cached));
+    success = true;
+  } else {
+    if (!isa<ConstantExpr>(address) && !checkUncheckedConstraints(state))
+      return;
+    solver->setTimeout(coreSolverTimeout);
+    if (!state.addressSpace.resolveOne(state, solver, address, op, success)) {
+      address = toConstant(state, address, "resolveOne failure");
+      success = state.addressSpace.resolveOne(cast<ConstantExpr>(address), op);
+    }
+    solver->setTimeout(0);
   }
-  solver->setTimeout(0);
 
   if (success) {
     const MemoryObject *mo = op.first;
@@ -3284,19 +3928,37 @@ void Executor::executeMemoryOperation(ExecutionState &state,
     
     ref<Expr> offset = mo->getOffsetExpr(address);
 
+    ref<Expr> check = mo->getBoundsCheckOffset(offset, bytes);
     bool inBounds;
-    solver->setTimeout(coreSolverTimeout);
-    bool success = solver->mustBeTrue(state, 
-                                      mo->getBoundsCheckOffset(offset, bytes),
-                                      inBounds);
-    solver->setTimeout(0);
-    if (!success) {
-      state.pc = state.prevPC;
-      terminateStateEarly(state, "Query timed out (bounds check).");
-      return;
+    Solver::Validity domainResult;
+    if (cached) {
+      inBounds = true;
+    } else if (FastReplayPath && replayPath && !isa<ConstantExpr>(check) &&
+               replayPosition < replayPath->size()) {
+      // The replayed path went on past this access, so it is in bounds. A
+      // path which ends here may end with this access failing.
+      addConstraint(state, check);
+      state.uncheckedConstraints = true;
+      inBounds = true;
+    } else if (evaluateWithDomain(state, check, domainResult)) {
+      inBounds = domainResult == Solver::True;
+    } else {
+      solver->setTimeout(coreSolverTimeout);
+      bool success = solver->mustBeTrue(state, check, inBounds);
+      solver->setTimeout(0);
+      if (!success) {
+        state.pc = state.prevPC;
+        terminateStateEarly(state, "Query timed out (bounds check).");
+        return;
+      }
     }
 
     if (inBounds) {
+      // Only the verdict for the original address holds for later runs of
+      // this instruction, not the one for a concretized address.
+      if (useCache && !cached && !isa<ConstantExpr>(address))
+        state.addressSpace.cacheResolution(state.prevPC, address, op);
+
       const ObjectState *os = op.second;
       if (isWrite) {
         if (os->readOnly) {
@@ -3328,6 +3990,12 @@ void Executor::executeMemoryOperation(ExecutionState &state,
   bool incomplete = state.addressSpace.resolve(state, solver, address, rl,
                                                0, coreSolverTimeout);
   solver->setTimeout(0);
+
+  if (SegmentedMemory && !incomplete && rl.size() > 1 &&
+      rl.size() <= SegmentedMemoryMaxCandidates &&
+      executeSegmentedMemoryOperation(state, isWrite, address, value, target,
+                                      rl))
+    return;
   
   // XXX there is some query wasteage here. who cares?
   ExecutionState *unbound = &state;
@@ -3375,6 +4043,70 @@ void Executor::executeMemoryOperation(ExecutionState &state,
   }
 }
 
+bool Executor::executeSegmentedMemoryOperation(ExecutionState &state,
+                                               bool isWrite,
+                                               ref<Expr> address,
+                                               ref<Expr> value,
+                                               KInstruction *target,
+                                               const ResolutionList &rl) {
+  Expr::Width type = (isWrite ? value->getWidth() :
+                     getWidthForLLVMType(target->inst->getType()));
+  unsigned bytes = Expr::getMinBytesForWidth(type);
+
+  // Errors on any of the objects still need their own states, so only
+  // accesses which are always in bounds of one of them are merged.
+  std::vector< ref<Expr> > inBounds;
+  ref<Expr> covered = ConstantExpr::alloc(0, Expr::Bool);
+  for (ResolutionList::const_iterator it = rl.begin(), ie = rl.end();
+       it != ie; ++it) {
+    if (isWrite && it->second->readOnly)
+      return false;
+    ref<Expr> check = it->first->getBoundsCheckPointer(address, bytes);
+    if (check->isFalse())
+      return false;
+    inBounds.push_back(check);
+    covered = OrExpr::create(covered, check);
+  }
+
+  bool mustBeCovered;
+  solver->setTimeout(coreSolverTimeout);
+  bool success = solver->mustBeTrue(state, covered, mustBeCovered);
+  solver->setTimeout(0);
+  if (!success || !mustBeCovered)
+    return false;
+
+  if (isWrite) {
+    // Every object is rewritten, with its old contents where the address
+    // does not point into it.
+    for (unsigned i = 0; i != rl.size(); ++i) {
+      const MemoryObject *mo = rl[i].first;
+      ObjectState *wos = state.addressSpace.getWriteable(mo, rl[i].second);
+      ref<Expr> offset = mo->getOffsetExpr(address);
+      wos->write(offset, SelectExpr::create(inBounds[i], value,
+                                            wos->read(offset, type)));
+    }
+  } else {
+    // The address is within the last object if not within any other.
+    unsigned last = rl.size() - 1;
+    ref<Expr> result =
+      rl[last].second->read(rl[last].first->getOffsetExpr(address), type);
+    for (unsigned i = last; i != 0; --i) {
+      const MemoryObject *mo = rl[i - 1].first;
+      ref<Expr> read = rl[i - 1].second->read(mo->getOffsetExpr(address), type);
+      result = SelectExpr::create(inBounds[i - 1], read, result);
+    }
+
+    if (interpreterOpts.MakeConcreteSymbolic)
+      result = replaceReadWithSymbolic(state, result);
+
+    bindLocal(target, state, result);
+  }
+
+  ++stats::segmentedAccesses;
+  stats::segmentedForksAvoided += rl.size() - 1;
+  return true;
+}
+
 void Executor::executeMakeSymbolic(ExecutionState &state, 
                                    const MemoryObject *mo,
                                    const std::string &name) {
@@ -3391,13 +4123,12 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
     bindObjectInState(state, mo, false, array);
     state.addSymbolic(mo, array);
     
-    std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
-      seedMap.find(&state);
-    if (it!=seedMap.end()) { // In seed mode we need to add this as a
-                             // binding.
-      for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
-             siie = it->second.end(); siit != siie; ++siit) {
-        SeedInfo &si = *siit;
+    if (seedMap.count(&state)) { // In seed mode we need to add this as a
+                                 // binding.
+      SeedMap::seeds_ty seeds = seedMap.getSeeds(&state);
+      for (SeedMap::seeds_ty::iterator siit = seeds.begin(), 
+             siie = seeds.end(); siit != siie; ++siit) {
+        SeedInfo &si = seedMap.getSeed(*siit);
         KTestObject *obj = si.getNextInput(mo, NamedSeedMatching);
 
         if (!obj) {
@@ -3455,11 +4186,120 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
 
 /***/
 
+namespace {
+  /// The coverage of a seed replayed by Executor::triageSeeds.
+  struct TriagedSeed {
+    KTest *seed;
+    unsigned index;
+    /// The ids of the instructions the seed covers.
+    std::vector<unsigned> covered;
+    /// The sum over the covered instructions of the inverse of the number
+    /// of seeds which cover them.
+    double uniqueness;
+  };
+
+  struct MoreUnique {
+    bool operator()(const TriagedSeed *a, const TriagedSeed *b) const {
+      if (a->uniqueness != b->uniqueness)
+        return a->uniqueness > b->uniqueness;
+      return a->index < b->index;
+    }
+  };
+}
+
+void Executor::triageSeeds(Function *f, int argc, char **argv, char **envp) {
+  std::vector<KTest *> seeds(*usingSeeds);
+  unsigned numInstructions = kmodule->infos->getMaxID();
+  std::vector<bool> coverage;
+  std::vector<TriagedSeed> triaged;
+
+  // Replay each seed on its own, without a stats tracker so that the
+  // seeding run still sees every instruction as uncovered.
+  StatsTracker *savedStatsTracker = statsTracker;
+  statsTracker = 0;
+  usingSeeds = 0;
+  triageCoverage = &coverage;
+  for (unsigned i = 0; i != seeds.size() && !haltExecution; ++i) {
+    coverage.assign(numInstructions, false);
+    replayKTest = seeds[i];
+    replayPosition = 0;
+    runMain(f, argc, argv, envp);
+
+    triaged.push_back(TriagedSeed());
+    TriagedSeed &ts = triaged.back();
+    ts.seed = seeds[i];
+    ts.index = i;
+    for (unsigned id = 0; id != numInstructions; ++id)
+      if (coverage[id])
+        ts.covered.push_back(id);
+  }
+  triageCoverage = 0;
+  replayKTest = 0;
+  statsTracker = savedStatsTracker;
+
+  std::vector<unsigned> numCovering(numInstructions, 0);
+  for (unsigned i = 0; i != triaged.size(); ++i)
+    for (unsigned j = 0; j != triaged[i].covered.size(); ++j)
+      ++numCovering[triaged[i].covered[j]];
+
+  std::vector<TriagedSeed *> order;
+  for (unsigned i = 0; i != triaged.size(); ++i) {
+    TriagedSeed &ts = triaged[i];
+    ts.uniqueness = 0.;
+    for (unsigned j = 0; j != ts.covered.size(); ++j)
+      ts.uniqueness += 1. / numCovering[ts.covered[j]];
+    order.push_back(&ts);
+  }
+  std::sort(order.begin(), order.end(), MoreUnique());
+
+  // Keep a seed only if it covers something the seeds before it do not.
+  triagedSeeds.clear();
+  coverage.assign(numInstructions, false);
+  for (unsigned i = 0; i != order.size(); ++i) {
+    bool coversNew = false;
+    for (unsigned j = 0; j != order[i]->covered.size(); ++j) {
+      unsigned id = order[i]->covered[j];
+      if (!coverage[id]) {
+        coverage[id] = true;
+        coversNew = true;
+      }
+    }
+    if (coversNew)
+      triagedSeeds.push_back(order[i]->seed);
+  }
+
+  // Seeds not replayed before a halt are kept as they are.
+  for (unsigned i = triaged.size(); i != seeds.size(); ++i)
+    triagedSeeds.push_back(seeds[i]);
+
+  klee_message("seed triage kept %u of %u seeds",
+               (unsigned) triagedSeeds.size(), (unsigned) seeds.size());
+  usingSeeds = &triagedSeeds;
+}
+
 void Executor::runFunctionAsMain(Function *f,
 				 int argc,
 				 char **argv,
 				 char **envp) {
+  if (usingSeeds && SeedTriage) {
+    // Triage replays each seed exactly, so it would only score the prefix
+    // of a seed which the seeding run extends, truncates or matches by
+    // name.
+    if (AllowSeedExtension || ZeroSeedExtension || AllowSeedTruncation ||
+        NamedSeedMatching)
+      klee_warning("--seed-triage is ignored with --allow-seed-extension, "
+                   "--zero-seed-extension, --allow-seed-truncation or "
+                   "--named-seed-matching");
+    else
+      triageSeeds(f, argc, argv, envp);
+  }
+
+  runMain(f, argc, argv, envp);
+}
+
+void Executor::runMain(Function *f, int argc, char **argv, char **envp) {
   std::vector<ref<Expr> > arguments;
+  emittedErrors.clear();
 
   // force deterministic initialization of memory objects
   srand(1);
@@ -3502,6 +4342,18 @@ void Executor::runFunctionAsMain(Function *f,
   }
 
   ExecutionState *state = new ExecutionState(kmodule->functionMap[f]);
+
+  // The empty assignment trivially satisfies the empty path condition.
+  // Reads rewritten by --make-concrete-symbolic introduce arrays which
+  // are not tracked as symbolics, so the model could not cover them.
+  if (UseConcolicModel) {
+    if (interpreterOpts.MakeConcreteSymbolic)
+      klee_warning("--use-concolic-model is ignored with "
+                   "--make-concrete-symbolic");
+    else
+      state->concolicModelValid = true;
+  }
+  state->useAbstractDomain = UseAbstractDomain;
   
   if (pathWriter) 
     state->pathOS = pathWriter->open();
@@ -3550,13 +4402,13 @@ void Executor::runFunctionAsMain(Function *f,
 
   // hack to clear memory objects
   delete memory;
-  memory = new MemoryManager(NULL);
+  memory = new MemoryManager(&arrayCache);
 
   globalObjects.clear();
   globalAddresses.clear();
-
-  if (statsTracker)
-    statsTracker->done();
+  // The native copies of module functions are bound to the addresses of
+  // the globals of this run.
+  externalDispatcher->clearNativeFunctions();
 }
 
 unsigned Executor::getPathStreamID(const ExecutionState &state) {
@@ -20,11 +20,15 @@
 #include "klee/Internal/Module/Cell.h"
 #include "klee/Internal/Module/KInstruction.h"
 #include "klee/Internal/Module/KModule.h"
+#include "klee/Solver.h"
 #include "klee/util/ArrayCache.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "llvm/ADT/Twine.h"
 
+#include "SeedMap.h"
+#include "StateRegistry.h"
+
 #include <vector>
 #include <string>
 #include <map>
@@ -40,6 +44,7 @@ namespace llvm {
   class ConstantExpr;
   class Function;
   class GlobalValue;
+  class GlobalVariable;
   class Instruction;
 #if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
   class TargetData;
@@ -53,6 +58,7 @@ namespace llvm {
 namespace klee {  
   class Array;
   struct Cell;
+  class DuplicateStateFilter;
   class ExecutionState;
   class ExternalDispatcher;
   class Expr;
@@ -66,7 +72,6 @@ namespace klee {
   class ObjectState;
   class PTree;
   class Searcher;
-  class SeedInfo;
   class SpecialFunctionHandler;
   struct StackFrame;
   class StatsTracker;
@@ -82,9 +87,11 @@ namespace klee {
 
 class Executor : public Interpreter {
   friend class BumpMergingSearcher;
+  friend class DirectedSearcher;
   friend class MergingSearcher;
   friend class RandomPathSearcher;
   friend class OwningSearcher;
+  friend class QCEMergingSearcher;
   friend class WeightedRandomSearcher;
   friend class SpecialFunctionHandler;
   friend class StatsTracker;
@@ -111,13 +118,17 @@ private:
   ExternalDispatcher *externalDispatcher;
   TimingSolver *solver;
   MemoryManager *memory;
-  std::set<ExecutionState*> states;
+  StateRegistry states;
   StatsTracker *statsTracker;
   TreeStreamWriter *pathWriter, *symPathWriter;
   SpecialFunctionHandler *specialFunctionHandler;
   std::vector<TimerInfo*> timers;
   PTree *processTree;
 
+  /// Remembers the states seen at function returns, when duplicate states
+  /// are pruned.
+  DuplicateStateFilter *duplicateStateFilter;
+
   /// Used to track states that have been added during the current
   /// instructions step. 
   /// \invariant \ref addedStates is a subset of \ref states. 
@@ -130,13 +141,13 @@ private:
   std::vector<ExecutionState *> removedStates;
 
   /// When non-empty the Executor is running in "seed" mode. The
-  /// states in this map will be executed in an arbitrary order
+  /// states in this map will be executed in proportion to their seeds
   /// (outside the normal search interface) until they terminate. When
   /// the states reach a symbolic branch then either direction that
   /// satisfies one or more seeds will be added to this map. What
   /// happens with other states (that don't satisfy the seeds) depends
   /// on as-yet-to-be-determined flags.
-  std::map<ExecutionState*, std::vector<SeedInfo> > seedMap;
+  SeedMap seedMap;
   
   /// Map of globals to their representative memory object.
   std::map<const llvm::GlobalValue*, MemoryObject*> globalObjects;
@@ -149,6 +160,17 @@ private:
   /// pointers. We use the actual Function* address as the function address.
   std::set<uint64_t> legalFunctions;
 
+  /// What is known about running a module function natively, for
+  /// --native-concrete-calls.
+  struct NativeCallInfo {
+    /// Whether the function, and every function it calls, can be run
+    /// natively.
+    bool callable;
+    /// The global variables the function and its callees refer to.
+    std::set<const llvm::GlobalVariable*> globals;
+  };
+  std::map<const llvm::Function*, NativeCallInfo> nativeCallInfo;
+
   /// When non-null the bindings that will be used for calls to
   /// klee_make_symbolic in order replay.
   const struct KTest *replayKTest;
@@ -162,6 +184,17 @@ private:
   /// drive execution.
   const std::vector<struct KTest *> *usingSeeds;  
 
+  /// When non-null a seed is being replayed by \ref triageSeeds, and the
+  /// instructions it executes are marked here by id.
+  std::vector<bool> *triageCoverage;
+
+  /// The seeds kept by \ref triageSeeds, in the order they are used.
+  std::vector<struct KTest *> triagedSeeds;
+
+  /// The errors already reported in this run, by instruction and message,
+  /// for which no more test cases are written unless --emit-all-errors.
+  std::set<std::pair<llvm::Instruction*, std::string> > emittedErrors;
+
   /// Disables forking, instead a random path is chosen. Enabled as
   /// needed to control memory usage. \see fork()
   bool atMemoryLimit;
@@ -203,6 +236,10 @@ private:
 
   void run(ExecutionState &initialState);
 
+  /// Run \a f as the main function once, from a fresh initial state, and
+  /// release the memory and globals of the run afterwards.
+  void runMain(llvm::Function *f, int argc, char **argv, char **envp);
+
   // Given a concrete object in our [klee's] address space, add it to 
   // objects checked code can reference.
   MemoryObject *addExternalObject(ExecutionState &state, void *addr, 
@@ -214,11 +251,27 @@ private:
   void initializeGlobals(ExecutionState &state);
 
   void stepInstruction(ExecutionState &state);
+
+  /// Return true if the next instruction of \a state can be run without
+  /// any bookkeeping after the previous one: it is in the basic block
+  /// \a bb, is not a call or terminator, has only concrete operands, and the
+  /// previous instruction neither added nor removed a state.
+  bool canRunConcretely(ExecutionState &state, llvm::BasicBlock *bb) const;
   void updateStates(ExecutionState *current);
   void transferToBasicBlock(llvm::BasicBlock *dst, 
 			    llvm::BasicBlock *src,
 			    ExecutionState &state);
 
+  const NativeCallInfo &getNativeCallInfo(llvm::Function *f);
+
+  /// Run the call of the module function \a f natively, if its arguments
+  /// and all the memory it can reach are concrete.
+  ///
+  /// \return false if the call was not run, in which case nothing has
+  /// been changed and it should be interpreted.
+  bool callNative(ExecutionState &state, KInstruction *ki, llvm::Function *f,
+                  std::vector< ref<Expr> > &arguments);
+
   void callExternalFunction(ExecutionState &state,
                             KInstruction *target,
                             llvm::Function *function,
@@ -286,6 +339,19 @@ private:
                               ref<Expr> value /* undef if read */,
                               KInstruction *target /* undef if write */);
 
+  /// Perform a memory operation on an address which may point into each
+  /// of the objects in \a rl without forking, by reading through a select
+  /// chain over the objects and guarding the writes to each of them.
+  ///
+  /// \return false if the operation could not be done this way, in which
+  /// case nothing has been changed.
+  bool executeSegmentedMemoryOperation(ExecutionState &state,
+                                       bool isWrite,
+                                       ref<Expr> address,
+                                       ref<Expr> value,
+                                       KInstruction *target,
+                                       const ResolutionList &rl);
+
   void executeMakeSymbolic(ExecutionState &state, const MemoryObject *mo,
                            const std::string &name);
 
@@ -297,11 +363,49 @@ private:
               const std::vector< ref<Expr> > &conditions,
               std::vector<ExecutionState*> &result);
 
+  /// Evaluate \a condition under the concolic model of \a state, which
+  /// proves one side of the branch feasible for free, and only ask the
+  /// solver about the other side.
+  ///
+  /// \param modelSide[out] The value of \a condition under the model.
+  /// \param flipped[out] When \a result is Unknown, a model satisfying
+  /// the constraints together with the side opposite to \a modelSide.
+  bool evaluateWithModel(ExecutionState &state, ref<Expr> condition,
+                         Solver::Validity &result, bool &modelSide,
+                         Assignment &flipped);
+
+  /// Try to decide \a condition from the abstract domain of \a state
+  /// alone, without asking the solver.
+  ///
+  /// \return True if the domain proves \a condition true or false, in
+  /// which case \a result is set accordingly.
+  bool evaluateWithDomain(const ExecutionState &state, ref<Expr> condition,
+                          Solver::Validity &result);
+
   // Fork current and return states in which condition holds / does
   // not hold, respectively. One of the states is necessarily the
   // current state, and one of the states may be null.
   StatePair fork(ExecutionState &current, ref<Expr> condition, bool isInternal);
 
+  /// Take the next branch of the replay path without checking that it is
+  /// feasible, as done by fork under --fast-replay-path.
+  StatePair forkReplayed(ExecutionState &current, ref<Expr> condition);
+
+  /// Check that the constraints added to \a state without asking the
+  /// solver can hold, before a query which needs a solution. If they
+  /// cannot, \a state is terminated and false is returned.
+  bool checkUncheckedConstraints(ExecutionState &state);
+
+  /// Replay each of the seeds concretely and keep those which cover
+  /// instructions the others do not, most unique first, in \ref
+  /// triagedSeeds.
+  void triageSeeds(llvm::Function *f, int argc, char **argv, char **envp);
+
+  /// Evaluate \a e under each of \a seeds, which belong to \a state,
+  /// returning one value per seed.
+  void getSeedValues(ExecutionState &state, const SeedMap::seeds_ty &seeds,
+                     ref<Expr> e, std::vector< ref<ConstantExpr> > &result);
+
   /// Add the given (boolean) condition as a constraint on state. This
   /// function is a wrapper around the state's addConstraint function
   /// which also manages propagation of implied values,
@@ -90,10 +90,11 @@ void Executor::initTimers() {
   if (first) {
     first = false;
     setupHandler();
-  }
 
-  if (MaxTime) {
-    addTimer(new HaltTimer(this), MaxTime.getValue());
+    // --max-time covers all of the runs.
+    if (MaxTime) {
+      addTimer(new HaltTimer(this), MaxTime.getValue());
+    }
   }
 }
 
@@ -134,7 +135,7 @@ void Executor::processTimers(ExecutionState *current,
       llvm::raw_ostream *os = interpreterHandler->openOutputFile("states.txt");
       
       if (os) {
-        for (std::set<ExecutionState*>::const_iterator it = states.begin(), 
+        for (StateRegistry::iterator it = states.begin(), 
                ie = states.end(); it != ie; ++it) {
           ExecutionState *es = *it;
           *os << "(" << es << ",";
@@ -26,6 +26,8 @@
 #include "llvm/ExecutionEngine/JIT.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 #include "llvm/Support/raw_ostream.h"
 
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 0)
@@ -40,8 +42,13 @@
 #include "llvm/IR/CallSite.h"
 #endif
 
+#include <cerrno>
+#include <cstdio>
+#include <set>
 #include <setjmp.h>
 #include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace llvm;
 using namespace klee;
@@ -119,7 +126,9 @@ ExternalDispatcher::~ExternalDispatcher() {
   delete executionEngine;
 }
 
-bool ExternalDispatcher::executeCall(Function *f, Instruction *i, uint64_t *args) {
+bool ExternalDispatcher::executeCall(Function *f, Instruction *i,
+                                     uint64_t *args,
+                                     const MemoryRegions *isolated) {
   dispatchers_ty::iterator it = dispatchers.find(i);
   Function *dispatcher;
 
@@ -137,9 +146,24 @@ bool ExternalDispatcher::executeCall(Function *f, Instruction *i, uint64_t *args
     }
 #endif
 
+    // A non-variadic function is called the same way from every call site
+    // with the same number of arguments, so they can share a dispatcher.
+    // Arguments past its parameters take their type from the call site.
+    unsigned numArgs = CallSite(i).arg_size();
+    std::pair<Function*, unsigned> key(f, numArgs);
+    bool shared = !f->isVarArg() && numArgs <= f->arg_size();
+    std::map<std::pair<Function*, unsigned>, Function*>::iterator it3 =
+      sharedDispatchers.find(key);
+    if (shared && it3 != sharedDispatchers.end()) {
+      dispatchers.insert(std::make_pair(i, it3->second));
+      return runDispatcher(it3->second, args, isolated);
+    }
+
     dispatcher = createDispatcher(f,i);
 
     dispatchers.insert(std::make_pair(i, dispatcher));
+    if (shared)
+      sharedDispatchers.insert(std::make_pair(key, dispatcher));
 
     if (dispatcher) {
       // Force the JIT execution engine to go ahead and build the function. This
@@ -152,6 +176,109 @@ bool ExternalDispatcher::executeCall(Function *f, Instruction *i, uint64_t *args
     dispatcher = it->second;
   }
 
+  return runDispatcher(dispatcher, args, isolated);
+}
+
+bool ExternalDispatcher::executeNative(Function *f, Instruction *i,
+                                       uint64_t *args,
+                                       const GlobalAddresses &globals) {
+  std::pair<const Instruction*, const Function*> key(i, f);
+  std::map<std::pair<const Instruction*, const Function*>, Function*>::iterator
+    it = nativeDispatchers.find(key);
+  Function *dispatcher;
+
+  if (it == nativeDispatchers.end()) {
+    dispatcher = createDispatcher(f, i, getNativeFunction(f, globals));
+    nativeDispatchers.insert(std::make_pair(key, dispatcher));
+    executionEngine->recompileAndRelinkFunction(dispatcher);
+  } else {
+    dispatcher = it->second;
+  }
+
+  return runProtectedCall(dispatcher, args);
+}
+
+void ExternalDispatcher::clearNativeFunctions() {
+  // The copies stay in the dispatch module; later copies are named apart
+  // from them.
+  nativeFunctions.clear();
+  nativeGlobals.clear();
+  nativeDispatchers.clear();
+}
+
+/// Add the global values used by \a c, looking through constant
+/// expressions, to \a result.
+static void findGlobals(Constant *c, std::set<GlobalValue*> &result) {
+  if (GlobalValue *gv = dyn_cast<GlobalValue>(c)) {
+    result.insert(gv);
+    return;
+  }
+  for (unsigned i = 0, e = c->getNumOperands(); i != e; ++i)
+    findGlobals(cast<Constant>(c->getOperand(i)), result);
+}
+
+Function *ExternalDispatcher::getNativeFunction(Function *f,
+                                                const GlobalAddresses &
+                                                  globals) {
+  std::map<const Function*, Function*>::iterator it = nativeFunctions.find(f);
+  if (it != nativeFunctions.end())
+    return it->second;
+
+  // The copy is named apart from any native symbol of the same name, and is
+  // recorded before its callees are copied so that recursion ends here.
+  Function *nf = Function::Create(f->getFunctionType(),
+                                  GlobalValue::InternalLinkage,
+                                  "__klee_native_" + f->getName().str(),
+                                  dispatchModule);
+  nativeFunctions.insert(std::make_pair(f, nf));
+
+  ValueToValueMapTy vmap;
+  for (Function::arg_iterator ai = f->arg_begin(), ae = f->arg_end(),
+         nai = nf->arg_begin(); ai != ae; ++ai, ++nai)
+    vmap[ai] = nai;
+
+  std::set<GlobalValue*> used;
+  for (Function::iterator bb = f->begin(), be = f->end(); bb != be; ++bb)
+    for (BasicBlock::iterator ii = bb->begin(), ie = bb->end(); ii != ie; ++ii)
+      for (unsigned k = 0, e = ii->getNumOperands(); k != e; ++k)
+        if (Constant *c = dyn_cast<Constant>(ii->getOperand(k)))
+          findGlobals(c, used);
+
+  for (std::set<GlobalValue*>::iterator gi = used.begin(), ge = used.end();
+       gi != ge; ++gi) {
+    if (Function *callee = dyn_cast<Function>(*gi)) {
+      if (callee->isDeclaration())
+        vmap[callee] =
+          dispatchModule->getOrInsertFunction(callee->getName(),
+                                              callee->getFunctionType(),
+                                              callee->getAttributes());
+      else
+        vmap[callee] = getNativeFunction(callee, globals);
+    } else if (GlobalVariable *gv = dyn_cast<GlobalVariable>(*gi)) {
+      GlobalVariable *&ngv = nativeGlobals[gv];
+      if (!ngv) {
+        ngv = new GlobalVariable(*dispatchModule,
+                                 gv->getType()->getElementType(),
+                                 gv->isConstant(),
+                                 GlobalValue::ExternalLinkage, 0,
+                                 "__klee_native_" + gv->getName().str());
+        GlobalAddresses::const_iterator ai = globals.find(gv);
+        assert(ai != globals.end() && "missing address of global variable");
+        executionEngine->addGlobalMapping(ngv, ai->second);
+      }
+      vmap[gv] = ngv;
+    }
+  }
+
+  SmallVector<ReturnInst*, 8> returns;
+  CloneFunctionInto(nf, f, vmap, true, returns);
+  return nf;
+}
+
+bool ExternalDispatcher::runDispatcher(Function *dispatcher, uint64_t *args,
+                                       const MemoryRegions *isolated) {
+  if (isolated)
+    return runIsolatedCall(dispatcher, args, *isolated);
   return runProtectedCall(dispatcher, args);
 }
 
@@ -185,14 +312,134 @@ bool ExternalDispatcher::runProtectedCall(Function *f, uint64_t *args) {
   return res;
 }
 
+static bool writeAll(int fd, const void *buf, size_t size) {
+  const char *p = (const char*) buf;
+  while (size) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool readAll(int fd, void *buf, size_t size) {
+  char *p = (char*) buf;
+  while (size) {
+    ssize_t n = read(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+/// The region index which ends the list of changes sent by an isolated
+/// call.
+static const uint32_t EndOfChanges = ~0U;
+
+// The child runs the call on its copy of the address space, and then sends
+// back whether it succeeded, the result words, and each run of changed
+// bytes in the regions as (region, offset, length, bytes).
+bool ExternalDispatcher::runIsolatedCall(Function *f, uint64_t *args,
+                                         const MemoryRegions &regions) {
+  if (!f)
+    return false;
+
+  int fds[2];
+  if (pipe(fds) != 0)
+    return false;
+
+  // Anything still buffered would otherwise be written by both processes.
+  fflush(stdout);
+  fflush(stderr);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    close(fds[0]);
+    std::vector<std::vector<uint8_t> > before(regions.size());
+    for (unsigned i = 0; i != regions.size(); ++i)
+      before[i].assign(regions[i].first,
+                       regions[i].first + regions[i].second);
+
+    uint8_t ok = runProtectedCall(f, args);
+    bool sent = writeAll(fds[1], &ok, 1) &&
+      writeAll(fds[1], args, 2 * sizeof(*args));
+    for (uint32_t i = 0; sent && ok && i != regions.size(); ++i) {
+      const uint8_t *now = regions[i].first;
+      uint64_t size = regions[i].second;
+      for (uint64_t j = 0; sent && j != size; ) {
+        if (now[j] == before[i][j]) {
+          ++j;
+          continue;
+        }
+        uint64_t k = j;
+        while (k != size && now[k] != before[i][k])
+          ++k;
+        uint64_t length = k - j;
+        sent = writeAll(fds[1], &i, sizeof(i)) &&
+          writeAll(fds[1], &j, sizeof(j)) &&
+          writeAll(fds[1], &length, sizeof(length)) &&
+          writeAll(fds[1], now + j, length);
+        j = k;
+      }
+    }
+    sent = sent && writeAll(fds[1], &EndOfChanges, sizeof(EndOfChanges));
+    fflush(stdout);
+    fflush(stderr);
+    _exit(sent ? 0 : 1);
+  }
+
+  close(fds[1]);
+  uint8_t ok = 0;
+  bool res = readAll(fds[0], &ok, 1) && ok &&
+    readAll(fds[0], args, 2 * sizeof(*args));
+  while (res) {
+    uint32_t region;
+    uint64_t offset, length;
+    if (!readAll(fds[0], &region, sizeof(region))) {
+      res = false;
+    } else if (region == EndOfChanges) {
+      break;
+    } else {
+      res = region < regions.size() &&
+        readAll(fds[0], &offset, sizeof(offset)) &&
+        readAll(fds[0], &length, sizeof(length)) &&
+        offset + length <= regions[region].second &&
+        readAll(fds[0], regions[region].first + offset, length);
+    }
+  }
+  // Closing our end first stops a child still writing to it.
+  close(fds[0]);
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0)
+    if (errno != EINTR)
+      return false;
+  return res && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
 // For performance purposes we construct the stub in such a way that the
 // arguments pointer is passed through the static global variable gTheArgsP in
 // this file. This is done so that the stub function prototype trivially matches
 // the special cases that the JIT knows how to directly call. If this is not
 // done, then the jit will end up generating a nullary stub just to call our
 // stub, for every single function call.
-Function *ExternalDispatcher::createDispatcher(Function *target, Instruction *inst) {
-  if (!resolveSymbol(target->getName()))
+Function *ExternalDispatcher::createDispatcher(Function *target, Instruction *inst,
+                                              Function *callee) {
+  if (!callee && !resolveSymbol(target->getName()))
     return 0;
 
   CallSite cs;
@@ -250,7 +497,7 @@ Function *ExternalDispatcher::createDispatcher(Function *target, Instruction *in
     idx += ((!!argSize ? argSize : 64) + 63)/64;
   }
 
-  Constant *dispatchTarget =
+  Constant *dispatchTarget = callee ? callee :
     dispatchModule->getOrInsertFunction(target->getName(), FTy,
                                         target->getAttributes());
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 0)
@@ -12,13 +12,16 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <stdint.h>
+#include <stddef.h>
 
 namespace llvm {
   class ExecutionEngine;
   class Instruction;
   class Function;
   class FunctionType;
+  class GlobalVariable;
   class Module;
 }
 
@@ -27,12 +30,38 @@ namespace klee {
   private:
     typedef std::map<const llvm::Instruction*,llvm::Function*> dispatchers_ty;
     dispatchers_ty dispatchers;
+    /// Dispatchers of non-variadic functions, which are shared by all the
+    /// call sites passing the same number of arguments.
+    std::map<std::pair<llvm::Function*, unsigned>, llvm::Function*>
+      sharedDispatchers;
     llvm::Module *dispatchModule;
     llvm::ExecutionEngine *executionEngine;
     std::map<std::string, void*> preboundFunctions;
     
-    llvm::Function *createDispatcher(llvm::Function *f, llvm::Instruction *i);
+  public:
+    /// Native memory ranges, as (address, size) pairs.
+    typedef std::vector<std::pair<uint8_t*, size_t> > MemoryRegions;
+
+    /// The native addresses of global variables.
+    typedef std::map<const llvm::GlobalVariable*, void*> GlobalAddresses;
+
+  private:
+    /// Compiled copies of module functions and the globals they use, and
+    /// the dispatchers calling them, for executeNative.
+    std::map<const llvm::Function*, llvm::Function*> nativeFunctions;
+    std::map<const llvm::GlobalVariable*, llvm::GlobalVariable*> nativeGlobals;
+    std::map<std::pair<const llvm::Instruction*, const llvm::Function*>,
+             llvm::Function*> nativeDispatchers;
+
+    llvm::Function *createDispatcher(llvm::Function *f, llvm::Instruction *i,
+                                     llvm::Function *callee = 0);
+    llvm::Function *getNativeFunction(llvm::Function *f,
+                                      const GlobalAddresses &globals);
     bool runProtectedCall(llvm::Function *f, uint64_t *args);
+    bool runIsolatedCall(llvm::Function *f, uint64_t *args,
+                         const MemoryRegions &regions);
+    bool runDispatcher(llvm::Function *dispatcher, uint64_t *args,
+                       const MemoryRegions *isolated);
     
   public:
     ExternalDispatcher();
@@ -41,8 +70,27 @@ namespace klee {
     /* Call the given function using the parameter passing convention of
      * ci with arguments in args[1], args[2], ... and writing the result
      * into args[0].
+     *
+     * If isolated is given, the call is made in a forked child process,
+     * so that a crash or memory corruption in the callee cannot affect
+     * this one. The changes it makes to the given regions of memory are
+     * sent back and applied here; any other effect on this process, such
+     * as memory the callee allocates, is lost.
      */
-    bool executeCall(llvm::Function *function, llvm::Instruction *i, uint64_t *args);
+    /// clearNativeFunctions - Forget the native copies of module functions
+    /// made so far, which are bound to the current addresses of the globals
+    /// they use.
+    void clearNativeFunctions();
+
+    bool executeCall(llvm::Function *function, llvm::Instruction *i,
+                     uint64_t *args, const MemoryRegions *isolated = 0);
+
+    /// Call the module function \a f as executeCall calls an external
+    /// function, by compiling a copy of it and of the module functions it
+    /// calls. The copies use the global variables at the addresses in
+    /// \a globals, which must hold every global they refer to.
+    bool executeNative(llvm::Function *f, llvm::Instruction *i,
+                       uint64_t *args, const GlobalAddresses &globals);
     void *resolveSymbol(const std::string &name);
   };  
 }
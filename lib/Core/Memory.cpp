@@ -15,6 +15,7 @@
 #include "klee/util/BitArray.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 #include "klee/util/ArrayCache.h"
+#include "klee/util/ExprUtil.h"
 
 #include "ObjectHolder.h"
 #include "MemoryManager.h"
@@ -67,6 +68,29 @@ ObjectHolder &ObjectHolder::operator=(const ObjectHolder &b) {
 
 /***/
 
+MemoryObjectHolder::MemoryObjectHolder(const MemoryObject *_mo) : mo(_mo) {
+  if (mo) ++mo->refCount;
+}
+
+MemoryObjectHolder::MemoryObjectHolder(const MemoryObjectHolder &b)
+  : mo(b.mo) {
+  if (mo) ++mo->refCount;
+}
+
+MemoryObjectHolder::~MemoryObjectHolder() {
+  if (mo && --mo->refCount==0) delete mo;
+}
+
+MemoryObjectHolder &
+MemoryObjectHolder::operator=(const MemoryObjectHolder &b) {
+  if (b.mo) ++b.mo->refCount;
+  if (mo && --mo->refCount==0) delete mo;
+  mo = b.mo;
+  return *this;
+}
+
+/***/
+
 int MemoryObject::counter = 0;
 
 MemoryObject::~MemoryObject() {
@@ -107,6 +131,8 @@ ObjectState::ObjectState(const MemoryObject *mo)
     flushMask(0),
     knownSymbolics(0),
     updates(0, 0),
+    contentHashValid(false),
+    symbolicArraysValid(false),
     size(mo->size),
     readOnly(false) {
   mo->refCount++;
@@ -129,6 +155,8 @@ ObjectState::ObjectState(const MemoryObject *mo, const Array *array)
     flushMask(0),
     knownSymbolics(0),
     updates(array, 0),
+    contentHashValid(false),
+    symbolicArraysValid(false),
     size(mo->size),
     readOnly(false) {
   mo->refCount++;
@@ -145,6 +173,10 @@ ObjectState::ObjectState(const ObjectState &os)
     flushMask(os.flushMask ? new BitArray(*os.flushMask, os.size) : 0),
     knownSymbolics(0),
     updates(os.updates),
+    contentHash(os.contentHash),
+    contentHashValid(os.contentHashValid),
+    symbolicArrays(os.symbolicArrays),
+    symbolicArraysValid(os.symbolicArraysValid),
     size(os.size),
     readOnly(false) {
   assert(!os.readOnly && "no need to copy read only object?");
@@ -236,6 +268,7 @@ const UpdateList &ObjectState::getUpdates() const {
 }
 
 void ObjectState::makeConcrete() {
+  invalidateContentCaches();
   if (concreteMask) delete concreteMask;
   if (flushMask) delete flushMask;
   if (knownSymbolics) delete[] knownSymbolics;
@@ -247,6 +280,7 @@ void ObjectState::makeConcrete() {
 void ObjectState::makeSymbolic() {
   assert(!updates.head &&
          "XXX makeSymbolic of objects with symbolic values is unsupported");
+  invalidateContentCaches();
 
   // XXX simplify this, can just delete various arrays I guess
   for (unsigned i=0; i<size; i++) {
@@ -287,6 +321,7 @@ void ObjectState::fastRangeCheckOffset(ref<Expr> offset,
 void ObjectState::flushRangeForRead(unsigned rangeBase, 
                                     unsigned rangeSize) const {
   if (!flushMask) flushMask = new BitArray(size, true);
+  invalidateContentCaches();
  
   for (unsigned offset=rangeBase; offset<rangeBase+rangeSize; offset++) {
     if (!isByteFlushed(offset)) {
@@ -334,6 +369,114 @@ void ObjectState::flushRangeForWrite(unsigned rangeBase,
   } 
 }
 
+bool ObjectState::isAllConcrete() const {
+  if (!concreteMask)
+    return true;
+  for (unsigned i = 0; i != size; ++i)
+    if (!concreteMask->get(i))
+      return false;
+  return true;
+}
+
+static unsigned hashUpdates(const UpdateList &ul) {
+  unsigned res = ul.getSize();
+  if (ul.root)
+    res ^= ul.hash();
+  else if (ul.head)
+    res ^= ul.head->hash();
+  return res;
+}
+
+static bool equalUpdates(const UpdateList &a, const UpdateList &b) {
+  if (a.root != b.root || a.getSize() != b.getSize())
+    return false;
+  for (const UpdateNode *an = a.head, *bn = b.head; an != bn;
+       an = an->next, bn = bn->next)
+    if (an->compare(*bn))
+      return false;
+  return true;
+}
+
+unsigned ObjectState::getContentHash() const {
+  if (contentHashValid)
+    return contentHash;
+
+  // Bytes are hashed by what their cache holds rather than by read8, so
+  // that hashing neither flushes nor builds any expressions.
+  unsigned res = size;
+  bool hasFlushed = false;
+  for (unsigned i = 0; i != size; ++i) {
+    unsigned byte;
+    if (isByteConcrete(i)) {
+      byte = concreteStore[i];
+    } else if (isByteKnownSymbolic(i)) {
+      byte = knownSymbolics[i]->hash();
+    } else {
+      byte = ~0U;
+      hasFlushed = true;
+    }
+    res = res * Expr::MAGIC_HASH_CONSTANT + byte;
+  }
+  if (hasFlushed)
+    res ^= hashUpdates(updates);
+
+  contentHash = res;
+  contentHashValid = true;
+  return res;
+}
+
+bool ObjectState::equals(const ObjectState &os) const {
+  if (this == &os)
+    return true;
+  if (size != os.size || getContentHash() != os.getContentHash())
+    return false;
+
+  bool hasFlushed = false;
+  for (unsigned i = 0; i != size; ++i) {
+    if (isByteConcrete(i)) {
+      if (!os.isByteConcrete(i) || concreteStore[i] != os.concreteStore[i])
+        return false;
+    } else if (isByteKnownSymbolic(i)) {
+      if (!os.isByteKnownSymbolic(i) ||
+          knownSymbolics[i] != os.knownSymbolics[i])
+        return false;
+    } else {
+      if (os.isByteConcrete(i) || os.isByteKnownSymbolic(i))
+        return false;
+      hasFlushed = true;
+    }
+  }
+  return !hasFlushed || equalUpdates(updates, os.updates);
+}
+
+void ObjectState::findSymbolicArrays(std::vector<const Array*> &results) const {
+  if (!concreteMask)
+    return;
+  if (!symbolicArraysValid) {
+    symbolicArrays.clear();
+    std::vector< ref<Expr> > exprs;
+    bool hasFlushed = false;
+    for (unsigned i = 0; i != size; ++i) {
+      if (isByteKnownSymbolic(i))
+        exprs.push_back(knownSymbolics[i]);
+      else if (!isByteConcrete(i))
+        hasFlushed = true;
+    }
+    if (hasFlushed) {
+      if (updates.root && updates.root->isSymbolicArray())
+        symbolicArrays.push_back(updates.root);
+      for (const UpdateNode *un = updates.head; un; un = un->next) {
+        exprs.push_back(un->index);
+        exprs.push_back(un->value);
+      }
+    }
+    findSymbolicObjects(exprs.begin(), exprs.end(), symbolicArrays);
+    symbolicArraysValid = true;
+  }
+
+  results.insert(results.end(), symbolicArrays.begin(), symbolicArrays.end());
+}
+
 bool ObjectState::isByteConcrete(unsigned offset) const {
   return !concreteMask || concreteMask->get(offset);
 }
@@ -416,6 +559,7 @@ ref<Expr> ObjectState::read8(ref<Expr> offset) const {
 
 void ObjectState::write8(unsigned offset, uint8_t value) {
   //assert(read_only == false && "writing to read-only object!");
+  invalidateContentCaches();
   concreteStore[offset] = value;
   setKnownSymbolic(offset, 0);
 
@@ -428,6 +572,7 @@ void ObjectState::write8(unsigned offset, ref<Expr> value) {
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(value)) {
     write8(offset, (uint8_t) CE->getZExtValue(8));
   } else {
+    invalidateContentCaches();
     setKnownSymbolic(offset, value.get());
       
     markByteSymbolic(offset);
@@ -437,6 +582,7 @@ void ObjectState::write8(unsigned offset, ref<Expr> value) {
 
 void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
   assert(!isa<ConstantExpr>(offset) && "constant offset passed to symbolic write8");
+  invalidateContentCaches();
   unsigned base, size;
   fastRangeCheckOffset(offset, &base, &size);
   flushRangeForWrite(base, size);
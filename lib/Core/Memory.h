@@ -33,6 +33,7 @@ class MemoryObject {
   friend class STPBuilder;
   friend class ObjectState;
   friend class ExecutionState;
+  friend class MemoryObjectHolder;
 
 private:
   static int counter;
@@ -168,6 +169,17 @@ private:
   // mutable because we may need flush during read of const
   mutable UpdateList updates;
 
+  /// Cached results of getContentHash() and findSymbolicArrays(), dropped
+  /// whenever the contents change.
+  mutable unsigned contentHash;
+  mutable bool contentHashValid;
+  mutable std::vector<const Array*> symbolicArrays;
+  mutable bool symbolicArraysValid;
+
+  void invalidateContentCaches() const {
+    contentHashValid = symbolicArraysValid = false;
+  }
+
 public:
   unsigned size;
 
@@ -190,6 +202,22 @@ public:
 
   void setReadOnly(bool ro) { readOnly = ro; }
 
+  /// Return true if every byte of the object has a concrete value.
+  bool isAllConcrete() const;
+
+  /// Return a hash of the object contents, which is equal for objects
+  /// for which equals() holds. The hash is computed lazily and cached
+  /// until the next write.
+  unsigned getContentHash() const;
+
+  /// Return true if every byte of this object reads as the same
+  /// expression as the corresponding byte of \a os.
+  bool equals(const ObjectState &os) const;
+
+  /// Append the symbolic arrays which the contents of the object read
+  /// from to \a results. The arrays are cached until the next write.
+  void findSymbolicArrays(std::vector<const Array*> &results) const;
+
   // make contents all concrete and zero
   void initializeToZero();
   // make contents all concrete and random
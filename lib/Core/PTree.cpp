@@ -9,50 +9,84 @@
 
 #include "PTree.h"
 
-#include <klee/Expr.h>
-#include <klee/util/ExprPPrinter.h>
+#include "llvm/Support/raw_ostream.h"
 
+#include <cassert>
 #include <vector>
 
 using namespace klee;
 
   /* *** */
 
-PTree::PTree(const data_type &_root) : root(new Node(0,_root)) {
+PTree::PTree(const data_type &_root) : freeNodes(0) {
+  root = allocNode(0, _root);
 }
 
-PTree::~PTree() {}
+PTree::~PTree() {
+  for (std::vector<Node*>::iterator it = blocks.begin(), ie = blocks.end();
+       it != ie; ++it)
+    delete[] *it;
+}
+
+PTreeNode *PTree::allocNode(Node *parent, const data_type &data) {
+  if (!freeNodes) {
+    Node *block = new Node[NodesPerBlock];
+    blocks.push_back(block);
+    for (unsigned i = 0; i != NodesPerBlock; ++i) {
+      block[i].left = freeNodes;
+      freeNodes = &block[i];
+    }
+  }
+
+  Node *n = freeNodes;
+  freeNodes = n->left;
+  n->parent = parent;
+  n->left = n->right = 0;
+  n->data = data;
+  return n;
+}
+
+void PTree::freeNode(Node *n) {
+  n->left = freeNodes;
+  freeNodes = n;
+}
 
 std::pair<PTreeNode*, PTreeNode*>
 PTree::split(Node *n, 
              const data_type &leftData, 
              const data_type &rightData) {
   assert(n && !n->left && !n->right);
-  n->left = new Node(n, leftData);
-  n->right = new Node(n, rightData);
+  n->left = allocNode(n, leftData);
+  n->right = allocNode(n, rightData);
   return std::make_pair(n->left, n->right);
 }
 
 void PTree::remove(Node *n) {
   assert(!n->left && !n->right);
-  do {
-    Node *p = n->parent;
-    delete n;
-    if (p) {
-      if (n == p->left) {
-        p->left = 0;
-      } else {
-        assert(n == p->right);
-        p->right = 0;
-      }
-    }
-    n = p;
-  } while (n && !n->left && !n->right);
+  Node *p = n->parent;
+  freeNode(n);
+  if (!p) {
+    root = 0;
+    return;
+  }
+
+  // The sibling takes the place of the parent.
+  Node *sibling = (n == p->left) ? p->right : p->left;
+  assert(sibling && "inner node with a single child");
+  Node *g = p->parent;
+  sibling->parent = g;
+  if (!g) {
+    root = sibling;
+  } else if (p == g->left) {
+    g->left = sibling;
+  } else {
+    assert(p == g->right);
+    g->right = sibling;
+  }
+  freeNode(p);
 }
 
 void PTree::dump(llvm::raw_ostream &os) {
-  ExprPPrinter *pp = ExprPPrinter::create(os);
-  pp->setNewline("\\l");
   os << "digraph G {\n";
   os << "\tsize=\"10,7.5\";\n";
   os << "\tratio=fill;\n";
@@ -65,13 +99,7 @@ void PTree::dump(llvm::raw_ostream &os) {
   while (!stack.empty()) {
     PTree::Node *n = stack.back();
     stack.pop_back();
-    if (n->condition.isNull()) {
-      os << "\tn" << n << " [label=\"\"";
-    } else {
-      os << "\tn" << n << " [label=\"";
-      pp->print(n->condition);
-      os << "\",shape=diamond";
-    }
+    os << "\tn" << n << " [label=\"\"";
     if (n->data)
       os << ",fillcolor=green";
     os << "];\n";
@@ -85,18 +113,4 @@ void PTree::dump(llvm::raw_ostream &os) {
     }
   }
   os << "}\n";
-  delete pp;
 }
-
-PTreeNode::PTreeNode(PTreeNode *_parent, 
-                     ExecutionState *_data) 
-  : parent(_parent),
-    left(0),
-    right(0),
-    data(_data),
-    condition(0) {
-}
-
-PTreeNode::~PTreeNode() {
-}
-
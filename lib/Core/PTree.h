@@ -10,11 +10,23 @@
 #ifndef __UTIL_PTREE_H__
 #define __UTIL_PTREE_H__
 
-#include <klee/Expr.h>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+  class raw_ostream;
+}
 
 namespace klee {
   class ExecutionState;
 
+  /// PTree - The tree of forks leading to the current states.
+  ///
+  /// Each leaf holds a state, and each inner node has exactly two children:
+  /// when a leaf is removed its parent is replaced by its sibling, so
+  /// there are no chains of single-child nodes to walk through. Nodes are
+  /// allocated from blocks owned by the tree and recycled through a free
+  /// list.
   class PTree { 
     typedef ExecutionState* data_type;
 
@@ -31,6 +43,17 @@ namespace klee {
     void remove(Node *n);
 
     void dump(llvm::raw_ostream &os);
+
+  private:
+    /// The number of nodes allocated at once.
+    static const unsigned NodesPerBlock = 1024;
+
+    std::vector<Node*> blocks;
+    /// Unused nodes, linked through their left pointers.
+    Node *freeNodes;
+
+    Node *allocNode(Node *parent, const data_type &data);
+    void freeNode(Node *n);
   };
 
   class PTreeNode {
@@ -38,11 +61,9 @@ namespace klee {
   public:
     PTreeNode *parent, *left, *right;
     ExecutionState *data;
-    ref<Expr> condition;
 
   private:
-    PTreeNode(PTreeNode *_parent, ExecutionState *_data);
-    ~PTreeNode();
+    PTreeNode() {}
   };
 }
 
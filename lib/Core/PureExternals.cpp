@@ -0,0 +1,261 @@
+//===-- PureExternals.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PureExternals.h"
+#include "AddressSpace.h"
+#include "Context.h"
+#include "Memory.h"
+
+#include "klee/ExecutionState.h"
+#include "klee/Config/Version.h"
+
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#else
+#include "llvm/DerivedTypes.h"
+#include "llvm/Function.h"
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace klee;
+using namespace llvm;
+
+namespace {
+  typedef double (*DoubleFn1)(double);
+  typedef double (*DoubleFn2)(double, double);
+  typedef int (*IntFn1)(int);
+
+  enum PureKind {
+    Double1,  // double f(double)
+    Double2,  // double f(double, double)
+    Int1,     // int f(int)
+    StrLen,
+    StrCmp,
+    StrNCmp,
+    MemCmp,
+    StrChr
+  };
+
+  struct PureExternal {
+    const char *name;
+    PureKind kind;
+    void *fn;
+  };
+
+#define DOUBLE1(name) { #name, Double1, (void*) (DoubleFn1) ::name }
+#define DOUBLE2(name) { #name, Double2, (void*) (DoubleFn2) ::name }
+#define INT1(name) { #name, Int1, (void*) (IntFn1) ::name }
+
+  const PureExternal pureExternals[] = {
+    DOUBLE1(acos), DOUBLE1(asin), DOUBLE1(atan), DOUBLE1(cbrt), DOUBLE1(ceil),
+    DOUBLE1(cos), DOUBLE1(cosh), DOUBLE1(exp), DOUBLE1(fabs), DOUBLE1(floor),
+    DOUBLE1(log), DOUBLE1(log10), DOUBLE1(log2), DOUBLE1(round),
+    DOUBLE1(sin), DOUBLE1(sinh), DOUBLE1(sqrt), DOUBLE1(tan), DOUBLE1(tanh),
+    DOUBLE1(trunc),
+    DOUBLE2(atan2), DOUBLE2(fmax), DOUBLE2(fmin), DOUBLE2(fmod), DOUBLE2(pow),
+    INT1(abs), INT1(isalnum), INT1(isalpha), INT1(iscntrl), INT1(isdigit),
+    INT1(isgraph), INT1(islower), INT1(isprint), INT1(ispunct),
+    INT1(isspace), INT1(isupper), INT1(isxdigit), INT1(tolower),
+    INT1(toupper),
+    { "strlen", StrLen, 0 },
+    { "strcmp", StrCmp, 0 },
+    { "strncmp", StrNCmp, 0 },
+    { "memcmp", MemCmp, 0 },
+    { "strchr", StrChr, 0 }
+  };
+
+#undef DOUBLE1
+#undef DOUBLE2
+#undef INT1
+}
+
+static const PureExternal *lookup(const std::string &name) {
+  static std::map<std::string, const PureExternal*> table;
+  if (table.empty()) {
+    for (unsigned i = 0; i != sizeof(pureExternals) / sizeof(*pureExternals);
+         ++i)
+      table[pureExternals[i].name] = &pureExternals[i];
+  }
+
+  std::map<std::string, const PureExternal*>::iterator it = table.find(name);
+  return it == table.end() ? 0 : it->second;
+}
+
+/// Check that \a function takes \a numParams parameters, and that it and
+/// they all have a type which \a isType accepts.
+static bool hasSignature(Function *function, unsigned numParams,
+                         bool (*isType)(LLVM_TYPE_Q Type *)) {
+  LLVM_TYPE_Q FunctionType *fty = function->getFunctionType();
+  if (fty->isVarArg() || fty->getNumParams() != numParams ||
+      !isType(fty->getReturnType()))
+    return false;
+  for (unsigned i = 0; i != numParams; ++i)
+    if (!isType(fty->getParamType(i)))
+      return false;
+  return true;
+}
+
+static bool isDouble(LLVM_TYPE_Q Type *t) { return t->isDoubleTy(); }
+static bool isInt32(LLVM_TYPE_Q Type *t) { return t->isIntegerTy(32); }
+
+static double toDouble(const ref<ConstantExpr> &ce) {
+  uint64_t bits = ce->getZExtValue(64);
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+static ref<Expr> fromDouble(double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return ConstantExpr::create(bits, Expr::Int64);
+}
+
+/// Read the bytes at \a address into \a result, stopping after \a limit
+/// bytes or, if \a stopAtNul, before the first zero byte.
+///
+/// \return false if the bytes do not lie within a single object or are
+/// not all concrete.
+static bool readConcrete(ExecutionState &state, uint64_t address,
+                         uint64_t limit, bool stopAtNul,
+                         std::string &result) {
+  ObjectPair op;
+  Expr::Width width = Context::get().getPointerWidth();
+  if (!state.addressSpace.resolveOne(ConstantExpr::create(address, width), op))
+    return false;
+
+  const MemoryObject *mo = op.first;
+  for (uint64_t i = address - mo->address; result.size() != limit; ++i) {
+    if (i >= mo->size)
+      return false;
+    ConstantExpr *ce = dyn_cast<ConstantExpr>(op.second->read8(i));
+    if (!ce)
+      return false;
+    char c = (char) ce->getZExtValue(8);
+    if (stopAtNul && !c)
+      break;
+    result += c;
+  }
+
+  return true;
+}
+
+bool PureExternals::isPure(const std::string &name) {
+  return lookup(name) != 0;
+}
+
+bool PureExternals::evaluate(ExecutionState &state, Function *function,
+                             const std::vector< ref<Expr> > &arguments,
+                             ref<Expr> &result) {
+  const PureExternal *pe = lookup(function->getName().str());
+  if (!pe)
+    return false;
+
+  std::vector< ref<ConstantExpr> > args;
+  for (unsigned i = 0; i != arguments.size(); ++i) {
+    ConstantExpr *ce = dyn_cast<ConstantExpr>(arguments[i]);
+    if (!ce)
+      return false;
+    args.push_back(ce);
+  }
+
+  LLVM_TYPE_Q FunctionType *fty = function->getFunctionType();
+  Expr::Width pointerWidth = Context::get().getPointerWidth();
+  switch (pe->kind) {
+  case Double1:
+    if (args.size() != 1 || !hasSignature(function, 1, isDouble))
+      return false;
+    result = fromDouble(((DoubleFn1) pe->fn)(toDouble(args[0])));
+    return true;
+
+  case Double2:
+    if (args.size() != 2 || !hasSignature(function, 2, isDouble))
+      return false;
+    result = fromDouble(((DoubleFn2) pe->fn)(toDouble(args[0]),
+                                             toDouble(args[1])));
+    return true;
+
+  case Int1:
+    if (args.size() != 1 || !hasSignature(function, 1, isInt32))
+      return false;
+    result = ConstantExpr::create((uint32_t) ((IntFn1) pe->fn)(
+                                    (int) args[0]->getZExtValue(32)),
+                                  Expr::Int32);
+    return true;
+
+  default:
+    break;
+  }
+
+  // The string functions return a size, an int, or a pointer.
+  LLVM_TYPE_Q Type *rty = fty->getReturnType();
+  bool returnsInt = pe->kind != StrLen && pe->kind != StrChr;
+  if (fty->isVarArg() || args.size() != fty->getNumParams() ||
+      (pe->kind == StrLen && !rty->isIntegerTy(pointerWidth)) ||
+      (pe->kind == StrChr && !rty->isPointerTy()) ||
+      (returnsInt && !isInt32(rty)))
+    return false;
+  for (unsigned i = 0; i != args.size(); ++i)
+    if (args[i]->getWidth() > 64)
+      return false;
+
+  std::string a, b;
+  switch (pe->kind) {
+  case StrLen:
+    if (args.size() != 1 ||
+        !readConcrete(state, args[0]->getZExtValue(), ~0ULL, true, a))
+      return false;
+    result = ConstantExpr::create(a.size(), pointerWidth);
+    return true;
+
+  case StrCmp:
+  case StrNCmp:
+  case MemCmp: {
+    unsigned numArgs = pe->kind == StrCmp ? 2 : 3;
+    if (args.size() != numArgs)
+      return false;
+    uint64_t limit = pe->kind == StrCmp ? ~0ULL : args[2]->getZExtValue();
+    bool stopAtNul = pe->kind != MemCmp;
+    if (!readConcrete(state, args[0]->getZExtValue(), limit, stopAtNul, a) ||
+        !readConcrete(state, args[1]->getZExtValue(), limit, stopAtNul, b))
+      return false;
+    int res;
+    if (pe->kind == MemCmp)
+      res = memcmp(a.data(), b.data(), limit);
+    else
+      res = strncmp(a.c_str(), b.c_str(), std::max(a.size(), b.size()));
+    result = ConstantExpr::create((uint32_t) res, Expr::Int32);
+    return true;
+  }
+
+  case StrChr: {
+    if (args.size() != 2 ||
+        !readConcrete(state, args[0]->getZExtValue(), ~0ULL, true, a))
+      return false;
+    char c = (char) args[1]->getZExtValue();
+    // strchr can find the terminating zero byte itself.
+    size_t pos = c ? a.find(c) : a.size();
+    uint64_t address = args[0]->getZExtValue();
+    result = ConstantExpr::create(pos == std::string::npos ? 0 : address + pos,
+                                  pointerWidth);
+    return true;
+  }
+
+  default:
+    return false;
+  }
+}
@@ -0,0 +1,49 @@
+//===-- PureExternals.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PUREEXTERNALS_H
+#define KLEE_PUREEXTERNALS_H
+
+#include "klee/Expr.h"
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class Function;
+}
+
+// Pure external functions are libc and libm functions whose result only
+// depends on their arguments and the memory those point to, such as the
+// math, ctype, and str* functions. A call to one of them with concrete
+// arguments can be evaluated by calling the native function directly,
+// instead of going through the external dispatcher and copying the whole
+// address space to and from native memory.
+
+namespace klee {
+  class ExecutionState;
+
+  namespace PureExternals {
+    /// Evaluate the call of \a function with \a arguments in \a state, if
+    /// it is a known pure function and all its arguments, and the memory
+    /// it reads, are concrete.
+    ///
+    /// \param result The return value of the call.
+    /// \return true iff the call was evaluated.
+    bool evaluate(ExecutionState &state, llvm::Function *function,
+                  const std::vector< ref<Expr> > &arguments,
+                  ref<Expr> &result);
+
+    /// Return true if \a name is one of the pure functions known to
+    /// evaluate.
+    bool isPure(const std::string &name);
+  }
+}
+
+#endif
@@ -0,0 +1,222 @@
+//===-- QueryCountEstimator.cpp -------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "QueryCountEstimator.h"
+
+#include "klee/Config/Version.h"
+
+#if LLVM_VERSION_CODE > LLVM_VERSION(3, 2)
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
+#else
+#include "llvm/BasicBlock.h"
+#include "llvm/Constants.h"
+#include "llvm/Function.h"
+#include "llvm/Instructions.h"
+#include "llvm/Operator.h"
+#endif
+
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+#include "llvm/Support/CFG.h"
+#else
+#include "llvm/IR/CFG.h"
+#endif
+
+#include <cmath>
+#include <deque>
+
+using namespace llvm;
+using namespace klee;
+
+/// The factor by which each branch on the way to a query discounts it.
+static const double BranchDiscount = 0.8;
+/// Queries behind more branches than this are not counted.
+static const unsigned MaxBranches = 10;
+
+/// Return the object a pointer points into, looking through casts and
+/// address computations.
+static const Value *getBaseObject(const Value *ptr) {
+  for (;;) {
+    ptr = ptr->stripPointerCasts();
+    if (const GEPOperator *gep = dyn_cast<GEPOperator>(ptr))
+      ptr = gep->getPointerOperand();
+    else
+      return ptr;
+  }
+}
+
+/// Return true if \a ptr is the address of an alloca or a global, which is
+/// always concrete.
+static bool isDirectAddress(const Value *ptr) {
+  ptr = ptr->stripPointerCasts();
+  return isa<AllocaInst>(ptr) || isa<GlobalValue>(ptr);
+}
+
+const QueryCountEstimator::variables_ty &
+QueryCountEstimator::getDependencies(const Value *v) {
+  std::map<const Value*, variables_ty>::iterator it = dependencies.find(v);
+  if (it != dependencies.end())
+    return it->second;
+
+  // Inserted before recursing, so cycles through PHI nodes terminate.
+  variables_ty &result = dependencies[v];
+  const Instruction *inst = dyn_cast<Instruction>(v);
+  if (isa<Argument>(v)) {
+    result.insert(v);
+  } else if (inst && !isa<AllocaInst>(inst) &&
+             (!region.count(inst->getParent()) ||
+              (isa<PHINode>(inst) && inst->getParent() == joinBlock))) {
+    // Computed before the join point, so it is held in a register there.
+    // Any value used after the join point which is not computed after it
+    // is defined in a block dominating the join point.
+    result.insert(v);
+  } else if (const LoadInst *li = dyn_cast<LoadInst>(v)) {
+    const Value *base = getBaseObject(li->getPointerOperand());
+    if (isa<AllocaInst>(base) || isa<GlobalVariable>(base))
+      result.insert(base);
+    const variables_ty &deps = getDependencies(li->getPointerOperand());
+    result.insert(deps.begin(), deps.end());
+  } else if (inst && !isa<AllocaInst>(inst)) {
+    for (unsigned j = 0, e = inst->getNumOperands(); j != e; ++j) {
+      const variables_ty &deps = getDependencies(inst->getOperand(j));
+      result.insert(deps.begin(), deps.end());
+    }
+  }
+  return result;
+}
+
+void QueryCountEstimator::getQueries(BasicBlock *bb,
+                                     std::vector<const Value*> &result) {
+  for (BasicBlock::iterator it = bb->begin(), ie = bb->end(); it != ie; ++it) {
+    Instruction *i = it;
+    const Value *operand = 0;
+    switch (i->getOpcode()) {
+    case Instruction::Br: {
+      BranchInst *bi = cast<BranchInst>(i);
+      if (bi->isConditional())
+        operand = bi->getCondition();
+      break;
+    }
+    case Instruction::Switch:
+      operand = cast<SwitchInst>(i)->getCondition();
+      break;
+    case Instruction::UDiv:
+    case Instruction::SDiv:
+    case Instruction::URem:
+    case Instruction::SRem:
+      operand = i->getOperand(1);
+      break;
+    case Instruction::Load:
+      if (!isDirectAddress(cast<LoadInst>(i)->getPointerOperand()))
+        operand = cast<LoadInst>(i)->getPointerOperand();
+      break;
+    case Instruction::Store:
+      if (!isDirectAddress(cast<StoreInst>(i)->getPointerOperand()))
+        operand = cast<StoreInst>(i)->getPointerOperand();
+      break;
+    default:
+      break;
+    }
+
+    if (operand && !isa<Constant>(operand))
+      result.push_back(operand);
+  }
+}
+
+void QueryCountEstimator::analyze(Function *f) {
+  std::map<BasicBlock*, std::vector<const Value*> > queries;
+  for (Function::iterator bbit = f->begin(), bbie = f->end(); bbit != bbie;
+       ++bbit)
+    getQueries(bbit, queries[bbit]);
+
+  for (Function::iterator bbit = f->begin(), bbie = f->end(); bbit != bbie;
+       ++bbit) {
+    BasicBlock *bb = bbit;
+    pred_iterator pi = pred_begin(bb), pe = pred_end(bb);
+    if (pi == pe || ++pi == pe)
+      continue;
+
+    // Visit the blocks reachable from bb by the fewest branches taken on
+    // the way, as a breadth first search in which only branching edges
+    // count.
+    std::map<BasicBlock*, unsigned> branches;
+    std::deque<BasicBlock*> worklist;
+    std::vector<std::pair<const Value*, double> > weighted;
+    region.clear();
+    branches[bb] = 0;
+    worklist.push_back(bb);
+    while (!worklist.empty()) {
+      BasicBlock *b = worklist.front();
+      worklist.pop_front();
+      if (!region.insert(b).second)
+        continue;
+
+      unsigned n = branches[b];
+      double weight = std::pow(BranchDiscount, (double) n);
+      std::vector<const Value*> &qs = queries[b];
+      for (unsigned i = 0; i != qs.size(); ++i)
+        weighted.push_back(std::make_pair(qs[i], weight));
+
+      TerminatorInst *ti = b->getTerminator();
+      unsigned cost = ti->getNumSuccessors() > 1 ? 1 : 0;
+      if (n + cost > MaxBranches)
+        continue;
+      for (unsigned i = 0, e = ti->getNumSuccessors(); i != e; ++i) {
+        BasicBlock *succ = ti->getSuccessor(i);
+        std::map<BasicBlock*, unsigned>::iterator it = branches.find(succ);
+        if (it != branches.end() && it->second <= n + cost)
+          continue;
+        branches[succ] = n + cost;
+        if (cost)
+          worklist.push_back(succ);
+        else
+          worklist.push_front(succ);
+      }
+    }
+
+    // Which values are computed after the join point depends on the region
+    // reached from it, so the dependencies are found once it is known.
+    joinBlock = bb;
+    dependencies.clear();
+    std::map<const Value*, double> dependent;
+    double total = 0;
+    for (unsigned i = 0; i != weighted.size(); ++i) {
+      const variables_ty &deps = getDependencies(weighted[i].first);
+      if (deps.empty())
+        continue;
+      total += weighted[i].second;
+      for (variables_ty::const_iterator it = deps.begin(), ie = deps.end();
+           it != ie; ++it)
+        dependent[*it] += weighted[i].second;
+    }
+
+    MergePoint &mp = mergePoints[bb->getFirstNonPHI()];
+    mp.queries = total;
+    for (std::map<const Value*, double>::iterator it = dependent.begin(),
+           ie = dependent.end(); it != ie; ++it)
+      if (it->second >= threshold * total)
+        mp.hotVariables.push_back(it->first);
+  }
+  joinBlock = 0;
+  region.clear();
+  dependencies.clear();
+}
+
+const QueryCountEstimator::MergePoint *
+QueryCountEstimator::getMergePoint(Instruction *i) {
+  Function *f = i->getParent()->getParent();
+  if (analyzed.insert(f).second)
+    analyze(f);
+
+  std::map<Instruction*, MergePoint>::iterator it = mergePoints.find(i);
+  return it == mergePoints.end() ? 0 : &it->second;
+}
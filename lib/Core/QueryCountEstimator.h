@@ -0,0 +1,82 @@
+//===-- QueryCountEstimator.h -----------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_QUERYCOUNTESTIMATOR_H
+#define KLEE_QUERYCOUNTESTIMATOR_H
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace llvm {
+  class BasicBlock;
+  class Function;
+  class Instruction;
+  class Value;
+}
+
+namespace klee {
+  /// QueryCountEstimator - A static estimate of how many solver queries
+  /// will be issued after the join points of each function, and of which
+  /// variables those queries depend on.
+  ///
+  /// The join points are the blocks with several predecessors, which
+  /// includes the loop headers and the post-dominators of branches. The
+  /// queries are the conditional branches, switches, divisions and memory
+  /// accesses through computed addresses within a bounded number of
+  /// branches of the join point, each weighted down by the branches on the
+  /// way to it. The variables are the arguments, allocas and globals which
+  /// the operands of a query are computed from, and the registers holding
+  /// values computed before the join point, including its PHI nodes.
+  ///
+  /// A variable is hot at a join point if the queries depending on it make
+  /// up at least a given fraction of all the queries estimated there. States
+  /// which agree on the hot variables are worth merging, as the symbolic
+  /// values the merge introduces are unlikely to end up in queries.
+  class QueryCountEstimator {
+  public:
+    struct MergePoint {
+      /// The estimated number of queries issued after the merge point.
+      double queries;
+      std::vector<const llvm::Value*> hotVariables;
+    };
+
+  private:
+    typedef std::set<const llvm::Value*> variables_ty;
+
+    double threshold;
+    std::set<llvm::Function*> analyzed;
+    /// The merge points, keyed by the first non-PHI instruction of their
+    /// block.
+    std::map<llvm::Instruction*, MergePoint> mergePoints;
+
+    /// The join point being analyzed, and the blocks after it in which
+    /// queries are counted.
+    const llvm::BasicBlock *joinBlock;
+    std::set<const llvm::BasicBlock*> region;
+    /// The variables each value is computed from, for the join point being
+    /// analyzed.
+    std::map<const llvm::Value*, variables_ty> dependencies;
+
+    const variables_ty &getDependencies(const llvm::Value *v);
+    void getQueries(llvm::BasicBlock *bb,
+                    std::vector<const llvm::Value*> &result);
+    void analyze(llvm::Function *f);
+
+  public:
+    explicit QueryCountEstimator(double _threshold)
+      : threshold(_threshold), joinBlock(0) {}
+
+    /// getMergePoint - Return the merge point which starts at \a i, or null
+    /// if \a i does not start one.
+    const MergePoint *getMergePoint(llvm::Instruction *i);
+  };
+}
+
+#endif
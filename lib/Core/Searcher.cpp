@@ -11,6 +11,7 @@
 
 #include "CoreStats.h"
 #include "Executor.h"
+#include "Memory.h"
 #include "PTree.h"
 #include "StatsTracker.h"
 
@@ -42,6 +43,8 @@
 #endif
 
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <climits>
 
@@ -164,9 +167,11 @@ RandomSearcher::update(ExecutionState *current,
 
 ///
 
-WeightedRandomSearcher::WeightedRandomSearcher(WeightType _type)
+WeightedRandomSearcher::WeightedRandomSearcher(WeightType _type,
+                                               bool _lazyWeights)
   : states(new DiscretePDF<ExecutionState*>()),
-    type(_type) {
+    type(_type),
+    lazyWeights(_lazyWeights) {
   switch(type) {
   case Depth: 
     updateWeights = false;
@@ -233,8 +238,12 @@ void WeightedRandomSearcher::update(
     const std::vector<ExecutionState *> &removedStates) {
   if (current && updateWeights &&
       std::find(removedStates.begin(), removedStates.end(), current) ==
-          removedStates.end())
-    states->update(current, getWeight(current));
+          removedStates.end()) {
+    if (lazyWeights)
+      dirtyStates.insert(current);
+    else
+      states->update(current, getWeight(current));
+  }
 
   for (std::vector<ExecutionState *>::const_iterator it = addedStates.begin(),
                                                      ie = addedStates.end();
@@ -247,6 +256,8 @@ void WeightedRandomSearcher::update(
                                                      ie = removedStates.end();
        it != ie; ++it) {
     states->remove(*it);
+    if (lazyWeights)
+      dirtyStates.erase(*it);
   }
 }
 
@@ -254,6 +265,13 @@ bool WeightedRandomSearcher::empty() {
   return states->empty(); 
 }
 
+void WeightedRandomSearcher::refreshWeights() {
+  for (std::set<ExecutionState*>::iterator it = dirtyStates.begin(),
+         ie = dirtyStates.end(); it != ie; ++it)
+    states->update(*it, getWeight(*it));
+  dirtyStates.clear();
+}
+
 ///
 
 RandomPathSearcher::RandomPathSearcher(Executor &_executor)
@@ -267,19 +285,15 @@ ExecutionState &RandomPathSearcher::selectState() {
   unsigned flips=0, bits=0;
   PTree::Node *n = executor.processTree->root;
   
+  // Inner nodes of the tree always have two children.
   while (!n->data) {
-    if (!n->left) {
-      n = n->right;
-    } else if (!n->right) {
-      n = n->left;
-    } else {
-      if (bits==0) {
-        flips = theRNG.getInt32();
-        bits = 32;
-      }
-      --bits;
-      n = (flips&(1<<bits)) ? n->left : n->right;
+    assert(n->left && n->right && "inner node with a single child");
+    if (bits==0) {
+      flips = theRNG.getInt32();
+      bits = 32;
     }
+    --bits;
+    n = (flips&(1<<bits)) ? n->left : n->right;
   }
 
   return *n->data;
@@ -297,6 +311,121 @@ bool RandomPathSearcher::empty() {
 
 ///
 
+/// Return true if \a path names the file \a name, possibly through a
+/// longer path.
+static bool pathEndsWith(const std::string &path, const std::string &name) {
+  if (path.size() < name.size() ||
+      path.compare(path.size() - name.size(), name.size(), name) != 0)
+    return false;
+  return path.size() == name.size() || name[0] == '/' ||
+         path[path.size() - name.size() - 1] == '/';
+}
+
+DirectedSearcher::DirectedSearcher(Executor &_executor,
+                                   const std::string &_target)
+  : executor(_executor), target(_target), nextSequence(0) {
+  std::string::size_type colon = target.rfind(':');
+  unsigned line = 0;
+  if (colon != std::string::npos)
+    line = atoi(target.c_str() + colon + 1);
+  if (!line)
+    klee_error("invalid --target '%s' (expected <file>:<line>)",
+               target.c_str());
+  std::string file = target.substr(0, colon);
+
+  std::set<llvm::Instruction*> targets;
+  KModule *km = executor.kmodule;
+  for (std::vector<KFunction*>::iterator it = km->functions.begin(),
+         ie = km->functions.end(); it != ie; ++it) {
+    KFunction *kf = *it;
+    for (unsigned i = 0; i < kf->numInstructions; ++i) {
+      KInstruction *ki = kf->instructions[i];
+      if (ki->info->line == line && pathEndsWith(ki->info->file, file))
+        targets.insert(ki->inst);
+    }
+  }
+  if (targets.empty())
+    klee_error("no instructions found for --target '%s'", target.c_str());
+
+  executor.statsTracker->computeDistancesToTarget(targets);
+}
+
+DirectedSearcher::~DirectedSearcher() {
+}
+
+uint64_t DirectedSearcher::getDistance(ExecutionState *es) {
+  uint64_t dist = computeMinDistToTarget(*es);
+  if (dist)
+    return dist;
+  // States which have been through the target are run to completion after
+  // those which can still get there.
+  return reached.count(es) ? (uint64_t) -2 : (uint64_t) -1;
+}
+
+ExecutionState &DirectedSearcher::selectState() {
+  // States which can never reach the target sort last.
+  while (queue.size() > 1) {
+    std::map<key_ty, ExecutionState*>::iterator last = --queue.end();
+    if (last->first.first != (uint64_t) -1)
+      break;
+    ExecutionState *es = last->second;
+    queue.erase(last);
+    keys.erase(es);
+    ++stats::targetUnreachableStates;
+    executor.terminateState(*es);
+  }
+
+  return *queue.begin()->second;
+}
+
+void DirectedSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  // A state at distance one was about to execute the target, so it and any
+  // state it forked have now been through it.
+  if (current) {
+    std::map<ExecutionState*, key_ty>::iterator key = keys.find(current);
+    if (key != keys.end() && key->second.first == 1) {
+      reached.insert(current);
+      reached.insert(addedStates.begin(), addedStates.end());
+    }
+  }
+
+  for (std::vector<ExecutionState *>::const_iterator it = addedStates.begin(),
+                                                     ie = addedStates.end();
+       it != ie; ++it) {
+    key_ty key(getDistance(*it), nextSequence++);
+    queue.insert(std::make_pair(key, *it));
+    keys.insert(std::make_pair(*it, key));
+  }
+
+  for (std::vector<ExecutionState *>::const_iterator it = removedStates.begin(),
+                                                     ie = removedStates.end();
+       it != ie; ++it) {
+    reached.erase(*it);
+    // States dropped by selectState() are already gone.
+    std::map<ExecutionState*, key_ty>::iterator key = keys.find(*it);
+    if (key != keys.end()) {
+      queue.erase(key->second);
+      keys.erase(key);
+    }
+  }
+
+  if (current) {
+    std::map<ExecutionState*, key_ty>::iterator key = keys.find(current);
+    if (key != keys.end()) {
+      uint64_t dist = getDistance(current);
+      if (dist != key->second.first) {
+        queue.erase(key->second);
+        key->second.first = dist;
+        queue.insert(std::make_pair(key->second, current));
+      }
+    }
+  }
+}
+
+///
+
 BumpMergingSearcher::BumpMergingSearcher(Executor &_executor, Searcher *_baseSearcher) 
   : executor(_executor),
     baseSearcher(_baseSearcher),
@@ -506,6 +635,185 @@ MergingSearcher::update(ExecutionState *current,
 
 ///
 
+QCEMergingSearcher::QCEMergingSearcher(Executor &_executor,
+                                       Searcher *_baseSearcher,
+                                       double hotThreshold)
+  : executor(_executor),
+    baseSearcher(_baseSearcher),
+    estimator(hotThreshold) {
+}
+
+QCEMergingSearcher::~QCEMergingSearcher() {
+  delete baseSearcher;
+}
+
+static const MemoryObject *findAlloca(const StackFrame &sf,
+                                      const llvm::Value *allocSite) {
+  for (std::vector<const MemoryObject*>::const_reverse_iterator
+         it = sf.allocas.rbegin(), ie = sf.allocas.rend(); it != ie; ++it)
+    if ((*it)->allocSite == allocSite)
+      return *it;
+  return 0;
+}
+
+/// Return true if the frames \a a and \a b hold the same value in
+/// register \a reg.
+static bool sameLocal(const StackFrame &a, const StackFrame &b, unsigned reg) {
+  ref<Expr> av = a.locals[reg].value, bv = b.locals[reg].value;
+  if (av.isNull() || bv.isNull())
+    return av.isNull() && bv.isNull();
+  return av == bv;
+}
+
+unsigned QCEMergingSearcher::getRegister(KFunction *kf,
+                                         const llvm::Instruction *i) {
+  std::map<const llvm::Instruction*, unsigned>::iterator it =
+    registers.find(i);
+  if (it == registers.end()) {
+    for (unsigned k = 0; k != kf->numInstructions; ++k)
+      registers[kf->instructions[k]->inst] = kf->instructions[k]->dest;
+    it = registers.find(i);
+    assert(it != registers.end() && "instruction not in function");
+  }
+  return it->second;
+}
+
+bool QCEMergingSearcher::canMerge(const QueryCountEstimator::MergePoint &mp,
+                                  const ExecutionState &a,
+                                  const ExecutionState &b) {
+  if (a.stack.size() != b.stack.size() ||
+      a.stack.back().kf != b.stack.back().kf)
+    return false;
+
+  const StackFrame &af = a.stack.back(), &bf = b.stack.back();
+  for (std::vector<const llvm::Value*>::const_iterator
+         it = mp.hotVariables.begin(), ie = mp.hotVariables.end();
+       it != ie; ++it) {
+    if (const Argument *arg = dyn_cast<Argument>(*it)) {
+      if (!sameLocal(af, bf, af.kf->getArgRegister(arg->getArgNo())))
+        return false;
+      continue;
+    }
+    if (isa<Instruction>(*it) && !isa<AllocaInst>(*it)) {
+      if (!sameLocal(af, bf, getRegister(af.kf, cast<Instruction>(*it))))
+        return false;
+      continue;
+    }
+
+    const MemoryObject *amo, *bmo;
+    if (const GlobalValue *gv = dyn_cast<GlobalValue>(*it)) {
+      std::map<const llvm::GlobalValue*, MemoryObject*>::iterator gi =
+        executor.globalObjects.find(gv);
+      amo = bmo = gi == executor.globalObjects.end() ? 0 : gi->second;
+    } else {
+      amo = findAlloca(af, *it);
+      bmo = findAlloca(bf, *it);
+    }
+    if (amo != bmo)
+      return false;
+    if (!amo)
+      continue;
+
+    const ObjectState *aos = a.addressSpace.findObject(amo);
+    const ObjectState *bos = b.addressSpace.findObject(bmo);
+    if (aos != bos && (!aos || !bos || !aos->equals(*bos)))
+      return false;
+  }
+
+  return true;
+}
+
+void QCEMergingSearcher::release(ExecutionState *es) {
+  releasedStates.insert(es);
+  baseSearcher->addState(es);
+}
+
+ExecutionState &QCEMergingSearcher::selectState() {
+  for (;;) {
+    if (baseSearcher->empty()) {
+      std::map<Instruction*, ExecutionState*>::iterator it =
+        statesAtMerge.begin();
+      ExecutionState *es = it->second;
+      statesAtMerge.erase(it);
+      release(es);
+    }
+
+    ExecutionState &es = baseSearcher->selectState();
+    // Searchers which pick from the process tree can pick states which
+    // were merged away during this step.
+    if (mergedStates.count(&es))
+      continue;
+    if (releasedStates.erase(&es))
+      return es;
+
+    Instruction *i = es.pc->inst;
+    const QueryCountEstimator::MergePoint *mp = estimator.getMergePoint(i);
+    if (!mp)
+      return es;
+
+    std::map<Instruction*, ExecutionState*>::iterator it =
+      statesAtMerge.find(i);
+    if (it != statesAtMerge.end() && it->second == &es) {
+      // Likewise, those can pick a held state; let it go only once every
+      // other state is held as well.
+      if (executor.states.size() > statesAtMerge.size() + mergedStates.size())
+        continue;
+      statesAtMerge.erase(it);
+      baseSearcher->addState(&es);
+      return es;
+    }
+
+    baseSearcher->removeState(&es);
+    if (it == statesAtMerge.end()) {
+      statesAtMerge.insert(std::make_pair(i, &es));
+      continue;
+    }
+
+    ExecutionState *mergeWith = it->second;
+    if (canMerge(*mp, *mergeWith, es) && mergeWith->merge(es)) {
+      ++stats::mergedStates;
+      stats::mergeQueriesSaved += (uint64_t) (mp->queries + 0.5);
+      mergedStates.insert(&es);
+      executor.terminateState(es);
+    } else {
+      it->second = &es; // the bump
+      release(mergeWith);
+    }
+  }
+}
+
+void
+QCEMergingSearcher::update(ExecutionState *current,
+                           const std::vector<ExecutionState *> &addedStates,
+                           const std::vector<ExecutionState *> &removedStates) {
+  // Merged and held states are not in the base searcher.
+  std::vector<ExecutionState *> alt;
+  for (std::vector<ExecutionState *>::const_iterator
+         it = removedStates.begin(), ie = removedStates.end();
+       it != ie; ++it) {
+    ExecutionState *es = *it;
+    if (mergedStates.erase(es))
+      continue;
+    releasedStates.erase(es);
+
+    bool held = false;
+    for (std::map<Instruction*, ExecutionState*>::iterator
+           it2 = statesAtMerge.begin(), ie2 = statesAtMerge.end();
+         it2 != ie2; ++it2) {
+      if (it2->second == es) {
+        statesAtMerge.erase(it2);
+        held = true;
+        break;
+      }
+    }
+    if (!held)
+      alt.push_back(es);
+  }
+  baseSearcher->update(current, addedStates, alt);
+}
+
+///
+
 BatchingSearcher::BatchingSearcher(Searcher *_baseSearcher,
                                    double _timeBudget,
                                    unsigned _instructionBudget) 
@@ -634,3 +942,133 @@ void InterleavedSearcher::update(
          ie = searchers.end(); it != ie; ++it)
     (*it)->update(current, addedStates, removedStates);
 }
+
+///
+
+BanditSearcher::BanditSearcher(Executor &_executor,
+                               const std::vector<Searcher*> &_searchers,
+                               Policy _policy, unsigned _pullInstructions)
+  : executor(_executor),
+    searchers(_searchers),
+    policy(_policy),
+    pullInstructions(_pullInstructions),
+    currentStrategy(0),
+    startInstructions(0),
+    startGain(0),
+    startTime(0.),
+    strategies(_searchers.size()),
+    rates(_searchers.size(), 0.),
+    weights(_searchers.size(), 1.),
+    maxRate(0.) {
+  for (unsigned i = 0; i != strategies.size(); ++i) {
+    strategies[i].pulls = 0;
+    strategies[i].gain = 0;
+    strategies[i].time = 0.;
+  }
+  pickStrategy();
+}
+
+BanditSearcher::~BanditSearcher() {
+  for (std::vector<Searcher*>::const_iterator it = searchers.begin(),
+         ie = searchers.end(); it != ie; ++it)
+    delete *it;
+}
+
+uint64_t BanditSearcher::getGain() {
+  return stats::coveredInstructions + executor.getHandler().getNumTestCases();
+}
+
+/// The fraction of pulls EXP3 spreads evenly over all searchers.
+static const double ExplorationRate = 0.1;
+
+double BanditSearcher::getProbability(unsigned i, double totalWeight) {
+  return (1. - ExplorationRate) * weights[i] / totalWeight +
+         ExplorationRate / weights.size();
+}
+
+void BanditSearcher::endPull() {
+  uint64_t gain = getGain() - startGain;
+  double time = std::max(util::getWallTime() - startTime, 1e-6);
+  StrategyStats &s = strategies[currentStrategy];
+  ++s.pulls;
+  s.gain += gain;
+  s.time += time;
+
+  double rate = gain / time;
+  maxRate = std::max(maxRate, rate);
+  double reward = maxRate > 0. ? rate / maxRate : 0.;
+  rates[currentStrategy] += rate;
+
+  if (policy == EXP3) {
+    double totalWeight = 0.;
+    for (unsigned i = 0; i != weights.size(); ++i)
+      totalWeight += weights[i];
+    double estimate = reward / getProbability(currentStrategy, totalWeight);
+    weights[currentStrategy] *=
+      exp(ExplorationRate * estimate / weights.size());
+
+    // Keep the weights in range; only their ratios matter.
+    double maxWeight = *std::max_element(weights.begin(), weights.end());
+    for (unsigned i = 0; i != weights.size(); ++i)
+      weights[i] /= maxWeight;
+  }
+}
+
+void BanditSearcher::pickStrategy() {
+  unsigned n = searchers.size();
+  if (policy == UCB1) {
+    uint64_t totalPulls = 0;
+    for (unsigned i = 0; i != n; ++i)
+      totalPulls += strategies[i].pulls;
+
+    double best = -1.;
+    for (unsigned i = 0; i != n; ++i) {
+      // Every searcher gets a first pull.
+      if (!strategies[i].pulls) {
+        currentStrategy = i;
+        break;
+      }
+      double mean =
+        maxRate > 0. ? rates[i] / strategies[i].pulls / maxRate : 0.;
+      double score = mean + sqrt(2. * log((double) totalPulls) /
+                                 strategies[i].pulls);
+      if (score > best) {
+        best = score;
+        currentStrategy = i;
+      }
+    }
+  } else {
+    double totalWeight = 0.;
+    for (unsigned i = 0; i != n; ++i)
+      totalWeight += weights[i];
+    double p = theRNG.getDoubleL();
+    currentStrategy = n - 1;
+    for (unsigned i = 0; i != n - 1; ++i) {
+      p -= getProbability(i, totalWeight);
+      if (p < 0.) {
+        currentStrategy = i;
+        break;
+      }
+    }
+  }
+
+  startInstructions = stats::instructions;
+  startGain = getGain();
+  startTime = util::getWallTime();
+}
+
+ExecutionState &BanditSearcher::selectState() {
+  if (stats::instructions - startInstructions >= pullInstructions) {
+    endPull();
+    pickStrategy();
+  }
+  return searchers[currentStrategy]->selectState();
+}
+
+void BanditSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  for (std::vector<Searcher*>::const_iterator it = searchers.begin(),
+         ie = searchers.end(); it != ie; ++it)
+    (*it)->update(current, addedStates, removedStates);
+}
@@ -10,11 +10,14 @@
 #ifndef KLEE_SEARCHER_H
 #define KLEE_SEARCHER_H
 
+#include "QueryCountEstimator.h"
+
 #include "llvm/Support/raw_ostream.h"
 #include <vector>
 #include <set>
 #include <map>
 #include <queue>
+#include <string>
 
 namespace llvm {
   class BasicBlock;
@@ -27,6 +30,17 @@ namespace klee {
   template<class T> class DiscretePDF;
   class ExecutionState;
   class Executor;
+  struct KFunction;
+
+  /// StrategyStats - How often an adaptive searcher picked one of its
+  /// strategies, and what that earned.
+  struct StrategyStats {
+    uint64_t pulls;
+    /// New covered instructions plus new test cases.
+    uint64_t gain;
+    /// Wall time in seconds.
+    double time;
+  };
 
   class Searcher {
   public:
@@ -52,6 +66,14 @@ namespace klee {
     virtual void activate() {}
     virtual void deactivate() {}
 
+    /// refreshWeights - Recompute any state weights whose update was
+    /// deferred. Called periodically when weight updates are batched.
+    virtual void refreshWeights() {}
+
+    /// getStrategyStats - Append the statistics of each strategy of an
+    /// adaptive searcher to \a result.
+    virtual void getStrategyStats(std::vector<StrategyStats> &result) {}
+
     // utility functions
 
     void addState(ExecutionState *es, ExecutionState *current = 0) {
@@ -137,11 +159,16 @@ namespace klee {
     DiscretePDF<ExecutionState*> *states;
     WeightType type;
     bool updateWeights;
+    /// Whether the weight of the current state is only recomputed by
+    /// refreshWeights(), rather than after every step.
+    bool lazyWeights;
+    /// The states whose weights are out of date.
+    std::set<ExecutionState*> dirtyStates;
     
     double getWeight(ExecutionState*);
 
   public:
-    WeightedRandomSearcher(WeightType type);
+    WeightedRandomSearcher(WeightType type, bool lazyWeights = false);
     ~WeightedRandomSearcher();
 
     ExecutionState &selectState();
@@ -149,6 +176,7 @@ namespace klee {
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates);
     bool empty();
+    void refreshWeights();
     void printName(llvm::raw_ostream &os) {
       os << "WeightedRandomSearcher::";
       switch(type) {
@@ -180,6 +208,40 @@ namespace klee {
     }
   };
 
+  /// DirectedSearcher - Run the state closest to a target line first.
+  ///
+  /// Distances are measured over the interprocedural control flow graph,
+  /// taking the return addresses on the stack of each state into account.
+  /// States which cannot reach the target any more are terminated as long
+  /// as there is another state to run.
+  class DirectedSearcher : public Searcher {
+    /// States are ordered by distance, then by when they were added.
+    typedef std::pair<uint64_t, uint64_t> key_ty;
+
+    Executor &executor;
+    std::string target;
+    std::map<key_ty, ExecutionState*> queue;
+    std::map<ExecutionState*, key_ty> keys;
+    /// The states which have executed the target.
+    std::set<ExecutionState*> reached;
+    uint64_t nextSequence;
+
+    uint64_t getDistance(ExecutionState *es);
+
+  public:
+    DirectedSearcher(Executor &executor, const std::string &target);
+    ~DirectedSearcher();
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState *> &addedStates,
+                const std::vector<ExecutionState *> &removedStates);
+    bool empty() { return queue.empty(); }
+    void printName(llvm::raw_ostream &os) {
+      os << "DirectedSearcher: " << target << "\n";
+    }
+  };
+
   class MergingSearcher : public Searcher {
     Executor &executor;
     std::set<ExecutionState*> statesAtMerge;
@@ -198,6 +260,10 @@ namespace klee {
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates);
     bool empty() { return baseSearcher->empty() && statesAtMerge.empty(); }
+    void refreshWeights() { baseSearcher->refreshWeights(); }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      baseSearcher->getStrategyStats(result);
+    }
     void printName(llvm::raw_ostream &os) {
       os << "MergingSearcher\n";
     }
@@ -221,11 +287,63 @@ namespace klee {
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates);
     bool empty() { return baseSearcher->empty() && statesAtMerge.empty(); }
+    void refreshWeights() { baseSearcher->refreshWeights(); }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      baseSearcher->getStrategyStats(result);
+    }
     void printName(llvm::raw_ostream &os) {
       os << "BumpMergingSearcher\n";
     }
   };
 
+  /// QCEMergingSearcher - Merges states at the join points of the CFG
+  /// without any klee_merge calls, when the QueryCountEstimator expects the
+  /// merge to pay off.
+  ///
+  /// As for the BumpMergingSearcher, a state reaching a join point is held
+  /// there until another state arrives at the same point. The two are
+  /// merged if they agree on the variables which the queries after the
+  /// join point depend on; otherwise the held state is let go and the new
+  /// one takes its place. Held states are let go one at a time when the
+  /// base searcher runs out of states.
+  class QCEMergingSearcher : public Searcher {
+    Executor &executor;
+    Searcher *baseSearcher;
+    QueryCountEstimator estimator;
+    std::map<llvm::Instruction*, ExecutionState*> statesAtMerge;
+    /// States which were let go at their join point, and should not be
+    /// held there again.
+    std::set<ExecutionState*> releasedStates;
+    /// States which were merged into others, and which the base searcher
+    /// no longer knows of.
+    std::set<ExecutionState*> mergedStates;
+    /// The register of each instruction of the functions seen so far.
+    std::map<const llvm::Instruction*, unsigned> registers;
+
+    unsigned getRegister(KFunction *kf, const llvm::Instruction *i);
+    bool canMerge(const QueryCountEstimator::MergePoint &mp,
+                  const ExecutionState &a, const ExecutionState &b);
+    void release(ExecutionState *es);
+
+  public:
+    QCEMergingSearcher(Executor &executor, Searcher *baseSearcher,
+                       double hotThreshold);
+    ~QCEMergingSearcher();
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState *> &addedStates,
+                const std::vector<ExecutionState *> &removedStates);
+    bool empty() { return baseSearcher->empty() && statesAtMerge.empty(); }
+    void refreshWeights() { baseSearcher->refreshWeights(); }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      baseSearcher->getStrategyStats(result);
+    }
+    void printName(llvm::raw_ostream &os) {
+      os << "QCEMergingSearcher\n";
+    }
+  };
+
   class BatchingSearcher : public Searcher {
     Searcher *baseSearcher;
     double timeBudget;
@@ -246,6 +364,10 @@ namespace klee {
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates);
     bool empty() { return baseSearcher->empty(); }
+    void refreshWeights() { baseSearcher->refreshWeights(); }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      baseSearcher->getStrategyStats(result);
+    }
     void printName(llvm::raw_ostream &os) {
       os << "<BatchingSearcher> timeBudget: " << timeBudget
          << ", instructionBudget: " << instructionBudget
@@ -269,6 +391,10 @@ namespace klee {
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates);
     bool empty() { return baseSearcher->empty() && pausedStates.empty(); }
+    void refreshWeights() { baseSearcher->refreshWeights(); }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      baseSearcher->getStrategyStats(result);
+    }
     void printName(llvm::raw_ostream &os) {
       os << "IterativeDeepeningTimeSearcher\n";
     }
@@ -289,6 +415,16 @@ namespace klee {
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates);
     bool empty() { return searchers[0]->empty(); }
+    void refreshWeights() {
+      for (searchers_ty::iterator it = searchers.begin(), ie = searchers.end();
+           it != ie; ++it)
+        (*it)->refreshWeights();
+    }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      for (searchers_ty::iterator it = searchers.begin(), ie = searchers.end();
+           it != ie; ++it)
+        (*it)->getStrategyStats(result);
+    }
     void printName(llvm::raw_ostream &os) {
       os << "<InterleavedSearcher> containing "
          << searchers.size() << " searchers:\n";
@@ -299,6 +435,75 @@ namespace klee {
     }
   };
 
+  /// BanditSearcher - Pick between several searchers, giving more time to
+  /// the ones which have recently paid off.
+  ///
+  /// The searchers take turns in pulls of a fixed number of instructions.
+  /// The reward of a pull is the new coverage and test cases it produced
+  /// per second, scaled by the best rate seen so far, and the next searcher
+  /// is picked by UCB1 or EXP3 over those rewards.
+  class BanditSearcher : public Searcher {
+  public:
+    enum Policy {
+      UCB1,
+      EXP3
+    };
+
+  private:
+    typedef std::vector<Searcher*> searchers_ty;
+
+    Executor &executor;
+    searchers_ty searchers;
+    Policy policy;
+    unsigned pullInstructions;
+
+    /// The searcher running now, and the counters when it was picked.
+    unsigned currentStrategy;
+    uint64_t startInstructions, startGain;
+    double startTime;
+
+    std::vector<StrategyStats> strategies;
+    /// The sum of the rates of the pulls of each searcher (UCB1).
+    std::vector<double> rates;
+    /// The weight of each searcher (EXP3).
+    std::vector<double> weights;
+    double maxRate;
+
+    uint64_t getGain();
+    double getProbability(unsigned i, double totalWeight);
+    void endPull();
+    void pickStrategy();
+
+  public:
+    BanditSearcher(Executor &executor, const searchers_ty &_searchers,
+                   Policy policy, unsigned pullInstructions);
+    ~BanditSearcher();
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState *> &addedStates,
+                const std::vector<ExecutionState *> &removedStates);
+    bool empty() { return searchers[0]->empty(); }
+    void refreshWeights() {
+      for (searchers_ty::iterator it = searchers.begin(), ie = searchers.end();
+           it != ie; ++it)
+        (*it)->refreshWeights();
+    }
+    void getStrategyStats(std::vector<StrategyStats> &result) {
+      result.insert(result.end(), strategies.begin(), strategies.end());
+    }
+    void printName(llvm::raw_ostream &os) {
+      os << "<BanditSearcher> policy: "
+         << (policy == UCB1 ? "UCB1" : "EXP3") << ", pull instructions: "
+         << pullInstructions << ", containing "
+         << searchers.size() << " searchers:\n";
+      for (searchers_ty::iterator it = searchers.begin(), ie = searchers.end();
+           it != ie; ++it)
+        (*it)->printName(os);
+      os << "</BanditSearcher>\n";
+    }
+  };
+
 }
 
 #endif
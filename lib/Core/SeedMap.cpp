@@ -0,0 +1,137 @@
+//===-- SeedMap.cpp -------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SeedMap.h"
+
+#include "klee/ExecutionState.h"
+#include "klee/util/ExprUtil.h"
+
+#include <cassert>
+#include <map>
+
+using namespace klee;
+
+bool SeedMap::count(const ExecutionState *es) const {
+  return es->seedSlot != ~0U;
+}
+
+const SeedMap::seeds_ty &SeedMap::getSeeds(const ExecutionState *es) const {
+  assert(count(es) && "state has no seeds");
+  return entries[es->seedSlot].seeds;
+}
+
+void SeedMap::add(ExecutionState *es, unsigned seed) {
+  if (!count(es)) {
+    if (freeEntries.empty()) {
+      es->seedSlot = entries.size();
+      entries.push_back(Entry());
+    } else {
+      es->seedSlot = freeEntries.back();
+      freeEntries.pop_back();
+    }
+    Entry &entry = entries[es->seedSlot];
+    entry.state = es;
+    entry.pass = virtualTime;
+    queue.insert(std::make_pair(entry.pass, es->seedSlot));
+    ++numStates;
+  }
+  entries[es->seedSlot].seeds.push_back(seed);
+  ++numSeeds;
+}
+
+void SeedMap::take(ExecutionState *es, seeds_ty &result) {
+  if (!count(es))
+    return;
+  Entry &entry = entries[es->seedSlot];
+  numSeeds -= entry.seeds.size();
+  result.clear();
+  result.swap(entry.seeds);
+  erase(es);
+}
+
+void SeedMap::erase(ExecutionState *es) {
+  if (!count(es))
+    return;
+  Entry &entry = entries[es->seedSlot];
+  queue.erase(std::make_pair(entry.pass, es->seedSlot));
+  numSeeds -= entry.seeds.size();
+  --numStates;
+  entry.state = 0;
+  entry.seeds.clear();
+  freeEntries.push_back(es->seedSlot);
+  es->seedSlot = ~0U;
+}
+
+ExecutionState *SeedMap::selectState() {
+  assert(!queue.empty() && "no seeded states");
+  const std::pair<double, unsigned> &first = *queue.begin();
+  virtualTime = first.first;
+  return entries[first.second].state;
+}
+
+void SeedMap::stepped(ExecutionState *es) {
+  if (!count(es))
+    return;
+  Entry &entry = entries[es->seedSlot];
+  queue.erase(std::make_pair(entry.pass, es->seedSlot));
+  entry.pass += 1. / entry.seeds.size();
+  queue.insert(std::make_pair(entry.pass, es->seedSlot));
+}
+
+void SeedMap::evaluate(const seeds_ty &seeds, ref<Expr> e,
+                       std::vector< ref<Expr> > &values,
+                       std::vector<unsigned> &classes) {
+  values.clear();
+  classes.assign(seeds.size(), 0);
+  if (isa<ConstantExpr>(e)) {
+    values.push_back(e);
+    return;
+  }
+
+  // The symbolic bytes e reads; a read at a symbolic index may read any
+  // byte of its array.
+  std::set< std::pair<const Array*, unsigned> > positionSet;
+  std::vector< ref<ReadExpr> > reads;
+  findReads(e, /* visitUpdates= */ true, reads);
+  for (unsigned i = 0; i != reads.size(); ++i) {
+    const Array *root = reads[i]->updates.root;
+    if (!root || root->isConstantArray())
+      continue;
+    if (ConstantExpr *CE = dyn_cast<ConstantExpr>(reads[i]->index)) {
+      positionSet.insert(std::make_pair(root, (unsigned) CE->getZExtValue()));
+    } else {
+      for (unsigned j = 0; j != root->size; ++j)
+        positionSet.insert(std::make_pair(root, j));
+    }
+  }
+  std::vector< std::pair<const Array*, unsigned> >
+    positions(positionSet.begin(), positionSet.end());
+
+  std::map<std::vector<int>, unsigned> classOf;
+  std::vector<int> key(positions.size());
+  for (unsigned i = 0; i != seeds.size(); ++i) {
+    Assignment &assignment = pool[seeds[i]].assignment;
+    for (unsigned j = 0; j != positions.size(); ++j) {
+      Assignment::bindings_ty::const_iterator it =
+        assignment.bindings.find(positions[j].first);
+      if (it != assignment.bindings.end() &&
+          positions[j].second < it->second.size())
+        key[j] = it->second[positions[j].second];
+      else
+        key[j] = -1;
+    }
+
+    std::map<std::vector<int>, unsigned>::iterator it = classOf.find(key);
+    if (it == classOf.end()) {
+      it = classOf.insert(std::make_pair(key, (unsigned) values.size())).first;
+      values.push_back(assignment.evaluate(e));
+    }
+    classes[i] = it->second;
+  }
+}
@@ -0,0 +1,95 @@
+//===-- SeedMap.h -----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SEEDMAP_H
+#define KLEE_SEEDMAP_H
+
+#include "SeedInfo.h"
+
+#include "klee/Expr.h"
+
+#include <set>
+#include <vector>
+
+namespace klee {
+  class ExecutionState;
+
+  /// SeedMap - The seeds of the seeded states, and the order in which the
+  /// seeded states are run.
+  ///
+  /// Every seed belongs to at most one state, so the seeds are kept in one
+  /// pool and states only hold their indices, which move between states
+  /// without copying the seeds. A seeded state finds its seeds through its
+  /// seedSlot, and the number of seeds and seeded states is kept up to
+  /// date as seeds move.
+  ///
+  /// States are run in proportion to the number of seeds they hold: each
+  /// state has a pass which grows by the inverse of its seed count for
+  /// every instruction it runs, and the state with the lowest pass runs
+  /// next.
+  class SeedMap {
+  public:
+    typedef std::vector<unsigned> seeds_ty;
+
+  private:
+    struct Entry {
+      ExecutionState *state;
+      seeds_ty seeds;
+      double pass;
+    };
+
+    std::vector<SeedInfo> pool;
+    std::vector<Entry> entries;
+    std::vector<unsigned> freeEntries;
+    /// The seeded states by pass, as (pass, slot) pairs.
+    std::set<std::pair<double, unsigned> > queue;
+    unsigned numSeeds, numStates;
+    /// The pass of the last state selected, which new states start from.
+    double virtualTime;
+
+  public:
+    SeedMap() : numSeeds(0), numStates(0), virtualTime(0.) {}
+
+    /// addSeed - Add a seed to the pool, and return its index.
+    unsigned addSeed(KTest *input) {
+      pool.push_back(SeedInfo(input));
+      return pool.size() - 1;
+    }
+    SeedInfo &getSeed(unsigned seed) { return pool[seed]; }
+
+    bool empty() const { return numStates == 0; }
+    unsigned getNumSeeds() const { return numSeeds; }
+    unsigned getNumStates() const { return numStates; }
+
+    bool count(const ExecutionState *es) const;
+    const seeds_ty &getSeeds(const ExecutionState *es) const;
+
+    /// add - Give \a seed to \a es.
+    void add(ExecutionState *es, unsigned seed);
+    /// take - Move the seeds of \a es to \a result, leaving \a es unseeded.
+    void take(ExecutionState *es, seeds_ty &result);
+    /// erase - Drop the seeds of \a es, if it has any.
+    void erase(ExecutionState *es);
+
+    /// selectState - Return the seeded state to run next.
+    ExecutionState *selectState();
+    /// stepped - Charge \a es for running an instruction.
+    void stepped(ExecutionState *es);
+
+    /// evaluate - Evaluate \a e under the assignments of \a seeds at once.
+    /// Seeds which agree on all the bytes \a e reads share one evaluation:
+    /// on return \a values holds the distinct results, and \a classes the
+    /// index into \a values of the result of each seed.
+    void evaluate(const seeds_ty &seeds, ref<Expr> e,
+                  std::vector< ref<Expr> > &values,
+                  std::vector<unsigned> &classes);
+  };
+}
+
+#endif
@@ -0,0 +1,67 @@
+//===-- StateRegistry.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATEREGISTRY_H
+#define KLEE_STATEREGISTRY_H
+
+#include "klee/ExecutionState.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace klee {
+  /// StateRegistry - The set of states of the executor.
+  ///
+  /// The states are kept packed in an array for iteration and random
+  /// sampling, and each state knows its position, so inserting and
+  /// removing a state take constant time. The positions of the states
+  /// change when states are removed or swapped.
+  class StateRegistry {
+    std::vector<ExecutionState*> states;
+
+  public:
+    typedef std::vector<ExecutionState*>::const_iterator iterator;
+
+    iterator begin() const { return states.begin(); }
+    iterator end() const { return states.end(); }
+    unsigned size() const { return states.size(); }
+    bool empty() const { return states.empty(); }
+    ExecutionState *operator[](unsigned index) const { return states[index]; }
+
+    bool contains(const ExecutionState *es) const {
+      return es->registryIndex < states.size() &&
+             states[es->registryIndex] == es;
+    }
+
+    void insert(ExecutionState *es) {
+      assert(!contains(es) && "state already registered");
+      es->registryIndex = states.size();
+      states.push_back(es);
+    }
+
+    void erase(ExecutionState *es) {
+      assert(contains(es) && "state not registered");
+      ExecutionState *last = states.back();
+      states[es->registryIndex] = last;
+      last->registryIndex = es->registryIndex;
+      states.pop_back();
+      es->registryIndex = ~0U;
+    }
+
+    /// swap - Exchange the positions of the states at \a i and \a j.
+    void swap(unsigned i, unsigned j) {
+      std::swap(states[i], states[j]);
+      states[i]->registryIndex = i;
+      states[j]->registryIndex = j;
+    }
+  };
+}
+
+#endif
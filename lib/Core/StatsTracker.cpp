@@ -25,6 +25,7 @@
 #include "CoreStats.h"
 #include "Executor.h"
 #include "MemoryManager.h"
+#include "Searcher.h"
 #include "UserSearcher.h"
 
 #if LLVM_VERSION_CODE > LLVM_VERSION(3, 2)
@@ -59,6 +60,7 @@
 
 #include <fstream>
 #include <unistd.h>
+#include <vector>
 
 using namespace klee;
 using namespace llvm;
@@ -149,6 +151,15 @@ namespace klee {
     
     void run() { statsTracker->computeReachableUncovered(); }
   };
+
+  class RefreshWeightsTimer : public Executor::Timer {
+    StatsTracker *statsTracker;
+    
+  public:
+    RefreshWeightsTimer(StatsTracker *_statsTracker) : statsTracker(_statsTracker) {}
+    
+    void run() { statsTracker->refreshSearcherWeights(); }
+  };
  
 }
 
@@ -218,7 +229,7 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     }
   }
 
-  if (OutputIStats)
+  if (OutputIStats || userSearcherRequiresTargetDistances())
     theStatisticManager->useIndexedStats(km->infos->getMaxID());
 
   for (std::vector<KFunction*>::iterator it = km->functions.begin(), 
@@ -260,6 +271,10 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     executor.addTimer(new UpdateReachableTimer(this), UncoveredUpdateInterval);
   }
 
+  if (userSearcherWeightRefreshInterval() > 0)
+    executor.addTimer(new RefreshWeightsTimer(this),
+                      userSearcherWeightRefreshInterval());
+
   if (OutputIStats) {
     istatsFile = executor.interpreterHandler->openOutputFile("run.istats");
     assert(istatsFile && "unable to open istats file");
@@ -287,6 +302,12 @@ void StatsTracker::done() {
   }
 }
 
+void StatsTracker::refreshSearcherWeights() {
+  // The searcher is only created once execution starts.
+  if (executor.searcher)
+    executor.searcher->refreshWeights();
+}
+
 void StatsTracker::stepInstruction(ExecutionState &es) {
   if (OutputIStats) {
     if (TrackInstructionTime) {
@@ -420,6 +441,15 @@ void StatsTracker::writeStatsHeader() {
              << "'CexCacheTime',"
              << "'ForkTime',"
              << "'ResolveTime',"
+             << "'NumResolutions',"
+             << "'NumResolveQueries',"
+             << "'ResolutionCacheHits',"
+             << "'ResolutionCacheMisses',";
+  for (unsigned i = 0; i != userSearcherNumStrategies(); ++i)
+    *statsFile << "'Strategy" << i << "Pulls',"
+               << "'Strategy" << i << "Gain',"
+               << "'Strategy" << i << "Time',";
+  *statsFile
 #ifdef DEBUG
 	     << "'ArrayHashTime',"
 #endif
@@ -450,6 +480,26 @@ void StatsTracker::writeStatsLine() {
              << "," << stats::cexCacheTime / 1000000.
              << "," << stats::forkTime / 1000000.
              << "," << stats::resolveTime / 1000000.
+             << "," << stats::resolutions
+             << "," << stats::resolveQueries
+             << "," << stats::resolutionCacheHits
+             << "," << stats::resolutionCacheMisses;
+
+  // Keep the last statistics of the searcher for the line written once it
+  // is gone.
+  if (executor.searcher) {
+    strategyStats.clear();
+    executor.searcher->getStrategyStats(strategyStats);
+  }
+  for (unsigned i = 0; i != userSearcherNumStrategies(); ++i) {
+    if (i < strategyStats.size())
+      *statsFile << "," << strategyStats[i].pulls
+                 << "," << strategyStats[i].gain
+                 << "," << strategyStats[i].time;
+    else
+      *statsFile << ",0,0,0";
+  }
+  *statsFile
 #ifdef DEBUG
              << "," << stats::arrayHashTime / 1000000.
 #endif
@@ -458,7 +508,7 @@ void StatsTracker::writeStatsLine() {
 }
 
 void StatsTracker::updateStateStatistics(uint64_t addend) {
-  for (std::set<ExecutionState*>::iterator it = executor.states.begin(),
+  for (StateRegistry::iterator it = executor.states.begin(),
          ie = executor.states.end(); it != ie; ++it) {
     ExecutionState &state = **it;
     const InstructionInfo &ii = *state.pc->info;
@@ -470,7 +520,6 @@ void StatsTracker::updateStateStatistics(uint64_t addend) {
 
 void StatsTracker::writeIStats() {
   Module *m = executor.kmodule->module;
-  uint64_t istatsMask = 0;
   llvm::raw_fd_ostream &of = *istatsFile;
   
   // We assume that we didn't move the file pointer
@@ -486,26 +535,26 @@ void StatsTracker::writeIStats() {
   
   StatisticManager &sm = *theStatisticManager;
   unsigned nStats = sm.getNumStatistics();
-
-  // Max is 13, sadly
-  istatsMask |= 1<<sm.getStatisticID("Queries");
-  istatsMask |= 1<<sm.getStatisticID("QueriesValid");
-  istatsMask |= 1<<sm.getStatisticID("QueriesInvalid");
-  istatsMask |= 1<<sm.getStatisticID("QueryTime");
-  istatsMask |= 1<<sm.getStatisticID("ResolveTime");
-  istatsMask |= 1<<sm.getStatisticID("Instructions");
-  istatsMask |= 1<<sm.getStatisticID("InstructionTimes");
-  istatsMask |= 1<<sm.getStatisticID("InstructionRealTimes");
-  istatsMask |= 1<<sm.getStatisticID("Forks");
-  istatsMask |= 1<<sm.getStatisticID("CoveredInstructions");
-  istatsMask |= 1<<sm.getStatisticID("UncoveredInstructions");
-  istatsMask |= 1<<sm.getStatisticID("States");
-  istatsMask |= 1<<sm.getStatisticID("MinDistToUncovered");
+  std::vector<bool> istatsMask(nStats, false);
+
+  istatsMask[sm.getStatisticID("Queries")] = true;
+  istatsMask[sm.getStatisticID("QueriesValid")] = true;
+  istatsMask[sm.getStatisticID("QueriesInvalid")] = true;
+  istatsMask[sm.getStatisticID("QueryTime")] = true;
+  istatsMask[sm.getStatisticID("ResolveTime")] = true;
+  istatsMask[sm.getStatisticID("Instructions")] = true;
+  istatsMask[sm.getStatisticID("InstructionTimes")] = true;
+  istatsMask[sm.getStatisticID("InstructionRealTimes")] = true;
+  istatsMask[sm.getStatisticID("Forks")] = true;
+  istatsMask[sm.getStatisticID("CoveredInstructions")] = true;
+  istatsMask[sm.getStatisticID("UncoveredInstructions")] = true;
+  istatsMask[sm.getStatisticID("States")] = true;
+  istatsMask[sm.getStatisticID("MinDistToUncovered")] = true;
 
   of << "positions: instr line\n";
 
   for (unsigned i=0; i<nStats; i++) {
-    if (istatsMask & (1<<i)) {
+    if (istatsMask[i]) {
       Statistic &s = sm.getStatistic(i);
       of << "event: " << s.getShortName() << " : " 
          << s.getName() << "\n";
@@ -514,14 +563,14 @@ void StatsTracker::writeIStats() {
 
   of << "events: ";
   for (unsigned i=0; i<nStats; i++) {
-    if (istatsMask & (1<<i))
+    if (istatsMask[i])
       of << sm.getStatistic(i).getShortName() << " ";
   }
   of << "\n";
   
   // set state counts, decremented after we process so that we don't
   // have to zero all records each time.
-  if (istatsMask & (1<<stats::states.getID()))
+  if (istatsMask[stats::states.getID()])
     updateStateStatistics(1);
 
   std::string sourceFile = "";
@@ -559,7 +608,7 @@ void StatsTracker::writeIStats() {
           of << ii.assemblyLine << " ";
           of << ii.line << " ";
           for (unsigned i=0; i<nStats; i++)
-            if (istatsMask&(1<<i))
+            if (istatsMask[i])
               of << sm.getIndexedValue(sm.getStatistic(i), index) << " ";
           of << "\n";
 
@@ -585,7 +634,7 @@ void StatsTracker::writeIStats() {
                 of << ii.assemblyLine << " ";
                 of << ii.line << " ";
                 for (unsigned i=0; i<nStats; i++) {
-                  if (istatsMask&(1<<i)) {
+                  if (istatsMask[i]) {
                     Statistic &s = sm.getStatistic(i);
                     uint64_t value;
 
@@ -609,7 +658,7 @@ void StatsTracker::writeIStats() {
     }
   }
 
-  if (istatsMask & (1<<stats::states.getID()))
+  if (istatsMask[stats::states.getID()])
     updateStateStatistics((uint64_t)-1);
   
   // Clear then end of the file if necessary (no truncate op?).
@@ -642,14 +691,16 @@ static std::vector<Instruction*> getSuccs(Instruction *i) {
   return res;
 }
 
-uint64_t klee::computeMinDistToUncovered(const KInstruction *ki,
-                                         uint64_t minDistAtRA) {
+/// Return the minimum distance from \a ki to an instruction with a nonzero
+/// \a dist, allowing a return to a caller which is \a minDistAtRA away.
+static uint64_t computeMinDist(const Statistic &dist, const KInstruction *ki,
+                               uint64_t minDistAtRA) {
   StatisticManager &sm = *theStatisticManager;
   if (minDistAtRA==0) { // unreachable on return, best is local
-    return sm.getIndexedValue(stats::minDistToUncovered,
+    return sm.getIndexedValue(dist,
                               ki->info->id);
   } else {
-    uint64_t minDistLocal = sm.getIndexedValue(stats::minDistToUncovered,
+    uint64_t minDistLocal = sm.getIndexedValue(dist,
                                                ki->info->id);
     uint64_t distToReturn = sm.getIndexedValue(stats::minDistToReturn,
                                                ki->info->id);
@@ -664,159 +715,184 @@ uint64_t klee::computeMinDistToUncovered(const KInstruction *ki,
   }
 }
 
-void StatsTracker::computeReachableUncovered() {
+uint64_t klee::computeMinDistToUncovered(const KInstruction *ki,
+                                         uint64_t minDistAtRA) {
+  return computeMinDist(stats::minDistToUncovered, ki, minDistAtRA);
+}
+
+uint64_t klee::computeMinDistToTarget(const ExecutionState &es) {
+  uint64_t currentFrameMinDist = 0;
+  for (ExecutionState::stack_ty::const_iterator sfIt = es.stack.begin(),
+         sf_ie = es.stack.end(); sfIt != sf_ie; ++sfIt) {
+    ExecutionState::stack_ty::const_iterator next = sfIt + 1;
+    KInstIterator kii;
+
+    if (next==es.stack.end()) {
+      kii = es.pc;
+    } else {
+      kii = next->caller;
+      ++kii;
+    }
+
+    currentFrameMinDist = computeMinDist(stats::minDistToTarget, kii,
+                                         currentFrameMinDist);
+  }
+  return currentFrameMinDist;
+}
+
+void StatsTracker::computeCallGraph() {
+  static bool init = true;
+  if (!init)
+    return;
+  init = false;
+
   KModule *km = executor.kmodule;
   Module *m = km->module;
-  static bool init = true;
   const InstructionInfoTable &infos = *km->infos;
   StatisticManager &sm = *theStatisticManager;
-  
-  if (init) {
-    init = false;
-
-    // Compute call targets. It would be nice to use alias information
-    // instead of assuming all indirect calls hit all escaping
-    // functions, eh?
-    for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
-         fnIt != fn_ie; ++fnIt) {
-      for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
-           bbIt != bb_ie; ++bbIt) {
-        for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
-             it != ie; ++it) {
-          if (isa<CallInst>(it) || isa<InvokeInst>(it)) {
-            CallSite cs(it);
-            if (isa<InlineAsm>(cs.getCalledValue())) {
-              // We can never call through here so assume no targets
-              // (which should be correct anyhow).
-              callTargets.insert(std::make_pair(it,
-                                                std::vector<Function*>()));
-            } else if (Function *target = getDirectCallTarget(cs)) {
-              callTargets[it].push_back(target);
-            } else {
-              callTargets[it] = 
-                std::vector<Function*>(km->escapingFunctions.begin(),
-                                       km->escapingFunctions.end());
-            }
+
+  // Compute call targets. It would be nice to use alias information
+  // instead of assuming all indirect calls hit all escaping
+  // functions, eh?
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
+       fnIt != fn_ie; ++fnIt) {
+    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
+         bbIt != bb_ie; ++bbIt) {
+      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
+           it != ie; ++it) {
+        if (isa<CallInst>(it) || isa<InvokeInst>(it)) {
+          CallSite cs(it);
+          if (isa<InlineAsm>(cs.getCalledValue())) {
+            // We can never call through here so assume no targets
+            // (which should be correct anyhow).
+            callTargets.insert(std::make_pair(it,
+                                              std::vector<Function*>()));
+          } else if (Function *target = getDirectCallTarget(cs)) {
+            callTargets[it].push_back(target);
+          } else {
+            callTargets[it] = 
+              std::vector<Function*>(km->escapingFunctions.begin(),
+                                     km->escapingFunctions.end());
           }
         }
       }
     }
+  }
 
-    // Compute function callers as reflexion of callTargets.
-    for (calltargets_ty::iterator it = callTargets.begin(), 
-           ie = callTargets.end(); it != ie; ++it)
-      for (std::vector<Function*>::iterator fit = it->second.begin(), 
-             fie = it->second.end(); fit != fie; ++fit) 
-        functionCallers[*fit].push_back(it->first);
-
-    // Initialize minDistToReturn to shortest paths through
-    // functions. 0 is unreachable.
-    std::vector<Instruction *> instructions;
-    for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
-         fnIt != fn_ie; ++fnIt) {
-      if (fnIt->isDeclaration()) {
-        if (fnIt->doesNotReturn()) {
-          functionShortestPath[fnIt] = 0;
-        } else {
-          functionShortestPath[fnIt] = 1; // whatever
-        }
-      } else {
+  // Compute function callers as reflexion of callTargets.
+  for (calltargets_ty::iterator it = callTargets.begin(), 
+         ie = callTargets.end(); it != ie; ++it)
+    for (std::vector<Function*>::iterator fit = it->second.begin(), 
+           fie = it->second.end(); fit != fie; ++fit) 
+      functionCallers[*fit].push_back(it->first);
+
+  // Initialize minDistToReturn to shortest paths through
+  // functions. 0 is unreachable.
+  std::vector<Instruction *> instructions;
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
+       fnIt != fn_ie; ++fnIt) {
+    if (fnIt->isDeclaration()) {
+      if (fnIt->doesNotReturn()) {
         functionShortestPath[fnIt] = 0;
+      } else {
+        functionShortestPath[fnIt] = 1; // whatever
       }
+    } else {
+      functionShortestPath[fnIt] = 0;
+    }
 
-      // Not sure if I should bother to preorder here. XXX I should.
-      for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
-           bbIt != bb_ie; ++bbIt) {
-        for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
-             it != ie; ++it) {
-          instructions.push_back(it);
-          unsigned id = infos.getInfo(it).id;
-          sm.setIndexedValue(stats::minDistToReturn, 
-                             id, 
-                             isa<ReturnInst>(it)
+    // Not sure if I should bother to preorder here. XXX I should.
+    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
+         bbIt != bb_ie; ++bbIt) {
+      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
+           it != ie; ++it) {
+        instructions.push_back(it);
+        unsigned id = infos.getInfo(it).id;
+        sm.setIndexedValue(stats::minDistToReturn, 
+                           id, 
+                           isa<ReturnInst>(it)
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 1)
-                             || isa<UnwindInst>(it)
+                           || isa<UnwindInst>(it)
 #endif
-                             );
-        }
+                           );
       }
     }
+  }
+
+  std::reverse(instructions.begin(), instructions.end());
   
-    std::reverse(instructions.begin(), instructions.end());
-    
-    // I'm so lazy it's not even worklisted.
-    bool changed;
-    do {
-      changed = false;
-      for (std::vector<Instruction*>::iterator it = instructions.begin(),
-             ie = instructions.end(); it != ie; ++it) {
-        Instruction *inst = *it;
-        unsigned bestThrough = 0;
-
-        if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
-          std::vector<Function*> &targets = callTargets[inst];
-          for (std::vector<Function*>::iterator fnIt = targets.begin(),
-                 ie = targets.end(); fnIt != ie; ++fnIt) {
-            uint64_t dist = functionShortestPath[*fnIt];
-            if (dist) {
-              dist = 1+dist; // count instruction itself
-              if (bestThrough==0 || dist<bestThrough)
-                bestThrough = dist;
-            }
+  // I'm so lazy it's not even worklisted.
+  bool changed;
+  do {
+    changed = false;
+    for (std::vector<Instruction*>::iterator it = instructions.begin(),
+           ie = instructions.end(); it != ie; ++it) {
+      Instruction *inst = *it;
+      unsigned bestThrough = 0;
+
+      if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
+        std::vector<Function*> &targets = callTargets[inst];
+        for (std::vector<Function*>::iterator fnIt = targets.begin(),
+               ie = targets.end(); fnIt != ie; ++fnIt) {
+          uint64_t dist = functionShortestPath[*fnIt];
+          if (dist) {
+            dist = 1+dist; // count instruction itself
+            if (bestThrough==0 || dist<bestThrough)
+              bestThrough = dist;
           }
-        } else {
-          bestThrough = 1;
         }
-       
-        if (bestThrough) {
-          unsigned id = infos.getInfo(*it).id;
-          uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToReturn, id);
-          std::vector<Instruction*> succs = getSuccs(*it);
-          for (std::vector<Instruction*>::iterator it2 = succs.begin(),
-                 ie = succs.end(); it2 != ie; ++it2) {
-            uint64_t dist = sm.getIndexedValue(stats::minDistToReturn,
-                                               infos.getInfo(*it2).id);
-            if (dist) {
-              uint64_t val = bestThrough + dist;
-              if (best==0 || val<best)
-                best = val;
-            }
-          }
-          // there's a corner case here when a function only includes a single
-          // instruction (a ret). in that case, we MUST update
-          // functionShortestPath, or it will remain 0 (erroneously indicating
-          // that no return instructions are reachable)
-          Function *f = inst->getParent()->getParent();
-          if (best != cur
-              || (inst == f->begin()->begin()
-                  && functionShortestPath[f] != best)) {
-            sm.setIndexedValue(stats::minDistToReturn, id, best);
-            changed = true;
-
-            // Update shortest path if this is the entry point.
-            if (inst==f->begin()->begin())
-              functionShortestPath[f] = best;
+      } else {
+        bestThrough = 1;
+      }
+     
+      if (bestThrough) {
+        unsigned id = infos.getInfo(*it).id;
+        uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToReturn, id);
+        std::vector<Instruction*> succs = getSuccs(*it);
+        for (std::vector<Instruction*>::iterator it2 = succs.begin(),
+               ie = succs.end(); it2 != ie; ++it2) {
+          uint64_t dist = sm.getIndexedValue(stats::minDistToReturn,
+                                             infos.getInfo(*it2).id);
+          if (dist) {
+            uint64_t val = bestThrough + dist;
+            if (best==0 || val<best)
+              best = val;
           }
         }
+        // there's a corner case here when a function only includes a single
+        // instruction (a ret). in that case, we MUST update
+        // functionShortestPath, or it will remain 0 (erroneously indicating
+        // that no return instructions are reachable)
+        Function *f = inst->getParent()->getParent();
+        if (best != cur
+            || (inst == f->begin()->begin()
+                && functionShortestPath[f] != best)) {
+          sm.setIndexedValue(stats::minDistToReturn, id, best);
+          changed = true;
+
+          // Update shortest path if this is the entry point.
+          if (inst==f->begin()->begin())
+            functionShortestPath[f] = best;
+        }
       }
-    } while (changed);
-  }
+    }
+  } while (changed);
+}
+
+void StatsTracker::computeMinDistances(const Statistic &minDist) {
+  KModule *km = executor.kmodule;
+  Module *m = km->module;
+  const InstructionInfoTable &infos = *km->infos;
+  StatisticManager &sm = *theStatisticManager;
 
-  // compute minDistToUncovered, 0 is unreachable
   std::vector<Instruction *> instructions;
   for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
        fnIt != fn_ie; ++fnIt) {
-    // Not sure if I should bother to preorder here.
     for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
          bbIt != bb_ie; ++bbIt) {
       for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
-           it != ie; ++it) {
-        unsigned id = infos.getInfo(it).id;
+           it != ie; ++it)
         instructions.push_back(&*it);
-        sm.setIndexedValue(stats::minDistToUncovered, 
-                           id, 
-                           sm.getIndexedValue(stats::uncoveredInstructions, id));
-      }
     }
   }
   
@@ -829,7 +905,7 @@ void StatsTracker::computeReachableUncovered() {
     for (std::vector<Instruction*>::iterator it = instructions.begin(),
            ie = instructions.end(); it != ie; ++it) {
       Instruction *inst = *it;
-      uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToUncovered, 
+      uint64_t best, cur = best = sm.getIndexedValue(minDist,
                                                      infos.getInfo(inst).id);
       unsigned bestThrough = 0;
       
@@ -845,7 +921,7 @@ void StatsTracker::computeReachableUncovered() {
           }
 
           if (!(*fnIt)->isDeclaration()) {
-            uint64_t calleeDist = sm.getIndexedValue(stats::minDistToUncovered,
+            uint64_t calleeDist = sm.getIndexedValue(minDist,
                                                      infos.getFunctionInfo(*fnIt).id);
             if (calleeDist) {
               calleeDist = 1+calleeDist; // count instruction itself
@@ -862,7 +938,7 @@ void StatsTracker::computeReachableUncovered() {
         std::vector<Instruction*> succs = getSuccs(inst);
         for (std::vector<Instruction*>::iterator it2 = succs.begin(),
                ie = succs.end(); it2 != ie; ++it2) {
-          uint64_t dist = sm.getIndexedValue(stats::minDistToUncovered,
+          uint64_t dist = sm.getIndexedValue(minDist,
                                              infos.getInfo(*it2).id);
           if (dist) {
             uint64_t val = bestThrough + dist;
@@ -873,15 +949,42 @@ void StatsTracker::computeReachableUncovered() {
       }
 
       if (best != cur) {
-        sm.setIndexedValue(stats::minDistToUncovered, 
+        sm.setIndexedValue(minDist, 
                            infos.getInfo(inst).id, 
                            best);
         changed = true;
       }
     }
   } while (changed);
+}
 
-  for (std::set<ExecutionState*>::iterator it = executor.states.begin(),
+void StatsTracker::computeReachableUncovered() {
+  KModule *km = executor.kmodule;
+  Module *m = km->module;
+  const InstructionInfoTable &infos = *km->infos;
+  StatisticManager &sm = *theStatisticManager;
+  
+  computeCallGraph();
+
+  // compute minDistToUncovered, 0 is unreachable
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
+       fnIt != fn_ie; ++fnIt) {
+    // Not sure if I should bother to preorder here.
+    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
+         bbIt != bb_ie; ++bbIt) {
+      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
+           it != ie; ++it) {
+        unsigned id = infos.getInfo(it).id;
+        sm.setIndexedValue(stats::minDistToUncovered, 
+                           id, 
+                           sm.getIndexedValue(stats::uncoveredInstructions, id));
+      }
+    }
+  }
+  
+  computeMinDistances(stats::minDistToUncovered);
+
+  for (StateRegistry::iterator it = executor.states.begin(),
          ie = executor.states.end(); it != ie; ++it) {
     ExecutionState *es = *it;
     uint64_t currentFrameMinDist = 0;
@@ -903,3 +1006,27 @@ void StatsTracker::computeReachableUncovered() {
     }
   }
 }
+
+void StatsTracker::computeDistancesToTarget(
+    const std::set<Instruction*> &targets) {
+  KModule *km = executor.kmodule;
+  Module *m = km->module;
+  const InstructionInfoTable &infos = *km->infos;
+  StatisticManager &sm = *theStatisticManager;
+
+  computeCallGraph();
+
+  // compute minDistToTarget, 0 is unreachable
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
+       fnIt != fn_ie; ++fnIt) {
+    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
+         bbIt != bb_ie; ++bbIt) {
+      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
+           it != ie; ++it)
+        sm.setIndexedValue(stats::minDistToTarget, infos.getInfo(it).id,
+                           targets.count(&*it));
+    }
+  }
+
+  computeMinDistances(stats::minDistToTarget);
+}
@@ -11,6 +11,7 @@
 #define KLEE_STATSTRACKER_H
 
 #include "CallPathManager.h"
+#include "Searcher.h"
 
 #include <set>
 
@@ -28,10 +29,12 @@ namespace klee {
   class InterpreterHandler;
   struct KInstruction;
   struct StackFrame;
+  class Statistic;
 
   class StatsTracker {
     friend class WriteStatsTimer;
     friend class WriteIStatsTimer;
+    friend class RefreshWeightsTimer;
 
     Executor &executor;
     std::string objectFilename;
@@ -46,6 +49,9 @@ namespace klee {
 
     bool updateMinDistToUncovered;
 
+    /// The statistics of the strategies of the searcher.
+    std::vector<StrategyStats> strategyStats;
+
   public:
     static bool useStatistics();
 
@@ -54,6 +60,12 @@ namespace klee {
     void writeStatsHeader();
     void writeStatsLine();
     void writeIStats();
+    void refreshSearcherWeights();
+    void computeCallGraph();
+    /// Propagate the instruction level statistic \a minDist, which is
+    /// nonzero at the instructions to reach, backwards over the
+    /// interprocedural control flow graph.
+    void computeMinDistances(const Statistic &minDist);
 
   public:
     StatsTracker(Executor &_executor, std::string _objectFilename,
@@ -83,11 +95,19 @@ namespace klee {
     double elapsed();
 
     void computeReachableUncovered();
+
+    /// Compute the minDistToTarget statistic for reaching any of \a targets.
+    void computeDistancesToTarget(const std::set<llvm::Instruction*> &targets);
   };
 
   uint64_t computeMinDistToUncovered(const KInstruction *ki,
                                      uint64_t minDistAtRA);
 
+  /// Return the distance from the current instruction of \a es to the
+  /// target, taking the return addresses on its stack into account, or 0 if
+  /// the target is unreachable. Requires computeDistancesToTarget().
+  uint64_t computeMinDistToTarget(const ExecutionState &es);
+
 }
 
 #endif
@@ -12,6 +12,7 @@
 #include "klee/Config/Version.h"
 #include "klee/ExecutionState.h"
 #include "klee/Solver.h"
+#include "klee/SolverImpl.h"
 #include "klee/Statistics.h"
 #include "klee/Internal/System/Time.h"
 
@@ -139,6 +140,38 @@ TimingSolver::getInitialValues(const ExecutionState& state,
   return success;
 }
 
+bool TimingSolver::getModel(const ExecutionState& state, ref<Expr> expr,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &result,
+                            bool &hasSolution) {
+  // Fast path, to avoid timer and OS overhead.
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(expr)) {
+    if (CE->isFalse()) {
+      hasSolution = false;
+      return true;
+    }
+  }
+
+  sys::TimeValue now = util::getWallTimeVal();
+
+  if (simplifyExprs)
+    expr = state.constraints.simplifyExpr(expr);
+
+  // computeInitialValues() produces a counterexample to the query
+  // expression, so ask for one to its negation. Unlike
+  // getInitialValues() this keeps failure and unsatisfiability apart.
+  bool success = solver->impl->computeInitialValues(
+      Query(state.constraints, Expr::createIsZero(expr)), objects, result,
+      hasSolution);
+
+  sys::TimeValue delta = util::getWallTimeVal();
+  delta -= now;
+  stats::solverTime += delta.usec();
+  state.queryCost += delta.usec()/1000000.;
+
+  return success;
+}
+
 std::pair< ref<Expr>, ref<Expr> >
 TimingSolver::getRange(const ExecutionState& state, ref<Expr> expr) {
   return solver->getRange(Query(state.constraints, expr));
@@ -63,6 +63,17 @@ namespace klee {
                           const std::vector<const Array*> &objects,
                           std::vector< std::vector<unsigned char> > &result);
 
+    /// getModel - Compute an assignment for the given objects which
+    /// satisfies the state's constraints together with \a expr.
+    ///
+    /// \param [out] hasSolution - On success, whether such an
+    /// assignment exists.
+    /// \return True on success.
+    bool getModel(const ExecutionState&, ref<Expr> expr,
+                  const std::vector<const Array*> &objects,
+                  std::vector< std::vector<unsigned char> > &result,
+                  bool &hasSolution);
+
     std::pair< ref<Expr>, ref<Expr> >
     getRange(const ExecutionState&, ref<Expr> query);
   };
@@ -33,6 +33,11 @@ namespace {
 			clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost"),
 			clEnumValEnd));
 
+  cl::opt<std::string>
+  Target("target",
+         cl::desc("Run the states closest to <file>:<line> first, and drop states which cannot reach it (off by default)"),
+         cl::value_desc("file:line"));
+
   cl::opt<bool>
   UseIterativeDeepeningTimeSearch("use-iterative-deepening-time-search", 
                                     cl::desc("(experimental)"));
@@ -53,6 +58,28 @@ namespace {
             cl::init(5.0));
 
 
+  cl::opt<double>
+  WeightRefreshInterval("weight-refresh-interval",
+                        cl::desc("Recompute the weights of states for the nurs searchers only every this many seconds, instead of after every step (default=0 (off))"),
+                        cl::init(0.));
+
+  cl::opt<bool>
+  UseBanditSearch("use-bandit-search",
+                  cl::desc("Pick between several search heuristics by how much new coverage and how many test cases each has recently produced, instead of in turn (default=off)"));
+
+  cl::opt<BanditSearcher::Policy>
+  BanditPolicy("bandit-policy",
+               cl::desc("Policy for --use-bandit-search (default=ucb1)"),
+               cl::values(clEnumValN(BanditSearcher::UCB1, "ucb1", "Upper confidence bound"),
+                          clEnumValN(BanditSearcher::EXP3, "exp3", "Exponential weights"),
+                          clEnumValEnd),
+               cl::init(BanditSearcher::UCB1));
+
+  cl::opt<unsigned>
+  BanditPullInstructions("bandit-pull-instructions",
+                         cl::desc("Number of instructions a heuristic picked by --use-bandit-search runs for (default=10000)"),
+                         cl::init(10000));
+
   cl::opt<bool>
   UseMerge("use-merge", 
            cl::desc("Enable support for klee_merge() (experimental)"));
@@ -61,6 +88,15 @@ namespace {
   UseBumpMerge("use-bump-merge", 
            cl::desc("Enable support for klee_merge() (extra experimental)"));
 
+  cl::opt<bool>
+  UseQCEMerge("use-qce-merge",
+              cl::desc("Merge states at the join points of the CFG, unless the queries expected after the join point depend on values the states differ in (experimental)"));
+
+  cl::opt<double>
+  QCEHotThreshold("qce-hot-threshold",
+                  cl::desc("Fraction of the queries expected after a join point which have to depend on a value for states differing in it not to be merged by --use-qce-merge (default=0.1)"),
+                  cl::init(0.1));
+
 }
 
 
@@ -72,20 +108,38 @@ bool klee::userSearcherRequiresMD2U() {
 	  std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::NURS_QC) != CoreSearch.end());
 }
 
+bool klee::userSearcherRequiresTargetDistances() {
+  return !Target.empty();
+}
+
+unsigned klee::userSearcherNumStrategies() {
+  if (!UseBanditSearch)
+    return 0;
+  unsigned n = (CoreSearch.empty() && Target.empty()) ? 2 : CoreSearch.size();
+  if (!Target.empty())
+    ++n;
+  return n > 1 ? n : 0;
+}
+
+double klee::userSearcherWeightRefreshInterval() {
+  return WeightRefreshInterval;
+}
+
 
 Searcher *getNewSearcher(Searcher::CoreSearchType type, Executor &executor) {
   Searcher *searcher = NULL;
+  bool lazyWeights = WeightRefreshInterval > 0;
   switch (type) {
   case Searcher::DFS: searcher = new DFSSearcher(); break;
   case Searcher::BFS: searcher = new BFSSearcher(); break;
   case Searcher::RandomState: searcher = new RandomSearcher(); break;
   case Searcher::RandomPath: searcher = new RandomPathSearcher(executor); break;
-  case Searcher::NURS_CovNew: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::CoveringNew); break;
-  case Searcher::NURS_MD2U: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::MinDistToUncovered); break;
-  case Searcher::NURS_Depth: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::Depth); break;
-  case Searcher::NURS_ICnt: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::InstCount); break;
-  case Searcher::NURS_CPICnt: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::CPInstCount); break;
-  case Searcher::NURS_QC: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::QueryCost); break;
+  case Searcher::NURS_CovNew: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::CoveringNew, lazyWeights); break;
+  case Searcher::NURS_MD2U: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::MinDistToUncovered, lazyWeights); break;
+  case Searcher::NURS_Depth: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::Depth, lazyWeights); break;
+  case Searcher::NURS_ICnt: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::InstCount, lazyWeights); break;
+  case Searcher::NURS_CPICnt: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::CPInstCount, lazyWeights); break;
+  case Searcher::NURS_QC: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::QueryCost, lazyWeights); break;
   }
 
   return searcher;
@@ -94,21 +148,25 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, Executor &executor) {
 Searcher *klee::constructUserSearcher(Executor &executor) {
 
   // default values
-  if (CoreSearch.size() == 0) {
+  if (CoreSearch.size() == 0 && Target.empty()) {
     CoreSearch.push_back(Searcher::RandomPath);
     CoreSearch.push_back(Searcher::NURS_CovNew);
   }
 
-  Searcher *searcher = getNewSearcher(CoreSearch[0], executor);
-  
-  if (CoreSearch.size() > 1) {
-    std::vector<Searcher *> s;
-    s.push_back(searcher);
-
-    for (unsigned i=1; i<CoreSearch.size(); i++)
-      s.push_back(getNewSearcher(CoreSearch[i], executor));
-    
-    searcher = new InterleavedSearcher(s);
+  // A target is searched for first, interleaved with any --search given.
+  std::vector<Searcher *> s;
+  if (!Target.empty())
+    s.push_back(new DirectedSearcher(executor, Target));
+  for (unsigned i=0; i<CoreSearch.size(); i++)
+    s.push_back(getNewSearcher(CoreSearch[i], executor));
+
+  Searcher *searcher = s[0];
+  if (s.size() > 1) {
+    if (UseBanditSearch)
+      searcher = new BanditSearcher(executor, s, BanditPolicy,
+                                    BanditPullInstructions);
+    else
+      searcher = new InterleavedSearcher(s);
   }
 
   if (UseBatchingSearch) {
@@ -122,6 +180,8 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
     searcher = new MergingSearcher(executor, searcher);
   } else if (UseBumpMerge) {
     searcher = new BumpMergingSearcher(executor, searcher);
+  } else if (UseQCEMerge) {
+    searcher = new QCEMergingSearcher(executor, searcher, QCEHotThreshold);
   }
   
   if (UseIterativeDeepeningTimeSearch) {
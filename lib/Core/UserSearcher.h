@@ -17,6 +17,19 @@ namespace klee {
   // XXX gross, should be on demand?
   bool userSearcherRequiresMD2U();
 
+  /// userSearcherRequiresTargetDistances - Return true if a --target was
+  /// given, which needs the distances computed by the StatsTracker.
+  bool userSearcherRequiresTargetDistances();
+
+  /// userSearcherWeightRefreshInterval - Return the number of seconds
+  /// between recomputations of the weights of the random searchers, or 0 if
+  /// they are recomputed after every step.
+  double userSearcherWeightRefreshInterval();
+
+  /// userSearcherNumStrategies - Return the number of heuristics the bandit
+  /// searcher picks between, or 0 if it is not used.
+  unsigned userSearcherNumStrategies();
+
   Searcher *constructUserSearcher(Executor &executor);
 }
 
@@ -0,0 +1,680 @@
+//===-- AbstractDomain.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/util/AbstractDomain.h"
+
+#include "klee/util/ExprHashMap.h"
+
+#include <algorithm>
+
+using namespace klee;
+
+/// The largest range of constant array entries joined for a read at a
+/// symbolic index.
+static const uint64_t MaxConstantArrayScan = 4096;
+
+/// How deep into a constraint refinement will look.
+static const unsigned MaxRefineDepth = 16;
+
+static inline int64_t signExtend(uint64_t value, Expr::Width width) {
+  if (width >= 64)
+    return (int64_t) value;
+  unsigned shift = 64 - width;
+  return ((int64_t) (value << shift)) >> shift;
+}
+
+/// Compute the signed bounds of \a v, which are the full signed range if the
+/// unsigned interval crosses the sign boundary.
+static void getSignedBounds(const AbstractValue &v, int64_t &lo, int64_t &hi) {
+  uint64_t signBit = (uint64_t) 1 << (v.width - 1);
+  if (v.max < signBit || v.min >= signBit) {
+    lo = signExtend(v.min, v.width);
+    hi = signExtend(v.max, v.width);
+  } else {
+    lo = signExtend(signBit, v.width);
+    hi = (int64_t) (signBit - 1);
+  }
+}
+
+static AbstractValue boolValue(bool value) {
+  return AbstractValue::constant(value, Expr::Bool);
+}
+
+/***/
+
+void AbstractValue::normalize() {
+  uint64_t M = mask(width);
+  knownZero &= M;
+  knownOne &= M;
+  max = std::min(max, M);
+  min = std::max(min, knownOne);
+  max = std::min(max, M & ~knownZero);
+
+  if (min <= max && !(knownZero & knownOne)) {
+    // All values in the interval share the bits above the highest bit in
+    // which its bounds differ.
+    uint64_t low = min ^ max;
+    for (unsigned shift = 1; shift < 64; shift <<= 1)
+      low |= low >> shift;
+    uint64_t common = M & ~low;
+    knownOne |= min & common;
+    knownZero |= ~min & common;
+  }
+
+  if (min > max || (knownZero & knownOne)) {
+    min = 1;
+    max = 0;
+    knownZero = knownOne = 0;
+  }
+}
+
+AbstractValue AbstractValue::meet(const AbstractValue &b) const {
+  assert(width == b.width && "meet of values of different width");
+  if (isEmpty())
+    return *this;
+  if (b.isEmpty())
+    return b;
+  return AbstractValue(width, std::max(min, b.min), std::min(max, b.max),
+                       knownZero | b.knownZero, knownOne | b.knownOne);
+}
+
+AbstractValue AbstractValue::join(const AbstractValue &b) const {
+  assert(width == b.width && "join of values of different width");
+  if (isEmpty())
+    return b;
+  if (b.isEmpty())
+    return *this;
+  return AbstractValue(width, std::min(min, b.min), std::max(max, b.max),
+                       knownZero & b.knownZero, knownOne & b.knownOne);
+}
+
+/***/
+
+class AbstractDomain::Evaluator {
+  const AbstractDomain &domain;
+  ExprHashMap<AbstractValue> cache;
+
+  AbstractValue evalRead(const ReadExpr &re) {
+    const Array *root = re.updates.root;
+    Expr::Width w = re.getWidth();
+    if (re.index->getWidth() > 64)
+      return AbstractValue::top(w);
+    AbstractValue index = eval(re.index);
+
+    if (!index.isConstant()) {
+      if (re.updates.head || !root->isConstantArray() ||
+          index.max >= root->size || index.max - index.min >= MaxConstantArrayScan)
+        return AbstractValue::top(w);
+      AbstractValue result(w, 1, 0);
+      for (uint64_t i = index.min; i <= index.max; ++i)
+        result = result.join(AbstractValue::constant(
+                               root->constantValues[i]->getZExtValue(), w));
+      return result;
+    }
+
+    // Join every update which may write the index, stopping at the first
+    // which certainly does.
+    uint64_t i = index.min;
+    AbstractValue result(w, 1, 0);
+    for (const UpdateNode *un = re.updates.head; un; un = un->next) {
+      if (un->index->getWidth() > 64)
+        return AbstractValue::top(w);
+      AbstractValue ui = eval(un->index);
+      if (ui.meet(AbstractValue::constant(i, ui.width)).isEmpty())
+        continue;
+      result = result.join(eval(un->value));
+      if (ui.isConstant())
+        return result;
+    }
+
+    if (root->isConstantArray()) {
+      if (i < root->size)
+        return result.join(AbstractValue::constant(
+                             root->constantValues[i]->getZExtValue(), w));
+      return AbstractValue::top(w);
+    }
+    return result.join(domain.getByte(root, i));
+  }
+
+  AbstractValue evalCompare(Expr::Kind kind, const AbstractValue &a,
+                            const AbstractValue &b) {
+    switch (kind) {
+    case Expr::Eq:
+      if (a.isConstant() && b.isConstant() && a.min == b.min)
+        return boolValue(true);
+      if (a.meet(b).isEmpty())
+        return boolValue(false);
+      break;
+    case Expr::Ne:
+      return evalNot(evalCompare(Expr::Eq, a, b));
+    case Expr::Ult:
+      if (a.max < b.min)
+        return boolValue(true);
+      if (a.min >= b.max)
+        return boolValue(false);
+      break;
+    case Expr::Ule:
+      if (a.max <= b.min)
+        return boolValue(true);
+      if (a.min > b.max)
+        return boolValue(false);
+      break;
+    case Expr::Ugt:
+      return evalCompare(Expr::Ult, b, a);
+    case Expr::Uge:
+      return evalCompare(Expr::Ule, b, a);
+    case Expr::Slt:
+    case Expr::Sle: {
+      int64_t aLo, aHi, bLo, bHi;
+      getSignedBounds(a, aLo, aHi);
+      getSignedBounds(b, bLo, bHi);
+      if (kind == Expr::Slt ? aHi < bLo : aHi <= bLo)
+        return boolValue(true);
+      if (kind == Expr::Slt ? aLo >= bHi : aLo > bHi)
+        return boolValue(false);
+      break;
+    }
+    case Expr::Sgt:
+      return evalCompare(Expr::Slt, b, a);
+    case Expr::Sge:
+      return evalCompare(Expr::Sle, b, a);
+    default:
+      assert(0 && "invalid comparison");
+    }
+    return AbstractValue::top(Expr::Bool);
+  }
+
+  AbstractValue evalNot(const AbstractValue &a) {
+    uint64_t M = AbstractValue::mask(a.width);
+    return AbstractValue(a.width, M - a.max, M - a.min, a.knownOne,
+                         a.knownZero);
+  }
+
+  AbstractValue evalKind(const ref<Expr> &e) {
+    Expr::Width w = e->getWidth();
+    uint64_t M = AbstractValue::mask(w);
+    unsigned numKids = e->getNumKids();
+
+    for (unsigned i = 0; i != numKids; ++i)
+      if (e->getKid(i)->getWidth() > 64)
+        return AbstractValue::top(w);
+
+    switch (e->getKind()) {
+    case Expr::Constant:
+      return AbstractValue::constant(cast<ConstantExpr>(e)->getZExtValue(), w);
+    case Expr::NotOptimized:
+      return eval(cast<NotOptimizedExpr>(e)->src);
+    case Expr::Read:
+      return evalRead(*cast<ReadExpr>(e));
+    default:
+      break;
+    }
+
+    // Fold expressions whose operands are all known exactly, except for
+    // divisions by zero which the solver leaves unconstrained.
+    ref<Expr> kids[3];
+    bool allConstant = true;
+    for (unsigned i = 0; i != numKids; ++i) {
+      AbstractValue kid = eval(e->getKid(i));
+      if (!kid.isConstant()) {
+        allConstant = false;
+        break;
+      }
+      kids[i] = ConstantExpr::alloc(kid.min, kid.width);
+    }
+    if (allConstant) {
+      switch (e->getKind()) {
+      case Expr::UDiv: case Expr::SDiv: case Expr::URem: case Expr::SRem:
+        if (cast<ConstantExpr>(kids[1])->isZero())
+          return AbstractValue::top(w);
+      default:
+        break;
+      }
+      ref<Expr> folded = e->rebuild(kids);
+      if (ConstantExpr *CE = dyn_cast<ConstantExpr>(folded))
+        return AbstractValue::constant(CE->getZExtValue(), w);
+    }
+
+    switch (e->getKind()) {
+    case Expr::Select: {
+      const SelectExpr *se = cast<SelectExpr>(e);
+      AbstractValue cond = eval(se->cond);
+      if (cond.mustBeTrue())
+        return eval(se->trueExpr);
+      if (cond.mustBeFalse())
+        return eval(se->falseExpr);
+      return eval(se->trueExpr).join(eval(se->falseExpr));
+    }
+
+    case Expr::Concat: {
+      const ConcatExpr *ce = cast<ConcatExpr>(e);
+      AbstractValue l = eval(ce->getLeft()), r = eval(ce->getRight());
+      unsigned shift = r.width;
+      return AbstractValue(w, (l.min << shift) | r.min, (l.max << shift) | r.max,
+                           (l.knownZero << shift) | r.knownZero,
+                           (l.knownOne << shift) | r.knownOne);
+    }
+
+    case Expr::Extract: {
+      const ExtractExpr *ee = cast<ExtractExpr>(e);
+      AbstractValue x = eval(ee->expr);
+      uint64_t lo = x.min >> ee->offset, hi = x.max >> ee->offset;
+      if (hi > M) {
+        lo = 0;
+        hi = M;
+      }
+      return AbstractValue(w, lo, hi, x.knownZero >> ee->offset,
+                           x.knownOne >> ee->offset);
+    }
+
+    case Expr::ZExt: {
+      AbstractValue x = eval(cast<CastExpr>(e)->src);
+      return AbstractValue(w, x.min, x.max,
+                           x.knownZero | (M & ~AbstractValue::mask(x.width)),
+                           x.knownOne);
+    }
+
+    case Expr::SExt: {
+      AbstractValue x = eval(cast<CastExpr>(e)->src);
+      uint64_t signBit = (uint64_t) 1 << (x.width - 1);
+      uint64_t high = M & ~AbstractValue::mask(x.width);
+      if (x.max < signBit)
+        return AbstractValue(w, x.min, x.max, x.knownZero | high, x.knownOne);
+      if (x.min >= signBit)
+        return AbstractValue(w, x.min | high, x.max | high, x.knownZero,
+                             x.knownOne | high);
+      return AbstractValue::fromKnownBits(w, x.knownZero, x.knownOne);
+    }
+
+    case Expr::Not:
+      return evalNot(eval(cast<NotExpr>(e)->expr));
+
+    default:
+      break;
+    }
+
+    const BinaryExpr *be = dyn_cast<BinaryExpr>(e);
+    if (!be)
+      return AbstractValue::top(w);
+    AbstractValue a = eval(be->left), b = eval(be->right);
+
+    switch (e->getKind()) {
+    case Expr::Add:
+      if (a.max <= M - b.max)
+        return AbstractValue(w, a.min + b.min, a.max + b.max);
+      break;
+    case Expr::Sub:
+      if (a.min >= b.max)
+        return AbstractValue(w, a.min - b.max, a.max - b.min);
+      break;
+    case Expr::Mul:
+      if (!b.max || a.max <= M / b.max)
+        return AbstractValue(w, a.min * b.min, a.max * b.max);
+      break;
+    case Expr::UDiv:
+      if (b.min)
+        return AbstractValue(w, a.min / b.max, a.max / b.min);
+      break;
+    case Expr::URem:
+      if (b.min)
+        return AbstractValue(w, 0, std::min(a.max, b.max - 1));
+      break;
+
+    case Expr::And:
+      return AbstractValue(w, 0, std::min(a.max, b.max),
+                           a.knownZero | b.knownZero, a.knownOne & b.knownOne);
+    case Expr::Or:
+      return AbstractValue(w, std::max(a.min, b.min), M,
+                           a.knownZero & b.knownZero, a.knownOne | b.knownOne);
+    case Expr::Xor:
+      return AbstractValue::fromKnownBits(
+        w, (a.knownZero & b.knownZero) | (a.knownOne & b.knownOne),
+        (a.knownZero & b.knownOne) | (a.knownOne & b.knownZero));
+
+    case Expr::Shl:
+    case Expr::LShr: {
+      if (!b.isConstant())
+        break;
+      if (b.min >= w)
+        return AbstractValue::constant(0, w);
+      unsigned shift = b.min;
+      if (e->getKind() == Expr::Shl) {
+        uint64_t lo = 0, hi = M;
+        if (a.max <= (M >> shift)) {
+          lo = a.min << shift;
+          hi = a.max << shift;
+        }
+        return AbstractValue(w, lo, hi,
+                             ((a.knownZero << shift) |
+                              AbstractValue::mask(shift)) & M,
+                             a.knownOne << shift);
+      }
+      return AbstractValue(w, a.min >> shift, a.max >> shift,
+                           (a.knownZero >> shift) | (M & ~(M >> shift)),
+                           a.knownOne >> shift);
+    }
+
+    case Expr::Eq: case Expr::Ne:
+    case Expr::Ult: case Expr::Ule: case Expr::Ugt: case Expr::Uge:
+    case Expr::Slt: case Expr::Sle: case Expr::Sgt: case Expr::Sge:
+      return evalCompare(e->getKind(), a, b);
+
+    default:
+      break;
+    }
+    return AbstractValue::top(w);
+  }
+
+public:
+  Evaluator(const AbstractDomain &_domain) : domain(_domain) {}
+
+  AbstractValue eval(const ref<Expr> &e) {
+    ExprHashMap<AbstractValue>::iterator it = cache.find(e);
+    if (it != cache.end())
+      return it->second;
+    AbstractValue result = evalKind(e);
+    cache.insert(std::make_pair(e, result));
+    return result;
+  }
+};
+
+/***/
+
+class AbstractDomain::Refiner {
+  AbstractDomain &domain;
+  unsigned depth;
+
+  void refineByte(const ReadExpr &re, const AbstractValue &target) {
+    const Array *root = re.updates.root;
+    if (root->isConstantArray() || re.index->getWidth() > 64)
+      return;
+    AbstractValue index = domain.evaluate(re.index);
+    if (!index.isConstant())
+      return;
+
+    // Only reads of the initial contents of a byte restrict the byte.
+    for (const UpdateNode *un = re.updates.head; un; un = un->next) {
+      if (un->index->getWidth() > 64)
+        return;
+      AbstractValue ui = domain.evaluate(un->index);
+      if (!ui.meet(AbstractValue::constant(index.min, ui.width)).isEmpty())
+        return;
+    }
+
+    byte_ty key(root, index.min);
+    AbstractValue current = domain.getByte(root, index.min);
+    AbstractValue refined = current.meet(target);
+    if (refined != current && !refined.isEmpty())
+      domain.bytes = domain.bytes.replace(std::make_pair(key, refined));
+  }
+
+  /// Refine \a e to lie in the signed interval [lo, hi].
+  void refineSigned(const ref<Expr> &e, int64_t lo, int64_t hi) {
+    Expr::Width w = e->getWidth();
+    uint64_t M = AbstractValue::mask(w);
+    if (lo > hi)
+      return;
+    if (lo >= 0) {
+      refine(e, AbstractValue(w, lo, hi));
+    } else if (hi < 0) {
+      refine(e, AbstractValue(w, (uint64_t) lo & M, (uint64_t) hi & M));
+    } else {
+      // The interval wraps around in unsigned terms, so it only helps if we
+      // already know the sign.
+      AbstractValue current = domain.evaluate(e);
+      uint64_t signBit = (uint64_t) 1 << (w - 1);
+      if (current.max < signBit)
+        refine(e, AbstractValue(w, 0, hi));
+      else if (current.min >= signBit)
+        refine(e, AbstractValue(w, (uint64_t) lo & M, M));
+    }
+  }
+
+  /// Refine with the knowledge that \a l < \a r (or \a l <= \a r if not \a
+  /// strict), as unsigned or signed values.
+  void refineLess(const ref<Expr> &l, const ref<Expr> &r, bool strict,
+                  bool isSigned) {
+    Expr::Width w = l->getWidth();
+    uint64_t M = AbstractValue::mask(w);
+    AbstractValue lv = domain.evaluate(l), rv = domain.evaluate(r);
+
+    if (!isSigned) {
+      if (!strict) {
+        refine(l, AbstractValue(w, 0, rv.max));
+        refine(r, AbstractValue(w, lv.min, M));
+      } else if (rv.max != 0 && lv.min != M) {
+        refine(l, AbstractValue(w, 0, rv.max - 1));
+        refine(r, AbstractValue(w, lv.min + 1, M));
+      }
+      return;
+    }
+
+    int64_t sMin = signExtend((uint64_t) 1 << (w - 1), w);
+    int64_t sMax = (int64_t) (M >> 1);
+    int64_t lLo, lHi, rLo, rHi;
+    getSignedBounds(lv, lLo, lHi);
+    getSignedBounds(rv, rLo, rHi);
+    if (!strict) {
+      refineSigned(l, sMin, rHi);
+      refineSigned(r, lLo, sMax);
+    } else if (rHi != sMin && lLo != sMax) {
+      refineSigned(l, sMin, rHi - 1);
+      refineSigned(r, lLo + 1, sMax);
+    }
+  }
+
+  void refineBool(const ref<Expr> &e, bool value) {
+    switch (e->getKind()) {
+    case Expr::And:
+      if (value) {
+        refine(e->getKid(0), boolValue(true));
+        refine(e->getKid(1), boolValue(true));
+      }
+      return;
+    case Expr::Or:
+      if (!value) {
+        refine(e->getKid(0), boolValue(false));
+        refine(e->getKid(1), boolValue(false));
+      }
+      return;
+
+    case Expr::Ne:
+      value = !value;
+      // Fall through.
+    case Expr::Eq: {
+      ref<Expr> l = e->getKid(0), r = e->getKid(1);
+      if (value) {
+        AbstractValue lv = domain.evaluate(l), rv = domain.evaluate(r);
+        refine(l, rv);
+        refine(r, lv);
+        return;
+      }
+      if (!isa<ConstantExpr>(l))
+        std::swap(l, r);
+      if (!isa<ConstantExpr>(l))
+        return;
+      uint64_t c = cast<ConstantExpr>(l)->getZExtValue();
+      AbstractValue rv = domain.evaluate(r);
+      if (rv.min == c && c != rv.max)
+        refine(r, AbstractValue(rv.width, c + 1, rv.max));
+      else if (rv.max == c && c != rv.min)
+        refine(r, AbstractValue(rv.width, rv.min, c - 1));
+      return;
+    }
+
+    // A false comparison is the reverse comparison with the operands
+    // swapped, e.g. !(a < b) is b <= a.
+    case Expr::Ult:
+    case Expr::Ule:
+    case Expr::Slt:
+    case Expr::Sle: {
+      bool strict = e->getKind() == Expr::Ult || e->getKind() == Expr::Slt;
+      bool isSigned = e->getKind() == Expr::Slt || e->getKind() == Expr::Sle;
+      if (value)
+        refineLess(e->getKid(0), e->getKid(1), strict, isSigned);
+      else
+        refineLess(e->getKid(1), e->getKid(0), !strict, isSigned);
+      return;
+    }
+    case Expr::Ugt:
+    case Expr::Uge:
+    case Expr::Sgt:
+    case Expr::Sge: {
+      bool strict = e->getKind() == Expr::Ugt || e->getKind() == Expr::Sgt;
+      bool isSigned = e->getKind() == Expr::Sgt || e->getKind() == Expr::Sge;
+      if (value)
+        refineLess(e->getKid(1), e->getKid(0), strict, isSigned);
+      else
+        refineLess(e->getKid(0), e->getKid(1), !strict, isSigned);
+      return;
+    }
+
+    default:
+      return;
+    }
+  }
+
+public:
+  Refiner(AbstractDomain &_domain) : domain(_domain), depth(0) {}
+
+  /// Refine the domain with the knowledge that the value of \a e lies in
+  /// \a target.
+  void refine(const ref<Expr> &e, const AbstractValue &target) {
+    Expr::Width w = e->getWidth();
+    if (w > 64 || depth >= MaxRefineDepth)
+      return;
+    for (unsigned i = 0, n = e->getNumKids(); i != n; ++i)
+      if (e->getKid(i)->getWidth() > 64)
+        return;
+
+    // An empty value means the constraints are unsatisfiable, which we leave
+    // for the solver to find out.
+    AbstractValue current = domain.evaluate(e).meet(target);
+    if (current.isEmpty())
+      return;
+
+    ++depth;
+    switch (e->getKind()) {
+    case Expr::Read:
+      refineByte(*cast<ReadExpr>(e), current);
+      break;
+
+    case Expr::NotOptimized:
+      refine(cast<NotOptimizedExpr>(e)->src, current);
+      break;
+
+    case Expr::Concat: {
+      const ConcatExpr *ce = cast<ConcatExpr>(e);
+      Expr::Width lw = ce->getLeft()->getWidth();
+      Expr::Width rw = ce->getRight()->getWidth();
+      uint64_t rM = AbstractValue::mask(rw);
+      refine(ce->getLeft(),
+             AbstractValue(lw, current.min >> rw, current.max >> rw,
+                           current.knownZero >> rw, current.knownOne >> rw));
+      // The interval only restricts the low part if the high part is fixed.
+      if ((current.min >> rw) == (current.max >> rw))
+        refine(ce->getRight(),
+               AbstractValue(rw, current.min & rM, current.max & rM,
+                             current.knownZero & rM, current.knownOne & rM));
+      else
+        refine(ce->getRight(),
+               AbstractValue::fromKnownBits(rw, current.knownZero & rM,
+                                            current.knownOne & rM));
+      break;
+    }
+
+    case Expr::Extract: {
+      const ExtractExpr *ee = cast<ExtractExpr>(e);
+      Expr::Width xw = ee->expr->getWidth();
+      uint64_t xM = AbstractValue::mask(xw);
+      refine(ee->expr, AbstractValue::fromKnownBits(
+                         xw, (current.knownZero << ee->offset) & xM,
+                         (current.knownOne << ee->offset) & xM));
+      break;
+    }
+
+    case Expr::ZExt:
+    case Expr::SExt: {
+      ref<Expr> src = cast<CastExpr>(e)->src;
+      Expr::Width xw = src->getWidth();
+      uint64_t xM = AbstractValue::mask(xw);
+      if (isa<ZExtExpr>(e))
+        refine(src, AbstractValue(xw, current.min, std::min(current.max, xM),
+                                  current.knownZero & xM,
+                                  current.knownOne & xM));
+      else
+        refine(src, AbstractValue::fromKnownBits(xw, current.knownZero & xM,
+                                                 current.knownOne & xM));
+      break;
+    }
+
+    case Expr::Not: {
+      uint64_t M = AbstractValue::mask(w);
+      refine(cast<NotExpr>(e)->expr,
+             AbstractValue(w, M - current.max, M - current.min,
+                           current.knownOne, current.knownZero));
+      break;
+    }
+
+    case Expr::Add: {
+      // Canonical form puts the constant on the left, as in the range
+      // checks (x + -k) < n.
+      const AddExpr *ae = cast<AddExpr>(e);
+      if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(ae->left)) {
+        uint64_t M = AbstractValue::mask(w);
+        uint64_t k = CE->getZExtValue();
+        if (current.min >= k || current.max < k)
+          refine(ae->right, AbstractValue(w, (current.min - k) & M,
+                                          (current.max - k) & M));
+      }
+      break;
+    }
+
+    default:
+      if (w == Expr::Bool && current.isConstant())
+        refineBool(e, current.min);
+      break;
+    }
+    --depth;
+  }
+};
+
+/***/
+
+AbstractValue AbstractDomain::evaluate(const ref<Expr> &e) const {
+  assert(e->getWidth() <= 64 && "cannot evaluate wide expressions");
+  return Evaluator(*this).eval(e);
+}
+
+AbstractValue AbstractDomain::getByte(const Array *array,
+                                      unsigned index) const {
+  if (const bytes_ty::value_type *v = bytes.lookup(byte_ty(array, index)))
+    return v->second;
+  return AbstractValue::top(array->getRange());
+}
+
+void AbstractDomain::addConstraint(const ref<Expr> &e) {
+  if (isa<ConstantExpr>(e))
+    return;
+  Refiner(*this).refine(e, boolValue(true));
+}
+
+AbstractDomain AbstractDomain::join(const AbstractDomain &b) const {
+  AbstractDomain result;
+  for (bytes_ty::iterator it = bytes.begin(), ie = bytes.end(); it != ie;
+       ++it) {
+    const bytes_ty::value_type *other = b.bytes.lookup(it->first);
+    if (!other)
+      continue;
+    AbstractValue joined = it->second.join(other->second);
+    if (!joined.isTop())
+      result.bytes = result.bytes.insert(std::make_pair(it->first, joined));
+  }
+  return result;
+}
@@ -0,0 +1,486 @@
+//===-- ConstraintProgram.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/util/ConstraintProgram.h"
+
+#include "klee/util/Assignment.h"
+#include "klee/util/ExprHashMap.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace klee;
+
+/// The largest program we are willing to build. Reads through long update
+/// lists expand into one comparison and select per update, so a handful of
+/// constraints can otherwise produce huge programs.
+static const unsigned MaxInstructions = 1 << 16;
+
+static inline uint64_t widthMask(unsigned width) {
+  return width >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << width) - 1;
+}
+
+static inline int64_t signExtend(uint64_t value, unsigned width) {
+  if (width >= 64)
+    return (int64_t) value;
+  unsigned shift = 64 - width;
+  return ((int64_t) (value << shift)) >> shift;
+}
+
+/***/
+
+class ConstraintProgram::Compiler {
+  ConstraintProgram &program;
+  ExprHashMap<unsigned> registers;
+  std::map<const Array*, unsigned> slots;
+
+  bool emit(const Instruction &i, unsigned &result) {
+    if (program.instructions.size() >= MaxInstructions)
+      return false;
+    result = program.instructions.size();
+    program.instructions.push_back(i);
+    return true;
+  }
+
+  unsigned getSlot(const Array *array) {
+    std::map<const Array*, unsigned>::iterator it = slots.find(array);
+    if (it != slots.end())
+      return it->second;
+    unsigned slot = program.arrays.size();
+    program.arrays.push_back(array);
+    slots.insert(std::make_pair(array, slot));
+    return slot;
+  }
+
+  bool compileRead(const ReadExpr &re, unsigned &result) {
+    const Array *root = re.updates.root;
+    if (root->getDomain() > 64 || root->getRange() > 64)
+      return false;
+
+    unsigned index;
+    if (!compile(re.index, index))
+      return false;
+    if (!emit(Instruction(Read, root->getRange(), index, getSlot(root)),
+              result))
+      return false;
+
+    // Apply the updates oldest first, so that the most recent write to a
+    // given index is the one selected last.
+    std::vector<const UpdateNode*> updates;
+    for (const UpdateNode *un = re.updates.head; un; un = un->next)
+      updates.push_back(un);
+    for (std::vector<const UpdateNode*>::reverse_iterator
+           it = updates.rbegin(), ie = updates.rend(); it != ie; ++it) {
+      unsigned updateIndex, updateValue, matches;
+      if (!compile((*it)->index, updateIndex) ||
+          !compile((*it)->value, updateValue) ||
+          !emit(Instruction(Eq, Expr::Bool, index, updateIndex, 0,
+                            root->getDomain()), matches) ||
+          !emit(Instruction(Select, root->getRange(), matches, updateValue,
+                            result), result))
+        return false;
+    }
+    return true;
+  }
+
+  bool compileKind(const ref<Expr> &e, unsigned &result) {
+    unsigned width = e->getWidth();
+
+    switch (e->getKind()) {
+    case Expr::Constant:
+      return emit(Instruction(Const, width, 0, 0, 0,
+                              cast<ConstantExpr>(e)->getZExtValue()), result);
+
+    case Expr::NotOptimized:
+      return compile(cast<NotOptimizedExpr>(e)->src, result);
+
+    case Expr::Read:
+      return compileRead(*cast<ReadExpr>(e), result);
+
+    case Expr::Select: {
+      const SelectExpr *se = cast<SelectExpr>(e);
+      unsigned c, t, f;
+      return compile(se->cond, c) && compile(se->trueExpr, t) &&
+             compile(se->falseExpr, f) &&
+             emit(Instruction(Select, width, c, t, f), result);
+    }
+
+    case Expr::Concat: {
+      const ConcatExpr *ce = cast<ConcatExpr>(e);
+      unsigned l, r;
+      return compile(ce->getLeft(), l) && compile(ce->getRight(), r) &&
+             emit(Instruction(Concat, width, l, r, 0,
+                              ce->getRight()->getWidth()), result);
+    }
+
+    case Expr::Extract: {
+      const ExtractExpr *ee = cast<ExtractExpr>(e);
+      unsigned src;
+      return compile(ee->expr, src) &&
+             emit(Instruction(Extract, width, src, ee->offset), result);
+    }
+
+    case Expr::ZExt:
+    case Expr::SExt: {
+      const CastExpr *ce = cast<CastExpr>(e);
+      unsigned src;
+      return compile(ce->src, src) &&
+             emit(Instruction(isa<SExtExpr>(ce) ? SExt : ZExt, width, src,
+                              ce->src->getWidth()), result);
+    }
+
+    case Expr::Not: {
+      unsigned src;
+      return compile(cast<NotExpr>(e)->expr, src) &&
+             emit(Instruction(Not, width, src), result);
+    }
+
+    default: {
+      const BinaryExpr *be = dyn_cast<BinaryExpr>(e);
+      if (!be)
+        return false;
+
+      Opcode opcode;
+      switch (e->getKind()) {
+      case Expr::Add: opcode = Add; break;
+      case Expr::Sub: opcode = Sub; break;
+      case Expr::Mul: opcode = Mul; break;
+      case Expr::UDiv: opcode = UDiv; break;
+      case Expr::SDiv: opcode = SDiv; break;
+      case Expr::URem: opcode = URem; break;
+      case Expr::SRem: opcode = SRem; break;
+      case Expr::And: opcode = And; break;
+      case Expr::Or: opcode = Or; break;
+      case Expr::Xor: opcode = Xor; break;
+      case Expr::Shl: opcode = Shl; break;
+      case Expr::LShr: opcode = LShr; break;
+      case Expr::AShr: opcode = AShr; break;
+      case Expr::Eq: opcode = Eq; break;
+      case Expr::Ne: opcode = Ne; break;
+      case Expr::Ult: opcode = Ult; break;
+      case Expr::Ule: opcode = Ule; break;
+      case Expr::Ugt: opcode = Ugt; break;
+      case Expr::Uge: opcode = Uge; break;
+      case Expr::Slt: opcode = Slt; break;
+      case Expr::Sle: opcode = Sle; break;
+      case Expr::Sgt: opcode = Sgt; break;
+      case Expr::Sge: opcode = Sge; break;
+      default:
+        return false;
+      }
+
+      // Comparisons carry the width of their operands, which the signed
+      // forms need to sign extend.
+      unsigned l, r;
+      return compile(be->left, l) && compile(be->right, r) &&
+             emit(Instruction(opcode, width, l, r, 0,
+                              be->left->getWidth()), result);
+    }
+    }
+  }
+
+public:
+  Compiler(ConstraintProgram &_program) : program(_program) {}
+
+  bool compile(const ref<Expr> &e, unsigned &result) {
+    ExprHashMap<unsigned>::iterator it = registers.find(e);
+    if (it != registers.end()) {
+      result = it->second;
+      return true;
+    }
+
+    if (e->getWidth() > 64 || !compileKind(e, result))
+      return false;
+    registers.insert(std::make_pair(e, result));
+    return true;
+  }
+};
+
+void ConstraintProgram::compile() {
+  Compiler compiler(*this);
+  for (std::vector< ref<Expr> >::const_iterator it = constraints.begin(),
+         ie = constraints.end(); it != ie; ++it) {
+    unsigned root;
+    if ((*it)->getWidth() != Expr::Bool || !compiler.compile(*it, root)) {
+      instructions.clear();
+      roots.clear();
+      arrays.clear();
+      return;
+    }
+    roots.push_back(root);
+  }
+  valid = true;
+}
+
+/***/
+
+void ConstraintProgram::run(const Assignment * const *batch, unsigned count,
+                            bool *satisfied) const {
+  assert(valid && count <= BatchSize);
+
+  // The bindings of every array for every lane, resolved once up front.
+  std::vector<const std::vector<unsigned char>*> bindings(arrays.size() *
+                                                          BatchSize);
+  for (unsigned slot = 0; slot != arrays.size(); ++slot) {
+    for (unsigned lane = 0; lane != count; ++lane) {
+      Assignment::bindings_ty::const_iterator it =
+        batch[lane]->bindings.find(arrays[slot]);
+      bindings[slot * BatchSize + lane] =
+        it == batch[lane]->bindings.end() ? 0 : &it->second;
+    }
+  }
+
+  // Lanes whose result the program cannot reproduce exactly.
+  bool poisoned[BatchSize];
+  for (unsigned lane = 0; lane != BatchSize; ++lane)
+    poisoned[lane] = false;
+
+  std::vector<uint64_t> registers(instructions.size() * BatchSize);
+  for (unsigned i = 0, e = instructions.size(); i != e; ++i) {
+    const Instruction &inst = instructions[i];
+    uint64_t *R = &registers[i * BatchSize];
+    const uint64_t *A = &registers[inst.a * BatchSize];
+    const uint64_t *B = &registers[inst.b * BatchSize];
+    const uint64_t *C = &registers[inst.c * BatchSize];
+    uint64_t mask = widthMask(inst.width);
+    unsigned n = count;
+
+    switch (inst.opcode) {
+    case Const:
+      for (unsigned l = 0; l != n; ++l) R[l] = inst.imm;
+      break;
+
+    case Read: {
+      const Array *array = arrays[inst.b];
+      for (unsigned l = 0; l != n; ++l) {
+        uint64_t index = A[l];
+        if (array->isConstantArray() && index < array->size) {
+          R[l] = array->constantValues[index]->getZExtValue();
+          continue;
+        }
+        const std::vector<unsigned char> *values =
+          bindings[inst.b * BatchSize + l];
+        if (values && index < values->size()) {
+          R[l] = (*values)[index] & mask;
+        } else {
+          R[l] = 0;
+          if (batch[l]->allowFreeValues)
+            poisoned[l] = true;
+        }
+      }
+      break;
+    }
+
+    case Select:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] ? B[l] : C[l];
+      break;
+    case Concat:
+      for (unsigned l = 0; l != n; ++l) R[l] = (A[l] << inst.imm) | B[l];
+      break;
+    case Extract:
+      for (unsigned l = 0; l != n; ++l) R[l] = (A[l] >> inst.b) & mask;
+      break;
+    case ZExt:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l];
+      break;
+    case SExt:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = (uint64_t) signExtend(A[l], inst.b) & mask;
+      break;
+    case Not:
+      for (unsigned l = 0; l != n; ++l) R[l] = ~A[l] & mask;
+      break;
+
+    case Add:
+      for (unsigned l = 0; l != n; ++l) R[l] = (A[l] + B[l]) & mask;
+      break;
+    case Sub:
+      for (unsigned l = 0; l != n; ++l) R[l] = (A[l] - B[l]) & mask;
+      break;
+    case Mul:
+      for (unsigned l = 0; l != n; ++l) R[l] = (A[l] * B[l]) & mask;
+      break;
+
+    // Division by zero is left symbolic by ExprEvaluator, which we do not
+    // model here.
+    case UDiv:
+      for (unsigned l = 0; l != n; ++l) {
+        if (B[l]) R[l] = A[l] / B[l];
+        else { R[l] = 0; poisoned[l] = true; }
+      }
+      break;
+    case URem:
+      for (unsigned l = 0; l != n; ++l) {
+        if (B[l]) R[l] = A[l] % B[l];
+        else { R[l] = 0; poisoned[l] = true; }
+      }
+      break;
+    case SDiv:
+      for (unsigned l = 0; l != n; ++l) {
+        int64_t a = signExtend(A[l], inst.width);
+        int64_t b = signExtend(B[l], inst.width);
+        if (!b) { R[l] = 0; poisoned[l] = true; }
+        // Avoid overflowing on INT_MIN / -1, which wraps.
+        else if (b == -1) R[l] = (0 - A[l]) & mask;
+        else R[l] = (uint64_t) (a / b) & mask;
+      }
+      break;
+    case SRem:
+      for (unsigned l = 0; l != n; ++l) {
+        int64_t a = signExtend(A[l], inst.width);
+        int64_t b = signExtend(B[l], inst.width);
+        if (!b) { R[l] = 0; poisoned[l] = true; }
+        else if (b == -1) R[l] = 0;
+        else R[l] = (uint64_t) (a % b) & mask;
+      }
+      break;
+
+    case And:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] & B[l];
+      break;
+    case Or:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] | B[l];
+      break;
+    case Xor:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] ^ B[l];
+      break;
+
+    // Shifts by at least the width behave as APInt does.
+    case Shl:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = B[l] >= inst.width ? 0 : (A[l] << B[l]) & mask;
+      break;
+    case LShr:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = B[l] >= inst.width ? 0 : A[l] >> B[l];
+      break;
+    case AShr:
+      for (unsigned l = 0; l != n; ++l) {
+        uint64_t shift = B[l] >= inst.width ? inst.width - 1 : B[l];
+        R[l] = (uint64_t) (signExtend(A[l], inst.width) >> shift) & mask;
+      }
+      break;
+
+    case Eq:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] == B[l];
+      break;
+    case Ne:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] != B[l];
+      break;
+    case Ult:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] < B[l];
+      break;
+    case Ule:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] <= B[l];
+      break;
+    case Ugt:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] > B[l];
+      break;
+    case Uge:
+      for (unsigned l = 0; l != n; ++l) R[l] = A[l] >= B[l];
+      break;
+    case Slt:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = signExtend(A[l], inst.imm) < signExtend(B[l], inst.imm);
+      break;
+    case Sle:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = signExtend(A[l], inst.imm) <= signExtend(B[l], inst.imm);
+      break;
+    case Sgt:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = signExtend(A[l], inst.imm) > signExtend(B[l], inst.imm);
+      break;
+    case Sge:
+      for (unsigned l = 0; l != n; ++l)
+        R[l] = signExtend(A[l], inst.imm) >= signExtend(B[l], inst.imm);
+      break;
+    }
+  }
+
+  for (unsigned lane = 0; lane != count; ++lane) {
+    if (poisoned[lane]) {
+      AssignmentEvaluator v(*batch[lane]);
+      satisfied[lane] = true;
+      for (std::vector< ref<Expr> >::const_iterator it = constraints.begin(),
+             ie = constraints.end(); it != ie; ++it) {
+        if (!v.visit(*it)->isTrue()) {
+          satisfied[lane] = false;
+          break;
+        }
+      }
+      continue;
+    }
+
+    satisfied[lane] = true;
+    for (std::vector<unsigned>::const_iterator it = roots.begin(),
+           ie = roots.end(); it != ie; ++it) {
+      if (!registers[*it * BatchSize + lane]) {
+        satisfied[lane] = false;
+        break;
+      }
+    }
+  }
+}
+
+bool ConstraintProgram::satisfies(const Assignment &a) const {
+  if (!valid) {
+    AssignmentEvaluator v(a);
+    for (std::vector< ref<Expr> >::const_iterator it = constraints.begin(),
+           ie = constraints.end(); it != ie; ++it)
+      if (!v.visit(*it)->isTrue())
+        return false;
+    return true;
+  }
+
+  const Assignment *batch[1] = { &a };
+  bool result;
+  run(batch, 1, &result);
+  return result;
+}
+
+void ConstraintProgram::satisfies(
+    const std::vector<const Assignment*> &assignments,
+    std::vector<bool> &result) const {
+  result.assign(assignments.size(), false);
+  if (!valid) {
+    for (unsigned i = 0, e = assignments.size(); i != e; ++i)
+      result[i] = satisfies(*assignments[i]);
+    return;
+  }
+
+  bool satisfied[BatchSize];
+  for (unsigned i = 0, e = assignments.size(); i < e; i += BatchSize) {
+    unsigned count = std::min(e - i, (unsigned) BatchSize);
+    run(&assignments[i], count, satisfied);
+    for (unsigned lane = 0; lane != count; ++lane)
+      result[i + lane] = satisfied[lane];
+  }
+}
+
+unsigned ConstraintProgram::findSatisfying(
+    const std::vector<const Assignment*> &assignments) const {
+  unsigned e = assignments.size();
+  if (!valid) {
+    for (unsigned i = 0; i != e; ++i)
+      if (satisfies(*assignments[i]))
+        return i;
+    return e;
+  }
+
+  bool satisfied[BatchSize];
+  for (unsigned i = 0; i < e; i += BatchSize) {
+    unsigned count = std::min(e - i, (unsigned) BatchSize);
+    run(&assignments[i], count, satisfied);
+    for (unsigned lane = 0; lane != count; ++lane)
+      if (satisfied[lane])
+        return i + lane;
+  }
+  return e;
+}
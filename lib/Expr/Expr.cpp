@@ -19,7 +19,9 @@
 // Core. If we need to do arithmetic, we probably want to use APInt.
 #include "klee/Internal/Support/IntEvaluation.h"
 
+#include "klee/util/Bits.h"
 #include "klee/util/ExprPPrinter.h"
+#include "klee/util/ExprRewriter.h"
 
 #include <sstream>
 
@@ -31,6 +33,25 @@ namespace {
   ConstArrayOpt("const-array-opt",
 	 cl::init(false),
 	 cl::desc("Enable various optimizations involving all-constant arrays."));
+
+  cl::opt<bool>
+  ConstArrayReadOpt("const-array-read-opt",
+                    cl::init(false),
+                    cl::desc("Replace symbolic-index reads from constant arrays which split into a few arithmetic runs with arithmetic on the index (default=off)"));
+
+  cl::opt<unsigned>
+  ConstArrayMaxPieces("const-array-max-pieces",
+                      cl::init(8),
+                      cl::desc("Maximum number of arithmetic runs for --const-array-read-opt (default=8)"));
+
+  cl::opt<bool>
+  ExprRewriteRules("expr-rewrite-rules",
+                   cl::init(false),
+                   cl::desc("Simplify expressions on construction with the rules in ExprRewriter (default=off)"));
+}
+
+static ref<Expr> rewrite(const ref<Expr> &e) {
+  return ExprRewriteRules ? ExprRewriter::rewrite(e) : e;
 }
 
 /***/
@@ -486,7 +507,7 @@ Array::Array(const std::string &_name, uint64_t _size,
              const ref<ConstantExpr> *constantValuesEnd, Expr::Width _domain,
              Expr::Width _range)
     : name(_name), size(_size), domain(_domain), range(_range),
-      constantValues(constantValuesBegin, constantValuesEnd) {
+      constantValues(constantValuesBegin, constantValuesEnd), piecesLimit(0) {
 
   assert((isSymbolicArray() || constantValues.size() == size) &&
          "Invalid size for constant array!");
@@ -502,6 +523,32 @@ Array::Array(const std::string &_name, uint64_t _size,
 Array::~Array() {
 }
 
+const std::vector<Array::Piece> *Array::getPieces(unsigned maxPieces) const {
+  assert(isConstantArray() && range <= 64 && "invalid array for pieces");
+  if (piecesLimit != maxPieces) {
+    uint64_t mask = bits64::maxValueOfNBits(range);
+    pieces.clear();
+    for (unsigned i = 0; i != size && pieces.size() <= maxPieces; ) {
+      Piece p;
+      p.start = i;
+      p.base = constantValues[i]->getZExtValue(range);
+      p.step = (i + 1 == size) ? 0 :
+        (constantValues[i + 1]->getZExtValue(range) - p.base) & mask;
+      uint64_t next = p.base;
+      for (++i; i != size; ++i) {
+        next = (next + p.step) & mask;
+        if (constantValues[i]->getZExtValue(range) != next)
+          break;
+      }
+      p.end = i;
+      pieces.push_back(p);
+    }
+    piecesLimit = maxPieces;
+  }
+
+  return pieces.size() <= maxPieces ? &pieces : 0;
+}
+
 unsigned Array::computeHash() {
   unsigned res = 0;
   for (unsigned i = 0, e = name.size(); i != e; ++i)
@@ -512,6 +559,42 @@ unsigned Array::computeHash() {
 }
 /***/
 
+/// Build the value of a read of \a index from \a ul, a constant array split
+/// into \a pieces. The pieces only cover indices within the array, so the
+/// read itself is kept for the indices past its end.
+static ref<Expr> createPiecewiseRead(const UpdateList &ul,
+                                     const std::vector<Array::Piece> &pieces,
+                                     ref<Expr> index) {
+  Expr::Width range = ul.root->getRange();
+  Expr::Width width = index->getWidth();
+  ref<Expr> res;
+  for (unsigned i = pieces.size(); i != 0; --i) {
+    const Array::Piece &p = pieces[i - 1];
+    ref<Expr> value = ConstantExpr::create(p.base, range);
+    if (p.step) {
+      ref<Expr> offset =
+        SubExpr::create(index, ConstantExpr::create(p.start, width));
+      offset = width > range ? ExtractExpr::create(offset, 0, range) :
+                               ZExtExpr::create(offset, range);
+      value = AddExpr::create(value,
+                              MulExpr::create(ConstantExpr::create(p.step,
+                                                                   range),
+                                              offset));
+    }
+    if (i == pieces.size()) {
+      res = value;
+    } else {
+      res = SelectExpr::create(UltExpr::create(index,
+                                               ConstantExpr::create(p.end,
+                                                                    width)),
+                               value, res);
+    }
+  }
+  ref<Expr> inBounds =
+    UltExpr::create(index, ConstantExpr::create(ul.root->size, width));
+  return SelectExpr::create(inBounds, res, ReadExpr::alloc(ul, index));
+}
+
 ref<Expr> ReadExpr::create(const UpdateList &ul, ref<Expr> index) {
   // rollback index when possible... 
 
@@ -533,6 +616,12 @@ ref<Expr> ReadExpr::create(const UpdateList &ul, ref<Expr> index) {
     }
   }
 
+  if (ConstArrayReadOpt && !ul.head && ul.root->isConstantArray() &&
+      !isa<ConstantExpr>(index) && ul.root->getRange() <= 64)
+    if (const std::vector<Array::Piece> *pieces =
+          ul.root->getPieces(ConstArrayMaxPieces))
+      return createPiecewiseRead(ul, *pieces, index);
+
   return ReadExpr::alloc(ul, index);
 }
 
@@ -566,7 +655,7 @@ ref<Expr> SelectExpr::create(ref<Expr> c, ref<Expr> t, ref<Expr> f) {
     }
   }
   
-  return SelectExpr::alloc(c, t, f);
+  return rewrite(SelectExpr::alloc(c, t, f));
 }
 
 /***/
@@ -648,7 +737,7 @@ ref<Expr> ExtractExpr::create(ref<Expr> expr, unsigned off, Width w) {
     }
   }
   
-  return ExtractExpr::alloc(expr, off, w);
+  return rewrite(ExtractExpr::alloc(expr, off, w));
 }
 
 /***/
@@ -657,7 +746,7 @@ ref<Expr> NotExpr::create(const ref<Expr> &e) {
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(e))
     return CE->Not();
   
-  return NotExpr::alloc(e);
+  return rewrite(NotExpr::alloc(e));
 }
 
 
@@ -672,7 +761,7 @@ ref<Expr> ZExtExpr::create(const ref<Expr> &e, Width w) {
   } else if (ConstantExpr *CE = dyn_cast<ConstantExpr>(e)) {
     return CE->ZExt(w);
   } else {
-    return ZExtExpr::alloc(e, w);
+    return rewrite(ZExtExpr::alloc(e, w));
   }
 }
 
@@ -685,7 +774,7 @@ ref<Expr> SExtExpr::create(const ref<Expr> &e, Width w) {
   } else if (ConstantExpr *CE = dyn_cast<ConstantExpr>(e)) {
     return CE->SExt(w);
   } else {    
-    return SExtExpr::alloc(e, w);
+    return rewrite(SExtExpr::alloc(e, w));
   }
 }
 
@@ -934,11 +1023,11 @@ ref<Expr>  _e_op ::create(const ref<Expr> &l, const ref<Expr> &r) { \
   if (ConstantExpr *cl = dyn_cast<ConstantExpr>(l)) {                   \
     if (ConstantExpr *cr = dyn_cast<ConstantExpr>(r))                   \
       return cl->_op(cr);                                               \
-    return _e_op ## _createPartialR(cl, r.get());                       \
+    return rewrite(_e_op ## _createPartialR(cl, r.get()));              \
   } else if (ConstantExpr *cr = dyn_cast<ConstantExpr>(r)) {            \
-    return _e_op ## _createPartial(l.get(), cr);                        \
+    return rewrite(_e_op ## _createPartial(l.get(), cr));               \
   }                                                                     \
-  return _e_op ## _create(l.get(), r.get());                            \
+  return rewrite(_e_op ## _create(l.get(), r.get()));                   \
 }
 
 #define BCREATE(_e_op, _op) \
@@ -947,7 +1036,7 @@ ref<Expr>  _e_op ::create(const ref<Expr> &l, const ref<Expr> &r) { \
   if (ConstantExpr *cl = dyn_cast<ConstantExpr>(l))                 \
     if (ConstantExpr *cr = dyn_cast<ConstantExpr>(r))               \
       return cl->_op(cr);                                           \
-  return _e_op ## _create(l, r);                                    \
+  return rewrite(_e_op ## _create(l, r));                           \
 }
 
 BCREATE_R(AddExpr, Add, AddExpr_createPartial, AddExpr_createPartialR)
@@ -970,7 +1059,7 @@ ref<Expr>  _e_op ::create(const ref<Expr> &l, const ref<Expr> &r) { \
   if (ConstantExpr *cl = dyn_cast<ConstantExpr>(l))                     \
     if (ConstantExpr *cr = dyn_cast<ConstantExpr>(r))                   \
       return cl->_op(cr);                                               \
-  return _e_op ## _create(l, r);                                        \
+  return rewrite(_e_op ## _create(l, r));                               \
 }
 
 #define CMPCREATE_T(_e_op, _op, _reflexive_e_op, partialL, partialR) \
@@ -979,11 +1068,11 @@ ref<Expr>  _e_op ::create(const ref<Expr> &l, const ref<Expr> &r) {    \
   if (ConstantExpr *cl = dyn_cast<ConstantExpr>(l)) {                  \
     if (ConstantExpr *cr = dyn_cast<ConstantExpr>(r))                  \
       return cl->_op(cr);                                              \
-    return partialR(cl, r.get());                                      \
+    return rewrite(partialR(cl, r.get()));                             \
   } else if (ConstantExpr *cr = dyn_cast<ConstantExpr>(r)) {           \
-    return partialL(l.get(), cr);                                      \
+    return rewrite(partialL(l.get(), cr));                             \
   } else {                                                             \
-    return _e_op ## _create(l.get(), r.get());                         \
+    return rewrite(_e_op ## _create(l.get(), r.get()));                \
   }                                                                    \
 }
   
@@ -0,0 +1,347 @@
+//===-- ExprRewriter.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/util/ExprRewriter.h"
+
+#include "klee/util/ExprHashMap.h"
+
+#include "llvm/ADT/APInt.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace klee;
+
+/// The number of rewrite results kept before the memo cache is flushed.
+static const unsigned MaxMemoSize = 1 << 16;
+
+/***/
+
+// Each rule returns the rewritten expression, or null if it does not apply.
+// Rules only rebuild from strict subexpressions of their input, so that
+// rewriting terminates.
+
+// Extract(Extract(x, o1), o2, w) == Extract(x, o1+o2, w)
+static ref<Expr> ExtractOfExtract(const Expr *e) {
+  const ExtractExpr *ee = cast<ExtractExpr>(e);
+  if (const ExtractExpr *inner = dyn_cast<ExtractExpr>(ee->expr))
+    return ExtractExpr::create(inner->expr, inner->offset + ee->offset,
+                               ee->width);
+  return 0;
+}
+
+// Extract(ZExt(x), off, w) only reads bits of x and zeros.
+static ref<Expr> ExtractOfZExt(const Expr *e) {
+  const ExtractExpr *ee = cast<ExtractExpr>(e);
+  const ZExtExpr *ze = dyn_cast<ZExtExpr>(ee->expr);
+  if (!ze)
+    return 0;
+  unsigned srcWidth = ze->src->getWidth();
+  if (ee->offset >= srcWidth)
+    return ConstantExpr::alloc(0, ee->width);
+  if (ee->offset + ee->width <= srcWidth)
+    return ExtractExpr::create(ze->src, ee->offset, ee->width);
+  return ZExtExpr::create(ExtractExpr::create(ze->src, ee->offset,
+                                              srcWidth - ee->offset),
+                          ee->width);
+}
+
+// Extract(SExt(x), off, w) == Extract(x, off, w) below the extension.
+static ref<Expr> ExtractOfSExt(const Expr *e) {
+  const ExtractExpr *ee = cast<ExtractExpr>(e);
+  const SExtExpr *se = dyn_cast<SExtExpr>(ee->expr);
+  if (se && ee->offset + ee->width <= se->src->getWidth())
+    return ExtractExpr::create(se->src, ee->offset, ee->width);
+  return 0;
+}
+
+// ZExt(ZExt(x)) == ZExt(x)
+static ref<Expr> ZExtOfZExt(const Expr *e) {
+  const ZExtExpr *ze = cast<ZExtExpr>(e);
+  if (const ZExtExpr *inner = dyn_cast<ZExtExpr>(ze->src))
+    return ZExtExpr::create(inner->src, ze->width);
+  return 0;
+}
+
+// SExt(SExt(x)) == SExt(x), and SExt(ZExt(x)) == ZExt(x) since the zero
+// extension always clears the sign bit.
+static ref<Expr> SExtOfExt(const Expr *e) {
+  const SExtExpr *se = cast<SExtExpr>(e);
+  if (const SExtExpr *inner = dyn_cast<SExtExpr>(se->src))
+    return SExtExpr::create(inner->src, se->width);
+  if (const ZExtExpr *inner = dyn_cast<ZExtExpr>(se->src))
+    return ZExtExpr::create(inner->src, se->width);
+  return 0;
+}
+
+// Not(Not(x)) == x
+static ref<Expr> NotOfNot(const Expr *e) {
+  const NotExpr *ne = cast<NotExpr>(e);
+  if (const NotExpr *inner = dyn_cast<NotExpr>(ne->expr))
+    return inner->expr;
+  return 0;
+}
+
+// Select(c, Select(c, a, b), f) == Select(c, a, f), and likewise for the
+// false branch.
+static ref<Expr> SelectOfSameCond(const Expr *e) {
+  const SelectExpr *se = cast<SelectExpr>(e);
+  if (const SelectExpr *t = dyn_cast<SelectExpr>(se->trueExpr))
+    if (t->cond == se->cond)
+      return SelectExpr::create(se->cond, t->trueExpr, se->falseExpr);
+  if (const SelectExpr *f = dyn_cast<SelectExpr>(se->falseExpr))
+    if (f->cond == se->cond)
+      return SelectExpr::create(se->cond, se->trueExpr, f->falseExpr);
+  return 0;
+}
+
+// Compare(ext(a), ext(b)) == Compare(a, b) when both sides are extended the
+// same way from the same width. Both extensions preserve the unsigned
+// order, sign extension preserves the signed order, and zero extended
+// values are never negative.
+static ref<Expr> CompareOfExts(const Expr *e) {
+  const CmpExpr *ce = cast<CmpExpr>(e);
+  const CastExpr *l = dyn_cast<CastExpr>(ce->left);
+  const CastExpr *r = dyn_cast<CastExpr>(ce->right);
+  if (!l || !r || l->getKind() != r->getKind() ||
+      l->src->getWidth() != r->src->getWidth())
+    return 0;
+  bool isZExt = isa<ZExtExpr>(l);
+
+  switch (e->getKind()) {
+  case Expr::Eq:
+    return EqExpr::create(l->src, r->src);
+  case Expr::Ult:
+    return UltExpr::create(l->src, r->src);
+  case Expr::Ule:
+    return UleExpr::create(l->src, r->src);
+  case Expr::Slt:
+    return isZExt ? UltExpr::create(l->src, r->src)
+                  : SltExpr::create(l->src, r->src);
+  case Expr::Sle:
+    return isZExt ? UleExpr::create(l->src, r->src)
+                  : SleExpr::create(l->src, r->src);
+  default:
+    return 0;
+  }
+}
+
+// Ult/Ule between a zero extension and a constant can be decided outright
+// if the constant is out of range of the unextended value, and can be done
+// at the narrow width otherwise.
+static ref<Expr> CompareOfZExtConstant(const Expr *e) {
+  const CmpExpr *ce = cast<CmpExpr>(e);
+  bool strict = e->getKind() == Expr::Ult;
+  const ZExtExpr *ze;
+  const ConstantExpr *c;
+  bool constOnLeft;
+  if ((ze = dyn_cast<ZExtExpr>(ce->left)) &&
+      (c = dyn_cast<ConstantExpr>(ce->right))) {
+    constOnLeft = false;
+  } else if ((ze = dyn_cast<ZExtExpr>(ce->right)) &&
+             (c = dyn_cast<ConstantExpr>(ce->left))) {
+    constOnLeft = true;
+  } else {
+    return 0;
+  }
+
+  Expr::Width srcWidth = ze->src->getWidth();
+  ref<ConstantExpr> maxValue =
+    ConstantExpr::alloc(llvm::APInt::getMaxValue(srcWidth))->ZExt(c->getWidth());
+  ref<ConstantExpr> cv(const_cast<ConstantExpr*>(c));
+
+  if (!constOnLeft) {
+    // zext(x) < c is true for c > max; zext(x) <= c for c >= max.
+    if (strict ? cv->Ugt(maxValue)->isTrue() : cv->Uge(maxValue)->isTrue())
+      return ConstantExpr::alloc(1, Expr::Bool);
+    ref<Expr> narrow = cv->Extract(0, srcWidth);
+    return strict ? UltExpr::create(ze->src, narrow)
+                  : UleExpr::create(ze->src, narrow);
+  }
+
+  // c < zext(x) is false for c >= max; c <= zext(x) for c > max.
+  if (strict ? cv->Uge(maxValue)->isTrue() : cv->Ugt(maxValue)->isTrue())
+    return ConstantExpr::alloc(0, Expr::Bool);
+  ref<Expr> narrow = cv->Extract(0, srcWidth);
+  return strict ? UltExpr::create(narrow, ze->src)
+                : UleExpr::create(narrow, ze->src);
+}
+
+// Eq(Concat(a, b), Concat(c, d)) == And(Eq(a, c), Eq(b, d)) when the
+// concatenations split at the same bit, including against a constant.
+static ref<Expr> EqOfConcats(const Expr *e) {
+  const EqExpr *ee = cast<EqExpr>(e);
+  const ConcatExpr *r = dyn_cast<ConcatExpr>(ee->right);
+  if (!r)
+    return 0;
+  Expr::Width lowWidth = r->getRight()->getWidth();
+  Expr::Width highWidth = r->getLeft()->getWidth();
+
+  if (const ConcatExpr *l = dyn_cast<ConcatExpr>(ee->left)) {
+    if (l->getRight()->getWidth() != lowWidth)
+      return 0;
+    return AndExpr::create(EqExpr::create(l->getLeft(), r->getLeft()),
+                           EqExpr::create(l->getRight(), r->getRight()));
+  }
+  if (ConstantExpr *c = dyn_cast<ConstantExpr>(ee->left))
+    return AndExpr::create(
+      EqExpr::create(c->Extract(lowWidth, highWidth), r->getLeft()),
+      EqExpr::create(c->Extract(0, lowWidth), r->getRight()));
+  return 0;
+}
+
+// op(c1, op(c2, x)) == op(c1 op c2, x) for the associative and commutative
+// Mul, And, Or and Xor, whichever side the constants are on.
+static ref<Expr> ReassociateConstants(const Expr *e) {
+  const BinaryExpr *be = cast<BinaryExpr>(e);
+  ref<Expr> c1 = be->left, inner = be->right;
+  if (!isa<ConstantExpr>(c1))
+    std::swap(c1, inner);
+  if (!isa<ConstantExpr>(c1) || inner->getKind() != e->getKind())
+    return 0;
+
+  ref<Expr> c2 = inner->getKid(0), x = inner->getKid(1);
+  if (!isa<ConstantExpr>(c2))
+    std::swap(c2, x);
+  if (!isa<ConstantExpr>(c2))
+    return 0;
+
+  switch (e->getKind()) {
+  case Expr::Mul:
+    return MulExpr::create(MulExpr::create(c1, c2), x);
+  case Expr::And:
+    return AndExpr::create(AndExpr::create(c1, c2), x);
+  case Expr::Or:
+    return OrExpr::create(OrExpr::create(c1, c2), x);
+  case Expr::Xor:
+    return XorExpr::create(XorExpr::create(c1, c2), x);
+  default:
+    return 0;
+  }
+}
+
+// Shl(Shl(x, c1), c2) == Shl(x, c1+c2), and likewise for LShr, where a
+// total shift of at least the width gives zero.
+static ref<Expr> ShiftOfShift(const Expr *e) {
+  const BinaryExpr *be = cast<BinaryExpr>(e);
+  const ConstantExpr *c2 = dyn_cast<ConstantExpr>(be->right);
+  if (!c2 || be->left->getKind() != e->getKind())
+    return 0;
+  const ConstantExpr *c1 = dyn_cast<ConstantExpr>(be->left->getKid(1));
+  Expr::Width w = e->getWidth();
+  if (!c1 || w > 64)
+    return 0;
+
+  uint64_t s1 = c1->getZExtValue(), s2 = c2->getZExtValue();
+  if (s1 >= w || s2 >= w || s1 + s2 >= w)
+    return ConstantExpr::alloc(0, w);
+  ref<Expr> x = be->left->getKid(0);
+  ref<Expr> amount = ConstantExpr::alloc(s1 + s2, w);
+  return e->getKind() == Expr::Shl ? ShlExpr::create(x, amount)
+                                   : LShrExpr::create(x, amount);
+}
+
+/***/
+
+namespace {
+  struct RewriteRule {
+    const char *name;
+    Expr::Kind kind;
+    ref<Expr> (*apply)(const Expr *e);
+    uint64_t hits;
+  };
+}
+
+static RewriteRule rules[] = {
+  { "ExtractOfExtract", Expr::Extract, ExtractOfExtract, 0 },
+  { "ExtractOfZExt", Expr::Extract, ExtractOfZExt, 0 },
+  { "ExtractOfSExt", Expr::Extract, ExtractOfSExt, 0 },
+  { "ZExtOfZExt", Expr::ZExt, ZExtOfZExt, 0 },
+  { "SExtOfExt", Expr::SExt, SExtOfExt, 0 },
+  { "NotOfNot", Expr::Not, NotOfNot, 0 },
+  { "SelectOfSameCond", Expr::Select, SelectOfSameCond, 0 },
+  { "EqOfExts", Expr::Eq, CompareOfExts, 0 },
+  { "EqOfConcats", Expr::Eq, EqOfConcats, 0 },
+  { "UltOfExts", Expr::Ult, CompareOfExts, 0 },
+  { "UltOfZExtConstant", Expr::Ult, CompareOfZExtConstant, 0 },
+  { "UleOfExts", Expr::Ule, CompareOfExts, 0 },
+  { "UleOfZExtConstant", Expr::Ule, CompareOfZExtConstant, 0 },
+  { "SltOfExts", Expr::Slt, CompareOfExts, 0 },
+  { "SleOfExts", Expr::Sle, CompareOfExts, 0 },
+  { "MulConstants", Expr::Mul, ReassociateConstants, 0 },
+  { "AndConstants", Expr::And, ReassociateConstants, 0 },
+  { "OrConstants", Expr::Or, ReassociateConstants, 0 },
+  { "XorConstants", Expr::Xor, ReassociateConstants, 0 },
+  { "ShlOfShl", Expr::Shl, ShiftOfShift, 0 },
+  { "LShrOfLShr", Expr::LShr, ShiftOfShift, 0 },
+};
+
+static const unsigned NumRules = sizeof(rules) / sizeof(rules[0]);
+
+/// The rules for each kind, as indices into the rule table.
+static std::vector<std::vector<unsigned> > &getRulesByKind() {
+  static std::vector<std::vector<unsigned> > rulesByKind;
+  if (rulesByKind.empty()) {
+    rulesByKind.resize(Expr::LastKind + 1);
+    for (unsigned i = 0; i != NumRules; ++i)
+      rulesByKind[rules[i].kind].push_back(i);
+  }
+  return rulesByKind;
+}
+
+static ExprHashMap< ref<Expr> > memo;
+static uint64_t memoHits = 0;
+
+ref<Expr> ExprRewriter::rewrite(const ref<Expr> &e) {
+  if (isa<ConstantExpr>(e))
+    return e;
+  const std::vector<unsigned> &candidates = getRulesByKind()[e->getKind()];
+  if (candidates.empty())
+    return e;
+
+  ExprHashMap< ref<Expr> >::iterator it = memo.find(e);
+  if (it != memo.end()) {
+    ++memoHits;
+    return it->second;
+  }
+
+  ref<Expr> result = e;
+  for (std::vector<unsigned>::const_iterator ri = candidates.begin(),
+         re = candidates.end(); ri != re; ++ri) {
+    ref<Expr> rewritten = rules[*ri].apply(e.get());
+    if (!rewritten.isNull()) {
+      ++rules[*ri].hits;
+      result = rewritten;
+      break;
+    }
+  }
+
+  if (memo.size() >= MaxMemoSize)
+    memo.clear();
+  memo.insert(std::make_pair(e, result));
+  return result;
+}
+
+unsigned ExprRewriter::getNumRules() {
+  return NumRules;
+}
+
+const char *ExprRewriter::getRuleName(unsigned rule) {
+  assert(rule < NumRules && "invalid rule");
+  return rules[rule].name;
+}
+
+uint64_t ExprRewriter::getRuleHits(unsigned rule) {
+  assert(rule < NumRules && "invalid rule");
+  return rules[rule].hits;
+}
+
+uint64_t ExprRewriter::getMemoHits() {
+  return memoHits;
+}
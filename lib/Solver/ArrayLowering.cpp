@@ -0,0 +1,74 @@
+//===-- ArrayLowering.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ArrayLowering.h"
+
+#include "klee/Expr.h"
+#include "klee/SolverStats.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+  llvm::cl::opt<unsigned>
+  MaxITEArraySize("max-ite-array-size",
+                  llvm::cl::desc("Lower symbolic-index reads from arrays of "
+                                 "at most this many bytes, with at most as "
+                                 "many updates, to if-then-else chains "
+                                 "instead of array reads (0=off) "
+                                 "(default=8)"),
+                  llvm::cl::init(8));
+}
+
+bool klee::shouldLowerReadToITE(const ReadExpr *re) {
+  if (isa<ConstantExpr>(re->index))
+    return false;
+
+  const Array *root = re->updates.root;
+  if (root->size != 0 && root->size <= MaxITEArraySize &&
+      re->updates.getSize() <= MaxITEArraySize) {
+    ++stats::queryReadsLoweredToITE;
+    return true;
+  }
+
+  ++stats::queryReadsAsArrays;
+  return false;
+}
+
+ref<Expr> klee::lowerReadToITE(const ReadExpr *re, ref<Expr> &inBounds) {
+  const Array *root = re->updates.root;
+  Expr::Width width = re->index->getWidth();
+  inBounds = UltExpr::create(re->index, ConstantExpr::create(root->size, width));
+
+  UpdateList initial(root, 0);
+  ref<Expr> res;
+  for (unsigned i = root->size; i != 0; --i) {
+    ref<Expr> index = ConstantExpr::create(i - 1, width);
+    ref<Expr> value = root->isConstantArray() ?
+      ref<Expr>(root->constantValues[i - 1]) : ReadExpr::create(initial, index);
+    if (i == root->size) {
+      res = value;
+    } else {
+      res = SelectExpr::create(EqExpr::create(re->index, index), value, res);
+    }
+  }
+
+  std::vector<const UpdateNode*> updates;
+  for (const UpdateNode *un = re->updates.head; un; un = un->next)
+    updates.push_back(un);
+  for (std::vector<const UpdateNode*>::reverse_iterator it = updates.rbegin(),
+         ie = updates.rend(); it != ie; ++it)
+    res = SelectExpr::create(EqExpr::create(re->index, (*it)->index),
+                             (*it)->value, res);
+
+  return res;
+}
@@ -0,0 +1,37 @@
+//===-- ArrayLowering.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef __UTIL_ARRAYLOWERING_H__
+#define __UTIL_ARRAYLOWERING_H__
+
+#include "klee/util/Ref.h"
+
+namespace klee {
+class Expr;
+class ReadExpr;
+
+/// shouldLowerReadToITE - Return true if the symbolic-index read \a re
+/// should be given to the core solver as a chain of if-then-else terms over
+/// the elements of the array, rather than as an array theory read.
+///
+/// This is only chosen for arrays small enough (in both size and number of
+/// updates) that the chain is cheaper than the array axioms it replaces.
+/// Each symbolic-index read is counted in the QueryReadsLoweredToITE or
+/// QueryReadsAsArrays statistic.
+bool shouldLowerReadToITE(const ReadExpr *re);
+
+/// lowerReadToITE - Return the value of the read \a re as a chain of selects,
+/// first over the initial elements of the array and then over its updates
+/// from oldest to newest. The chain only gives the value of the read when
+/// \a inBounds, which is set to the condition that the index is within the
+/// array, holds; builders must fall back to an array read otherwise.
+ref<Expr> lowerReadToITE(const ReadExpr *re, ref<Expr> &inBounds);
+}
+
+#endif
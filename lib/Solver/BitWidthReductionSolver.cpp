@@ -0,0 +1,490 @@
+//===-- BitWidthReductionSolver.cpp ---------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/SolverImpl.h"
+#include "klee/SolverStats.h"
+#include "klee/util/ExprHashMap.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace klee;
+
+/// The number of expressions kept in each of the reducer caches before they
+/// are flushed.
+static const unsigned MaxCacheSize = 1 << 16;
+
+namespace {
+  /// WidthReducer - Rewrite comparisons to the narrowest width which can
+  /// represent both of their operands.
+  ///
+  /// The value of every expression is over-approximated by the number of
+  /// low bits it is the zero extension of, and the number it is the sign
+  /// extension of. A comparison whose operands both fit in fewer bits than
+  /// their width is done on the truncated operands instead, and truncation
+  /// is pushed through the arithmetic down to the extensions, which it
+  /// removes. The rewritten expressions read exactly the same arrays, so a
+  /// model of a reduced query is a model of the original one as well.
+  class WidthReducer {
+    ExprHashMap<unsigned> activeBits, signBits;
+    ExprHashMap< ref<Expr> > reduced;
+
+  public:
+    /// reduce - Return a boolean expression equivalent to \a e with its
+    /// comparisons narrowed.
+    ref<Expr> reduce(const ref<Expr> &e);
+
+    /// truncate - Return an expression for the low \a w bits of \a e,
+    /// which is cheaper than extracting them if possible.
+    ref<Expr> truncate(const ref<Expr> &e, Expr::Width w);
+
+    /// getActiveBits - Return a number of bits, such that \a e is always
+    /// the zero extension of its value in that many low bits.
+    unsigned getActiveBits(const ref<Expr> &e);
+
+    /// getSignBits - Return a number of bits, such that \a e is always the
+    /// sign extension of its value in that many low bits.
+    unsigned getSignBits(const ref<Expr> &e);
+
+  private:
+    unsigned computeActiveBits(const ref<Expr> &e);
+    unsigned computeSignBits(const ref<Expr> &e);
+    ref<Expr> reduceCompare(const ref<Expr> &e);
+  };
+}
+
+unsigned WidthReducer::getActiveBits(const ref<Expr> &e) {
+  ExprHashMap<unsigned>::iterator it = activeBits.find(e);
+  if (it != activeBits.end())
+    return it->second;
+  unsigned result = std::min(computeActiveBits(e), e->getWidth());
+  if (activeBits.size() >= MaxCacheSize)
+    activeBits.clear();
+  activeBits.insert(std::make_pair(e, result));
+  return result;
+}
+
+unsigned WidthReducer::computeActiveBits(const ref<Expr> &e) {
+  Expr::Width width = e->getWidth();
+
+  switch (e->getKind()) {
+  case Expr::Constant:
+    return cast<ConstantExpr>(e)->getAPValue().getActiveBits();
+
+  case Expr::ZExt:
+    return getActiveBits(cast<ZExtExpr>(e)->src);
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    unsigned bits = getActiveBits(ee->expr);
+    return bits <= ee->offset ? 0 : bits - ee->offset;
+  }
+
+  case Expr::Concat: {
+    const ConcatExpr *ce = cast<ConcatExpr>(e);
+    unsigned high = getActiveBits(ce->getLeft());
+    return high ? ce->getRight()->getWidth() + high
+                : getActiveBits(ce->getRight());
+  }
+
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    return std::max(getActiveBits(se->trueExpr),
+                    getActiveBits(se->falseExpr));
+  }
+
+  case Expr::Add:
+    return std::max(getActiveBits(e->getKid(0)),
+                    getActiveBits(e->getKid(1))) + 1;
+  case Expr::Mul:
+    return getActiveBits(e->getKid(0)) + getActiveBits(e->getKid(1));
+  case Expr::UDiv:
+  case Expr::URem: {
+    // Division by zero gives all ones and x urem 0 is x, so only a
+    // nonzero constant divisor bounds the result by more than that.
+    const ConstantExpr *ce = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!ce || ce->isZero())
+      return e->getKind() == Expr::UDiv ? width : getActiveBits(e->getKid(0));
+    if (e->getKind() == Expr::UDiv)
+      return getActiveBits(e->getKid(0));
+    return std::min(getActiveBits(e->getKid(0)),
+                    ce->getAPValue().getActiveBits());
+  }
+  case Expr::And:
+    return std::min(getActiveBits(e->getKid(0)),
+                    getActiveBits(e->getKid(1)));
+  case Expr::Or:
+  case Expr::Xor:
+    return std::max(getActiveBits(e->getKid(0)),
+                    getActiveBits(e->getKid(1)));
+
+  case Expr::Shl:
+  case Expr::LShr:
+  case Expr::AShr: {
+    const ConstantExpr *ce = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!ce)
+      return width;
+    if (ce->getAPValue().uge(width))
+      return e->getKind() == Expr::AShr ? width : 0;
+    unsigned shift = ce->getAPValue().getZExtValue();
+    unsigned bits = getActiveBits(e->getKid(0));
+    if (e->getKind() == Expr::Shl)
+      return bits + shift;
+    // An arithmetic shift of a value with a clear sign bit is logical.
+    if (e->getKind() == Expr::AShr && bits == width)
+      return width;
+    return bits <= shift ? 0 : bits - shift;
+  }
+
+  default:
+    return width;
+  }
+}
+
+unsigned WidthReducer::getSignBits(const ref<Expr> &e) {
+  ExprHashMap<unsigned>::iterator it = signBits.find(e);
+  if (it != signBits.end())
+    return it->second;
+  // A value with a clear top bit is the sign extension of one more bit
+  // than it is the zero extension of.
+  unsigned result = std::min(computeSignBits(e), getActiveBits(e) + 1);
+  result = std::max(1U, std::min(result, e->getWidth()));
+  if (signBits.size() >= MaxCacheSize)
+    signBits.clear();
+  signBits.insert(std::make_pair(e, result));
+  return result;
+}
+
+unsigned WidthReducer::computeSignBits(const ref<Expr> &e) {
+  Expr::Width width = e->getWidth();
+
+  switch (e->getKind()) {
+  case Expr::Constant:
+    return cast<ConstantExpr>(e)->getAPValue().getMinSignedBits();
+
+  case Expr::SExt:
+    return getSignBits(cast<SExtExpr>(e)->src);
+
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    return std::max(getSignBits(se->trueExpr), getSignBits(se->falseExpr));
+  }
+
+  case Expr::Not:
+    return getSignBits(e->getKid(0));
+
+  case Expr::Add:
+  case Expr::Sub:
+    return std::max(getSignBits(e->getKid(0)),
+                    getSignBits(e->getKid(1))) + 1;
+  case Expr::Mul:
+    return getSignBits(e->getKid(0)) + getSignBits(e->getKid(1));
+  case Expr::And:
+  case Expr::Or:
+  case Expr::Xor:
+    return std::max(getSignBits(e->getKid(0)), getSignBits(e->getKid(1)));
+
+  case Expr::AShr: {
+    const ConstantExpr *ce = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!ce)
+      return width;
+    unsigned bits = getSignBits(e->getKid(0));
+    if (ce->getAPValue().uge(width))
+      return 1;
+    unsigned shift = ce->getAPValue().getZExtValue();
+    return bits <= shift ? 1 : bits - shift;
+  }
+
+  default:
+    return width;
+  }
+}
+
+ref<Expr> WidthReducer::truncate(const ref<Expr> &e, Expr::Width w) {
+  assert(w && w <= e->getWidth() && "invalid truncation");
+
+  // Extracting the low bits is a truncation in itself.
+  if (const ExtractExpr *ee = dyn_cast<ExtractExpr>(e)) {
+    if (ee->offset == 0)
+      return truncate(ee->expr, w);
+    return ExtractExpr::create(ee->expr, ee->offset, w);
+  }
+
+  if (w == e->getWidth())
+    return e;
+
+  switch (e->getKind()) {
+  case Expr::ZExt: {
+    const ZExtExpr *ze = cast<ZExtExpr>(e);
+    if (w >= ze->src->getWidth())
+      return ZExtExpr::create(ze->src, w);
+    return truncate(ze->src, w);
+  }
+
+  case Expr::SExt: {
+    const SExtExpr *se = cast<SExtExpr>(e);
+    if (w >= se->src->getWidth())
+      return SExtExpr::create(se->src, w);
+    return truncate(se->src, w);
+  }
+
+  case Expr::Concat: {
+    const ConcatExpr *ce = cast<ConcatExpr>(e);
+    Expr::Width low = ce->getRight()->getWidth();
+    if (w <= low)
+      return truncate(ce->getRight(), w);
+    return ConcatExpr::create(truncate(ce->getLeft(), w - low),
+                              ce->getRight());
+  }
+
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    return SelectExpr::create(se->cond, truncate(se->trueExpr, w),
+                              truncate(se->falseExpr, w));
+  }
+
+  case Expr::Not:
+    return NotExpr::create(truncate(e->getKid(0), w));
+
+  // The low bits of these only depend on the low bits of their operands.
+  case Expr::Add:
+    return AddExpr::create(truncate(e->getKid(0), w),
+                           truncate(e->getKid(1), w));
+  case Expr::Sub:
+    return SubExpr::create(truncate(e->getKid(0), w),
+                           truncate(e->getKid(1), w));
+  case Expr::Mul:
+    return MulExpr::create(truncate(e->getKid(0), w),
+                           truncate(e->getKid(1), w));
+  case Expr::And:
+    return AndExpr::create(truncate(e->getKid(0), w),
+                           truncate(e->getKid(1), w));
+  case Expr::Or:
+    return OrExpr::create(truncate(e->getKid(0), w),
+                          truncate(e->getKid(1), w));
+  case Expr::Xor:
+    return XorExpr::create(truncate(e->getKid(0), w),
+                           truncate(e->getKid(1), w));
+
+  case Expr::Shl:
+    if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(e->getKid(1))) {
+      if (ce->getAPValue().uge(w))
+        return ConstantExpr::alloc(0, w);
+      return ShlExpr::create(truncate(e->getKid(0), w),
+                             ConstantExpr::alloc(ce->getAPValue().getZExtValue(), w));
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  return ExtractExpr::create(e, 0, w);
+}
+
+ref<Expr> WidthReducer::reduceCompare(const ref<Expr> &e) {
+  ref<Expr> left = e->getKid(0), right = e->getKid(1);
+  Expr::Width width = left->getWidth();
+  Expr::Kind kind = e->getKind();
+
+  unsigned active = std::max(1U, std::max(getActiveBits(left),
+                                          getActiveBits(right)));
+  unsigned sign = std::max(getSignBits(left), getSignBits(right));
+  unsigned narrow = width;
+  if (active < width && active <= sign) {
+    // Both sides are non-negative, so the signed order is the unsigned one.
+    narrow = active;
+    if (kind == Expr::Slt)
+      kind = Expr::Ult;
+    else if (kind == Expr::Sle)
+      kind = Expr::Ule;
+  } else if (sign < width) {
+    // Sign extension preserves both the signed and the unsigned order.
+    narrow = sign;
+  }
+
+  left = truncate(left, narrow);
+  right = truncate(right, narrow);
+  switch (kind) {
+  case Expr::Eq:  return EqExpr::create(left, right);
+  case Expr::Ult: return UltExpr::create(left, right);
+  case Expr::Ule: return UleExpr::create(left, right);
+  case Expr::Slt: return SltExpr::create(left, right);
+  case Expr::Sle: return SleExpr::create(left, right);
+  default:
+    assert(0 && "unexpected comparison");
+    return e;
+  }
+}
+
+ref<Expr> WidthReducer::reduce(const ref<Expr> &e) {
+  if (isa<ConstantExpr>(e))
+    return e;
+  ExprHashMap< ref<Expr> >::iterator it = reduced.find(e);
+  if (it != reduced.end())
+    return it->second;
+
+  ref<Expr> result = e;
+  switch (e->getKind()) {
+  case Expr::Not:
+    result = NotExpr::create(reduce(e->getKid(0)));
+    break;
+  case Expr::And:
+    result = AndExpr::create(reduce(e->getKid(0)), reduce(e->getKid(1)));
+    break;
+  case Expr::Or:
+    result = OrExpr::create(reduce(e->getKid(0)), reduce(e->getKid(1)));
+    break;
+  case Expr::Xor:
+    result = XorExpr::create(reduce(e->getKid(0)), reduce(e->getKid(1)));
+    break;
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    result = SelectExpr::create(reduce(se->cond), reduce(se->trueExpr),
+                                reduce(se->falseExpr));
+    break;
+  }
+  case Expr::Eq:
+    if (e->getKid(0)->getWidth() == Expr::Bool) {
+      result = EqExpr::create(reduce(e->getKid(0)), reduce(e->getKid(1)));
+      break;
+    }
+    // Fall through.
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Slt:
+  case Expr::Sle:
+    result = reduceCompare(e);
+    break;
+  default:
+    break;
+  }
+
+  if (reduced.size() >= MaxCacheSize)
+    reduced.clear();
+  reduced.insert(std::make_pair(e, result));
+  return result;
+}
+
+/***/
+
+class BitWidthReductionSolver : public SolverImpl {
+private:
+  Solver *solver;
+  WidthReducer reducer;
+
+  /// Reduce the constraints of \a query into \a constraints, and return
+  /// the reduced query expression.
+  ref<Expr> reduceQuery(const Query &query,
+                        std::vector< ref<Expr> > &constraints);
+
+public:
+  BitWidthReductionSolver(Solver *_solver) : solver(_solver) {}
+  ~BitWidthReductionSolver() { delete solver; }
+
+  bool computeTruth(const Query&, bool &isValid);
+  bool computeValidity(const Query&, Solver::Validity &result);
+  bool computeValue(const Query&, ref<Expr> &result);
+  bool computeInitialValues(const Query& query,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query&);
+  void setCoreSolverTimeout(double timeout);
+};
+
+ref<Expr>
+BitWidthReductionSolver::reduceQuery(const Query &query,
+                                     std::vector< ref<Expr> > &constraints) {
+  bool changed = false;
+  for (ConstraintManager::const_iterator it = query.constraints.begin(),
+         ie = query.constraints.end(); it != ie; ++it) {
+    ref<Expr> e = reducer.reduce(*it);
+    changed |= e != *it;
+    constraints.push_back(e);
+  }
+
+  ref<Expr> expr = query.expr;
+  if (expr->getWidth() == Expr::Bool)
+    expr = reducer.reduce(expr);
+  changed |= expr != query.expr;
+  if (changed)
+    ++stats::queryBitWidthReductions;
+  return expr;
+}
+
+bool BitWidthReductionSolver::computeTruth(const Query& query,
+                                           bool &isValid) {
+  std::vector< ref<Expr> > reduced;
+  ref<Expr> expr = reduceQuery(query, reduced);
+  ConstraintManager constraints(reduced);
+  return solver->impl->computeTruth(Query(constraints, expr), isValid);
+}
+
+bool BitWidthReductionSolver::computeValidity(const Query& query,
+                                              Solver::Validity &result) {
+  std::vector< ref<Expr> > reduced;
+  ref<Expr> expr = reduceQuery(query, reduced);
+  ConstraintManager constraints(reduced);
+  return solver->impl->computeValidity(Query(constraints, expr), result);
+}
+
+bool BitWidthReductionSolver::computeValue(const Query& query,
+                                           ref<Expr> &result) {
+  std::vector< ref<Expr> > reduced;
+  ref<Expr> expr = reduceQuery(query, reduced);
+  ConstraintManager constraints(reduced);
+
+  // Only ask for the bits the value can have set, and extend the answer.
+  Expr::Width width = expr->getWidth();
+  unsigned active = std::max(1U, reducer.getActiveBits(expr));
+  if (active < width)
+    expr = reducer.truncate(expr, active);
+  if (!solver->impl->computeValue(Query(constraints, expr), result))
+    return false;
+  if (active < width)
+    result = ZExtExpr::create(result, width);
+  return true;
+}
+
+bool BitWidthReductionSolver::computeInitialValues(const Query& query,
+                                                   const std::vector<const Array*>
+                                                     &objects,
+                                                   std::vector< std::vector<unsigned char> >
+                                                     &values,
+                                                   bool &hasSolution) {
+  // The reduced query reads the same arrays as the original one, so its
+  // model needs no mapping back.
+  std::vector< ref<Expr> > reduced;
+  ref<Expr> expr = reduceQuery(query, reduced);
+  ConstraintManager constraints(reduced);
+  return solver->impl->computeInitialValues(Query(constraints, expr), objects,
+                                            values, hasSolution);
+}
+
+SolverImpl::SolverRunStatus BitWidthReductionSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *BitWidthReductionSolver::getConstraintLog(const Query& query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void BitWidthReductionSolver::setCoreSolverTimeout(double timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+Solver *klee::createBitWidthReductionSolver(Solver *s) {
+  return new Solver(new BitWidthReductionSolver(s));
+}
@@ -14,6 +14,7 @@
 #include "klee/SolverImpl.h"
 #include "klee/TimerStatIncrementer.h"
 #include "klee/util/Assignment.h"
+#include "klee/util/ConstraintProgram.h"
 #include "klee/util/ExprUtil.h"
 #include "klee/util/ExprVisitor.h"
 #include "klee/Internal/ADT/MapOfSets.h"
@@ -24,6 +25,10 @@
 
 #include "llvm/Support/CommandLine.h"
 
+#include <algorithm>
+#include <deque>
+#include <map>
+
 using namespace klee;
 using namespace llvm;
 
@@ -44,6 +49,16 @@ namespace {
   cl::opt<bool>
   CexCacheExperimental("cex-cache-exp", cl::init(false));
 
+  cl::opt<bool>
+  CexCacheCompiledEval("cex-cache-compiled-eval",
+                       cl::desc("Check cached counterexamples against a query using a compiled evaluator instead of walking the constraints for each one (default=on)"),
+                       cl::init(true));
+
+  cl::opt<unsigned>
+  CexCacheMaxPrograms("cex-cache-max-programs",
+                      cl::desc("Number of compiled constraint sets kept by --cex-cache-compiled-eval (default=64)"),
+                      cl::init(64));
+
 }
 
 ///
@@ -59,6 +74,7 @@ struct AssignmentLessThan {
 
 class CexCachingSolver : public SolverImpl {
   typedef std::set<Assignment*, AssignmentLessThan> assignmentsTable_ty;
+  typedef std::map<KeyType, ConstraintProgram*> programs_ty;
 
   Solver *solver;
   
@@ -66,7 +82,15 @@ class CexCachingSolver : public SolverImpl {
   // memo table
   assignmentsTable_ty assignmentsTable;
 
-  bool searchForAssignment(KeyType &key, 
+  /// Compiled programs for the constraint sets of recent queries, which
+  /// are shared by all the queries made about a state until its
+  /// constraints change. Evicted in the order they were compiled.
+  programs_ty programs;
+  std::deque<programs_ty::iterator> programOrder;
+
+  const ConstraintProgram &getProgram(const ConstraintManager &constraints);
+
+  bool searchForAssignment(const Query &query, KeyType &key, ref<Expr> neg,
                            Assignment *&result);
   
   bool lookupAssignment(const Query& query, KeyType &key, Assignment *&result);
@@ -106,22 +130,58 @@ struct NonNullAssignment {
 
 struct NullOrSatisfyingAssignment {
   KeyType &key;
+  /// When non-null, the compiled path constraints of the query, and the
+  /// compiled negated query expression if it is part of the key.
+  const ConstraintProgram *program, *negProgram;
   
-  NullOrSatisfyingAssignment(KeyType &_key) : key(_key) {}
+  NullOrSatisfyingAssignment(KeyType &_key, const ConstraintProgram *_program,
+                             const ConstraintProgram *_negProgram)
+    : key(_key), program(_program), negProgram(_negProgram) {}
 
   bool operator()(Assignment *a) const { 
-    return !a || a->satisfies(key.begin(), key.end()); 
+    if (!a)
+      return true;
+    if (program)
+      return (!negProgram || negProgram->satisfies(*a)) &&
+        program->satisfies(*a);
+    return a->satisfies(key.begin(), key.end()); 
   }
 };
 
+/// getProgram - Return the compiled form of \a constraints, compiling them
+/// only the first time they are seen.
+const ConstraintProgram &
+CexCachingSolver::getProgram(const ConstraintManager &constraints) {
+  KeyType key(constraints.begin(), constraints.end());
+  programs_ty::iterator it = programs.find(key);
+  if (it != programs.end())
+    return *it->second;
+
+  if (programOrder.size() >= std::max(1U, (unsigned) CexCacheMaxPrograms)) {
+    delete programOrder.front()->second;
+    programs.erase(programOrder.front());
+    programOrder.pop_front();
+  }
+  ConstraintProgram *program =
+    new ConstraintProgram(constraints.begin(), constraints.end());
+  it = programs.insert(std::make_pair(key, program)).first;
+  programOrder.push_back(it);
+  return *program;
+}
+
 /// searchForAssignment - Look for a cached solution for a query.
 ///
-/// \param key - The query to look up.
+/// \param query - The query to look up.
+/// \param key - The key for the query: its constraints together with \a neg.
+/// \param neg - The negated query expression, or null if it is not part of
+/// the key.
 /// \param result [out] - The cached result, if the lookup is succesful. This is
 /// either a satisfying assignment (for a satisfiable query), or 0 (for an
 /// unsatisfiable query).
 /// \return - True if a cached result was found.
-bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
+bool CexCachingSolver::searchForAssignment(const Query &query, KeyType &key,
+                                           ref<Expr> neg,
+                                           Assignment *&result) {
   Assignment * const *lookup = cache.lookup(key);
   if (lookup) {
     result = *lookup;
@@ -147,13 +207,36 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
 
     // Otherwise, iterate through the set of current assignments to see if one
     // of them satisfies the query.
-    for (assignmentsTable_ty::iterator it = assignmentsTable.begin(), 
-           ie = assignmentsTable.end(); it != ie; ++it) {
-      Assignment *a = *it;
-      if (a->satisfies(key.begin(), key.end())) {
-        result = a;
+    if (CexCacheCompiledEval) {
+      // Check the whole table in batches, first against the query
+      // expression alone and then against the compiled path constraints.
+      std::vector<const Assignment*> assignments(assignmentsTable.begin(),
+                                                 assignmentsTable.end());
+      if (!neg.isNull()) {
+        ConstraintProgram negProgram(&neg, &neg + 1);
+        std::vector<bool> satisfied;
+        negProgram.satisfies(assignments, satisfied);
+        std::vector<const Assignment*> candidates;
+        for (unsigned i = 0; i != assignments.size(); ++i)
+          if (satisfied[i])
+            candidates.push_back(assignments[i]);
+        assignments.swap(candidates);
+      }
+      const ConstraintProgram &program = getProgram(query.constraints);
+      unsigned i = program.findSatisfying(assignments);
+      if (i != assignments.size()) {
+        result = const_cast<Assignment*>(assignments[i]);
         return true;
       }
+    } else {
+      for (assignmentsTable_ty::iterator it = assignmentsTable.begin(), 
+             ie = assignmentsTable.end(); it != ie; ++it) {
+        Assignment *a = *it;
+        if (a->satisfies(key.begin(), key.end())) {
+          result = a;
+          return true;
+        }
+      }
     }
   } else {
     // FIXME: Which order? one is sure to be better.
@@ -169,8 +252,23 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
     // assignment. While searching subsets, we also explicitly the solutions for
     // satisfiable subsets to see if they solve the current query and return
     // them if so. This is cheap and frequently succeeds.
-    if (!lookup) 
-      lookup = cache.findSubset(key, NullOrSatisfyingAssignment(key));
+    if (!lookup) {
+      if (CexCacheCompiledEval) {
+        const ConstraintProgram &program = getProgram(query.constraints);
+        if (neg.isNull()) {
+          lookup = cache.findSubset(key, NullOrSatisfyingAssignment(key,
+                                                                    &program,
+                                                                    0));
+        } else {
+          ConstraintProgram negProgram(&neg, &neg + 1);
+          lookup = cache.findSubset(key, NullOrSatisfyingAssignment(key,
+                                                                    &program,
+                                                                    &negProgram));
+        }
+      } else {
+        lookup = cache.findSubset(key, NullOrSatisfyingAssignment(key, 0, 0));
+      }
+    }
 
     // If either lookup succeeded, then we have a cached solution.
     if (lookup) {
@@ -201,11 +299,12 @@ bool CexCachingSolver::lookupAssignment(const Query &query,
       ++stats::queryCexCacheHits;
       return true;
     }
+    neg = ref<Expr>();
   } else {
     key.insert(neg);
   }
 
-  bool found = searchForAssignment(key, result);
+  bool found = searchForAssignment(query, key, neg, result);
   if (found)
     ++stats::queryCexCacheHits;
   else ++stats::queryCexCacheMisses;
@@ -259,6 +358,9 @@ bool CexCachingSolver::getAssignment(const Query& query, Assignment *&result) {
 
 CexCachingSolver::~CexCachingSolver() {
   cache.clear();
+  for (programs_ty::iterator it = programs.begin(), ie = programs.end();
+       it != ie; ++it)
+    delete it->second;
   delete solver;
   for (assignmentsTable_ty::iterator it = assignmentsTable.begin(), 
          ie = assignmentsTable.end(); it != ie; ++it)
@@ -15,6 +15,7 @@
 #include "klee/util/Bits.h"
 #include "klee/SolverStats.h"
 
+#include "ArrayLowering.h"
 #include "ConstantDivision.h"
 
 #include "llvm/ADT/StringExtras.h"
@@ -559,9 +560,16 @@ ExprHandle STPBuilder::constructActual(ref<Expr> e, int *width_out) {
     ReadExpr *re = cast<ReadExpr>(e);
     assert(re && re->updates.root);
     *width_out = re->updates.root->getRange();
-    return vc_readExpr(vc,
-                       getArrayForUpdate(re->updates.root, re->updates.head),
-                       construct(re->index, 0));
+    ExprHandle read = vc_readExpr(vc,
+                                  getArrayForUpdate(re->updates.root,
+                                                    re->updates.head),
+                                  construct(re->index, 0));
+    if (shouldLowerReadToITE(re)) {
+      ref<Expr> inBounds;
+      ref<Expr> ite = lowerReadToITE(re, inBounds);
+      return vc_iteExpr(vc, construct(inBounds, 0), construct(ite, 0), read);
+    }
+    return read;
   }
     
   case Expr::Select: {
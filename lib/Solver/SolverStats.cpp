@@ -15,6 +15,7 @@ Statistic stats::cexCacheTime("CexCacheTime", "CCtime");
 Statistic stats::queries("Queries", "Q");
 Statistic stats::queriesInvalid("QueriesInvalid", "Qiv");
 Statistic stats::queriesValid("QueriesValid", "Qv");
+Statistic stats::queryBitWidthReductions("QueryBitWidthReductions", "QBWred");
 Statistic stats::queryCacheHits("QueryCacheHits", "QChits") ;
 Statistic stats::queryCacheMisses("QueryCacheMisses", "QCmisses");
 Statistic stats::queryCexCacheHits("QueryCexCacheHits", "QCexHits") ;
@@ -22,6 +23,8 @@ Statistic stats::queryCexCacheMisses("QueryCexCacheMisses", "QCexMisses");
 Statistic stats::queryConstructTime("QueryConstructTime", "QBtime") ;
 Statistic stats::queryConstructs("QueriesConstructs", "QB");
 Statistic stats::queryCounterexamples("QueriesCEX", "Qcex");
+Statistic stats::queryReadsAsArrays("QueryReadsAsArrays", "QRarr");
+Statistic stats::queryReadsLoweredToITE("QueryReadsLoweredToITE", "QRite");
 Statistic stats::queryTime("QueryTime", "Qtime");
 
 #ifdef DEBUG
@@ -13,6 +13,7 @@
 #include "klee/Expr.h"
 #include "klee/Solver.h"
 #include "klee/util/Bits.h"
+#include "ArrayLowering.h"
 #include "ConstantDivision.h"
 #include "klee/SolverStats.h"
 
@@ -484,8 +485,15 @@ Z3ASTHandle Z3Builder::constructActual(ref<Expr> e, int *width_out) {
     ReadExpr *re = cast<ReadExpr>(e);
     assert(re && re->updates.root);
     *width_out = re->updates.root->getRange();
-    return readExpr(getArrayForUpdate(re->updates.root, re->updates.head),
-                    construct(re->index, 0));
+    Z3ASTHandle read =
+        readExpr(getArrayForUpdate(re->updates.root, re->updates.head),
+                 construct(re->index, 0));
+    if (shouldLowerReadToITE(re)) {
+      ref<Expr> inBounds;
+      ref<Expr> ite = lowerReadToITE(re, inBounds);
+      return iteExpr(construct(inBounds, 0), construct(ite, 0), read);
+    }
+    return read;
   }
 
   case Expr::Select: {
@@ -0,0 +1,33 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-abstract-domain %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: FileCheck -check-prefix=CHECK-INFO -input-file=%t.klee-out/info %s
+
+#include "klee/klee.h"
+
+int table[16];
+
+int main() {
+  unsigned char x = klee_range(0, 256, "x");
+  int y = klee_int("y");
+
+  if (x < 10) {
+    // Both of these follow from x < 10 alone.
+    if (x >= 20)
+      return 1;
+    table[x] = y;
+    if (x + 4 < 16) {
+      if (y > 100)
+        return 2;
+      return 3;
+    }
+    return 4;
+  }
+  if (x == 7)
+    return 5;
+  return 0;
+}
+
+// CHECK: KLEE: done: completed paths = 3
+// CHECK-INFO: KLEE: done: queries decided by the abstract domain = {{[1-9][0-9]*}}
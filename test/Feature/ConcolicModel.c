@@ -0,0 +1,29 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-concolic-model %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: FileCheck -check-prefix=CHECK-INFO -input-file=%t.klee-out/info %s
+
+#include "klee/klee.h"
+
+int main() {
+  int x = klee_int("x");
+  int y = klee_int("y");
+  klee_assume(x > 10);
+
+  if (x > 5) {        // always true under the model and the constraints
+    if (y < 42) {
+      if (x == y)
+        return 1;
+      return 2;
+    }
+    if (x + y > 100)
+      return 3;
+  } else {
+    return 4;         // unreachable
+  }
+  return 0;
+}
+
+// CHECK: KLEE: done: completed paths = 4
+// CHECK-INFO: KLEE: done: branches decided by the concolic model = {{[1-9][0-9]*}}
@@ -0,0 +1,26 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --concrete-block-fast-path %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out/info %s
+// RUN: not ls %t.klee-out/*.err
+
+#include "klee/klee.h"
+
+#include <assert.h>
+
+int main() {
+  unsigned i, sum = 0, x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+
+  for (i = 0; i < 100; ++i)
+    sum += i * i;
+  assert(sum == 328350);
+
+  // Symbolic operands still fork as usual.
+  if (x + sum > 5)
+    return 1;
+  return 0;
+}
+
+// CHECK: KLEE: done: instructions on the concrete fast path = {{[1-9][0-9]*}}
+// CHECK: KLEE: done: completed paths = 2
@@ -0,0 +1,13 @@
+// RUN: %llvmgcc -emit-llvm -O0 -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --concrete-block-fast-path --max-time=2 %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+
+int main() {
+  // A loop whose body is a single block must still see the timers.
+  while (1)
+    ;
+  return 0;
+}
+
+// CHECK: KLEE: HaltTimer invoked
@@ -0,0 +1,46 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --const-array-read-opt --use-query-log=all:pc %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: not ls %t.klee-out/*.err
+// RUN: grep -q "Mul w8 3" %t.klee-out/all-queries.pc
+// RUN: rm -rf %t.klee-out2
+// RUN: %klee --output-dir=%t.klee-out2 --use-query-log=all:pc %t.bc > %t.log2 2>&1
+// RUN: not grep -q "Mul w8 3" %t.klee-out2/all-queries.pc
+
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+/* A lookup table made of a constant run and an arithmetic run, as in
+   ctype and scaling tables. */
+static const unsigned char table[64] = {
+  9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+  0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45,
+  48, 51, 54, 57, 60, 63, 66, 69, 72, 75, 78, 81, 84, 87, 90, 93,
+  96, 99, 102, 105, 108, 111, 114, 117, 120, 123, 126, 129, 132, 135, 138, 141
+};
+
+int main() {
+  unsigned i;
+  klee_make_symbolic(&i, sizeof(i), "i");
+  if (i >= 64)
+    return 0;
+
+  unsigned char v = table[i];
+  if (v == 9) {
+    assert(i < 16 || i == 19);
+    // CHECK-DAG: nine
+    printf("nine\n");
+  } else if (v > 100) {
+    assert(i > 49);
+    // CHECK-DAG: high
+    printf("high\n");
+  } else {
+    assert(i >= 16);
+    // CHECK-DAG: low
+    printf("low\n");
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --target=DirectedSearch.c:16 %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log -check-prefix=CHECK-LOG %s
+// RUN: FileCheck -input-file=%t.klee-out/info %s
+// RUN: /bin/sh -c "ktest-tool --write-int %t.klee-out/*.ktest" | sort > %t.data-values
+// RUN: FileCheck -input-file=%t.data-values -check-prefix=CHECK-KTEST %s
+// RUN: rm -rf %t.klee-out-bad
+// RUN: not %klee --output-dir=%t.klee-out-bad --target=DirectedSearch.c:1 %t.bc 2>&1 | FileCheck -check-prefix=CHECK-BAD %s
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+
+static void hit(int y) {
+  printf("reached %d\n", y);
+}
+
+int main() {
+  int x, y;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  klee_make_symbolic(&y, sizeof(y), "y");
+
+  if (x > 10) {
+    // Once the first state has been through the target it can never get
+    // there again, but it must still run to the end and get a test case.
+    if (y == 42)
+      hit(42);
+    else if (y == 7)
+      hit(7);
+  } else if (x < 0) {
+    printf("negative\n");
+  }
+  return 0;
+}
+
+// CHECK-LOG-DAG: reached 42
+// CHECK-LOG-DAG: reached 7
+// CHECK-LOG-NOT: negative
+
+// CHECK: KLEE: done: states unable to reach the target = 2
+
+// Both states which reached the target have a test case.
+// CHECK-KTEST: object 1: data: 42
+// CHECK-KTEST: object 1: data: 7
+
+// CHECK-BAD: no instructions found for --target
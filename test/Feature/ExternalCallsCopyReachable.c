@@ -0,0 +1,33 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls-copy-reachable %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: not ls %t.klee-out/*.err
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+struct msg {
+  char *text;
+  unsigned len;
+};
+
+char unrelated[4096];
+
+int main() {
+  char src[8] = "hello", dst[8];
+  struct msg m = { dst, sizeof(dst) };
+  struct msg *pm = &m;
+
+  unrelated[0] = 'x';
+
+  // Only the source and destination are copied to and from native memory.
+  strcpy(pm->text, src);
+  assert(!strcmp(dst, "hello"));
+  assert(unrelated[0] == 'x');
+
+  // CHECK: copied hello
+  printf("copied %s\n", dst);
+  return 0;
+}
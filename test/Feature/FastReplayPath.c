@@ -0,0 +1,62 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --write-paths --write-sym-paths %t.bc > %t1.log
+// RUN: sort %t1.log > %t1.sorted
+
+// Replaying every path regenerates every test without a feasibility check.
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --fast-replay-path --write-sym-paths --replay-path %t.klee-out/test000001.path --replay-path %t.klee-out/test000002.path --replay-path %t.klee-out/test000003.path --replay-path %t.klee-out/test000004.path --replay-path %t.klee-out/test000005.path --replay-path %t.klee-out/test000006.path --replay-path %t.klee-out/test000007.path --replay-path %t.klee-out/test000008.path %t.bc > %t2.log
+// RUN: sort %t2.log > %t2.sorted
+// RUN: diff %t1.sorted %t2.sorted
+// RUN: ls %t.klee-out-2 | grep -c ktest | grep 8
+// RUN: grep -q "branches replayed without the solver" %t.klee-out-2/info
+// RUN: cat %t.klee-out/*.sym.path | sort > %t1.sym
+// RUN: cat %t.klee-out-2/*.sym.path | sort > %t2.sym
+// RUN: diff %t1.sym %t2.sym
+
+// Each replayed path is a run of its own: the second one still gets an
+// array cache for its symbolic-index read, and a test case for the error
+// the first one also hit.
+// RUN: %llvmgcc %s -emit-llvm -O0 -DINDEX -c -o %t-index.bc
+// RUN: rm -rf %t.klee-out-3
+// RUN: %klee --output-dir=%t.klee-out-3 --emit-all-errors --write-paths %t-index.bc > /dev/null 2>&1
+// RUN: ls %t.klee-out-3 | grep -c assert.err | grep 2
+// RUN: rm -rf %t.klee-out-4
+// RUN: %klee --output-dir=%t.klee-out-4 --fast-replay-path --replay-path %t.klee-out-3/test000001.path --replay-path %t.klee-out-3/test000002.path %t-index.bc > /dev/null 2>&1
+// RUN: ls %t.klee-out-4 | grep -c assert.err | grep 2
+
+#include <assert.h>
+#include <stdio.h>
+
+#ifdef INDEX
+int main() {
+  static const unsigned char tab[4] = { 1, 2, 3, 4 };
+  int x, v;
+
+  klee_make_symbolic(&x, sizeof x, "x");
+
+  if (x & 1)
+    v = tab[(x >> 1) & 3];
+  else
+    v = tab[(x >> 2) & 3];
+
+  // Both paths fail the same assertion.
+  assert(v == 0);
+  return 0;
+}
+#else
+int main() {
+  int res = 1;
+  int x;
+
+  klee_make_symbolic(&x, sizeof x, "x");
+
+  if (x&1) res *= 2;
+  if (x&2) res *= 3;
+  if (x&4) res *= 5;
+
+  printf("res: %d\n", res);
+
+  return 0;
+}
+#endif
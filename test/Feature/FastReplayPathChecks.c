@@ -0,0 +1,38 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --write-paths %t.bc
+// RUN: ls %t.klee-out | grep -c ptr.err | grep 1
+
+// The paths of both tests past the branch end at the access, so replaying
+// them checks the access rather than assuming it is in bounds.
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --fast-replay-path --emit-all-errors --replay-path %t.klee-out/test000001.path --replay-path %t.klee-out/test000002.path --replay-path %t.klee-out/test000003.path %t.bc
+// RUN: ls %t.klee-out-2 | grep -c ptr.err | grep 2
+
+// A path taking both branches cannot hold, which is found out before the
+// external call rather than by a query which needs a solution.
+// RUN: printf "1\n1\n" > %t.path
+// RUN: rm -rf %t.klee-out-3
+// RUN: %klee --output-dir=%t.klee-out-3 --fast-replay-path --replay-path %t.path %t.bc > %t3.log 2>&1
+// RUN: FileCheck -input-file=%t3.log %s
+
+#include <stdio.h>
+
+int main() {
+  int a[4] = { 0 };
+  unsigned i;
+
+  klee_make_symbolic(&i, sizeof i, "i");
+
+  if (i > 1) {
+    if (i < 1)
+      printf("unreachable\n");
+    a[i] = 1;
+  }
+
+  return 0;
+}
+
+// CHECK-NOT: unreachable
+// CHECK: unable to get symbolic solution, losing test case
+// CHECK-NOT: unreachable
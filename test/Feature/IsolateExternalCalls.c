@@ -0,0 +1,26 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --isolate-external-calls %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: not ls %t.klee-out/*.err
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --isolate-external-calls --external-calls-copy-reachable %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: not ls %t.klee-out/*.err
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+int main() {
+  char src[8] = "hello", dst[8] = "";
+
+  // The copy is made by the child process and sent back.
+  strcpy(dst, src);
+  assert(!strcmp(dst, "hello"));
+  assert(strlen(dst) == 5);
+
+  // CHECK: copied hello
+  printf("copied %s\n", dst);
+  return 0;
+}
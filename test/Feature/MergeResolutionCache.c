@@ -0,0 +1,29 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-resolution-cache --use-merge --search=dfs %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: ls %t.klee-out/*.ptr.err
+
+#include "klee/klee.h"
+
+int buf[4];
+
+void store(unsigned k) {
+  buf[k] = 1;
+}
+
+int main() {
+  unsigned k = klee_int("k");
+
+  // Only the state with k < 4 shows this access to be in bounds.
+  if (k < 4)
+    store(k);
+
+  klee_merge();
+
+  // After the merge k may be out of bounds again.
+  store(k);
+  return 0;
+}
+
+// CHECK: KLEE: ERROR: {{.*}}memory error: out of bound pointer
@@ -0,0 +1,65 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --native-concrete-calls %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out/info %s
+// RUN: not ls %t.klee-out/*.err
+
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <string.h>
+
+static const unsigned char weights[8] = { 1, 3, 7, 9, 1, 3, 7, 9 };
+static unsigned seed = 17;
+
+unsigned checksum(const unsigned char *buf, unsigned n) {
+  unsigned sum = 0, i;
+  for (i = 0; i < n; ++i)
+    sum += buf[i] * weights[i % 8];
+  return sum;
+}
+
+unsigned mix(unsigned x) {
+  unsigned h = x ^ seed;
+  h = h * 31 + 7;
+  h ^= h >> 3;
+  seed = h;
+  return h / 3;
+}
+
+unsigned fill(void) {
+  unsigned char buf[4];
+  memset(buf, 7, sizeof(buf));
+  return buf[3];
+}
+
+unsigned clear(unsigned n) {
+  unsigned char buf[4] = { 1, 1, 1, 1 };
+  memset(buf, 0, n);
+  return buf[0] + buf[3];
+}
+
+int main() {
+  unsigned char concrete[4] = { 1, 2, 3, 4 };
+
+  // Accesses memory through a pointer, so it is interpreted even though
+  // everything it reaches is concrete.
+  assert(checksum(concrete, 4) == 1 + 6 + 21 + 36);
+
+  // Runs natively, and its update of seed is copied back.
+  assert(mix(5) == 191);
+  assert(seed == 573);
+
+  // A memset whose length fits its buffer runs natively; one whose length
+  // is only known at run time is interpreted.
+  assert(fill() == 7);
+  assert(clear(2) == 1);
+
+  // Reaches symbolic memory, so it is interpreted.
+  klee_make_symbolic(&seed, sizeof(seed), "seed");
+  if (mix(1) == 0)
+    assert(seed < 3);
+  return 0;
+}
+
+// CHECK: KLEE: done: native calls = 2 (bailouts = 1)
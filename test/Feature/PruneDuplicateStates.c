@@ -0,0 +1,32 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --prune-duplicate-states %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out/info %s
+// RUN: rm -rf %t.klee-out-all
+// RUN: %klee --output-dir=%t.klee-out-all %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out-all/info -check-prefix=CHECK-ALL %s
+
+#include "klee/klee.h"
+
+static int noise(void) {
+  int c;
+  klee_make_symbolic(&c, sizeof(c), "c");
+  // Both sides leave the caller in the same state, and c is dead once
+  // this returns.
+  if (c > 5)
+    return 1;
+  return 1;
+}
+
+int main() {
+  int i, sum = 0;
+  for (i = 0; i < 3; ++i)
+    sum += noise();
+  return sum != 3;
+}
+
+// CHECK: KLEE: done: duplicate states pruned = 3
+// CHECK: KLEE: done: generated tests = 1
+
+// CHECK-ALL-NOT: duplicate states pruned
+// CHECK-ALL: KLEE: done: generated tests = 8
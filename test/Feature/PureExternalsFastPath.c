@@ -0,0 +1,27 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --pure-externals-fast-path %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out/info %s
+// RUN: not ls %t.klee-out/*.err
+
+#include <assert.h>
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+
+int main() {
+  char s[8] = "klee", t[8] = "klef";
+
+  assert(sqrt(16.0) == 4.0);
+  assert(pow(2.0, 10.0) == 1024.0);
+  assert(isdigit('7') && !isdigit('x'));
+  assert(toupper('k') == 'K');
+  assert(strlen(s) == 4);
+  assert(strcmp(s, t) < 0 && strcmp(t, s) > 0 && !strcmp(s, s));
+  assert(!strncmp(s, t, 3) && strncmp(s, t, 4) < 0);
+  assert(!memcmp(s, t, 3));
+  assert(strchr(s, 'e') == s + 2 && strchr(s, 'z') == 0);
+  return 0;
+}
+
+// CHECK: KLEE: done: external calls on the fast path = {{[1-9][0-9]*}}
@@ -0,0 +1,28 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --search=dfs --use-qce-merge %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out/info %s
+// RUN: rm -rf %t.klee-out-all
+// RUN: %klee --output-dir=%t.klee-out-all --search=dfs %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.klee-out-all/info -check-prefix=CHECK-ALL %s
+
+#include "klee/klee.h"
+
+int main() {
+  int x, i, n = 0;
+  klee_make_symbolic(&x, sizeof(x), "x");
+
+  // The states only differ in n, which no later branch depends on, so
+  // they are merged at the end of each iteration.
+  for (i = 0; i < 4; ++i)
+    if (x & (1 << i))
+      ++n;
+
+  return n * 2;
+}
+
+// CHECK: KLEE: done: merged states = 4
+// CHECK: KLEE: done: generated tests = 1
+
+// CHECK-ALL-NOT: merged states
+// CHECK-ALL: KLEE: done: generated tests = 16
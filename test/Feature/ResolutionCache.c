@@ -0,0 +1,32 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-resolution-cache %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: FileCheck -check-prefix=CHECK-INFO -input-file=%t.klee-out/info %s
+// RUN: ls %t.klee-out/*.ptr.err
+
+#include "klee/klee.h"
+
+#include <stdlib.h>
+
+int main() {
+  int *a = malloc(16 * sizeof(int));
+  unsigned k = klee_range(0, 16, "k");
+  int i, sum = 0;
+
+  // The same symbolic address is accessed on every iteration.
+  for (i = 0; i < 8; i++) {
+    a[k] = i;
+    sum += a[k];
+  }
+
+  // Once the object is freed, the cached resolution must not be used.
+  free(a);
+  for (i = 0; i < 2; i++)
+    sum += a[k];
+
+  return sum;
+}
+
+// CHECK: KLEE: ERROR: {{.*}}memory error
+// CHECK-INFO: KLEE: done: resolution cache hits = {{[1-9][0-9]*}}
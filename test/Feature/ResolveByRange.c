@@ -0,0 +1,48 @@
+// RUN: %llvmgcc -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --resolve-by-range %t.bc > %t.log 2>&1
+// RUN: FileCheck -input-file=%t.log %s
+// RUN: FileCheck -check-prefix=CHECK-INFO -input-file=%t.klee-out/info %s
+// RUN: not ls %t.klee-out/*.err
+
+// When the abstract domain bounds the pointer, only the objects in its range
+// are candidates, which takes fewer queries than walking the neighbours of
+// an example address.
+// RUN: %llvmgcc -emit-llvm -g -c -DPRUNE -o %t2.bc %s
+// RUN: rm -rf %t.klee-out-range %t.klee-out-walk
+// RUN: %klee --output-dir=%t.klee-out-range --use-abstract-domain --resolve-by-range %t2.bc > %t.range.log 2>&1
+// RUN: %klee --output-dir=%t.klee-out-walk --use-abstract-domain %t2.bc > %t.walk.log 2>&1
+// RUN: grep "resolve queries per dereference" %t.klee-out-range/info | sed 's/.*= //' > %t.range
+// RUN: grep "resolve queries per dereference" %t.klee-out-walk/info | sed 's/.*= //' > %t.walk
+// RUN: paste %t.range %t.walk | awk '{ exit !($1 < $2) }'
+
+#include "klee/klee.h"
+
+#include <stdlib.h>
+
+int main() {
+#ifndef PRUNE
+  int *objects[64];
+  int i;
+
+  for (i = 0; i < 64; i++) {
+    objects[i] = malloc(sizeof(int));
+    *objects[i] = i;
+  }
+
+  // Only four of the objects can be read, the rest should not need to be
+  // checked one by one.
+  unsigned s = klee_range(20, 24, "s");
+  return *objects[s] - 20;
+#else
+  char *a = malloc(4), *b = malloc(4), *c = malloc(4);
+  unsigned i = klee_range(0, 6, "i");
+
+  // The access may run off the end of a, which needs a full resolution.
+  a[i] = 1;
+  return b[0] + c[0];
+#endif
+}
+
+// CHECK: KLEE: done: completed paths = 4
+// CHECK-INFO: KLEE: done: avg. resolve queries per dereference = {{[0-9.]+}}
@@ -18,6 +18,13 @@
 // RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --search=random-path --search=nurs:qc %t2.bc
 // RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --weight-refresh-interval=0.01 --search=nurs:md2u %t2.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-bandit-search --bandit-pull-instructions=100 --search=random-path --search=nurs:covnew %t2.bc
+// RUN: awk -F, 'NR == 1 { for (i = 1; i <= NF; ++i) col[$i] = i } END { exit !($col["\047Strategy0Pulls\047"] > 0 && $col["\047Strategy1Pulls\047"] > 0) }' %t.klee-out/run.stats
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-bandit-search --bandit-policy=exp3 --bandit-pull-instructions=100 --search=dfs --search=random-state %t2.bc
+// RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --use-merge --search=dfs --debug-log-merge --debug-log-state-merge %t2.bc
 // RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --use-merge --use-batching-search --search=dfs %t2.bc
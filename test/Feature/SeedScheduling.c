@@ -0,0 +1,47 @@
+// RUN: %llvmgcc -emit-llvm -c -g -DMAKE_SEED %s -o %t-seed.bc
+// RUN: rm -rf %t.klee-out-seed
+// RUN: %klee --output-dir=%t.klee-out-seed %t-seed.bc > /dev/null 2>&1
+// RUN: %llvmgcc -emit-llvm -c -g %s -o %t.bc
+
+// Without a share for unseeded states the seeded state runs its long path
+// to the end before the state it forked off gets to run.
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --seed-out=%t.klee-out-seed/test000001.ktest %t.bc > %t1.log
+// RUN: FileCheck -check-prefix=CHECK-SEEDED -input-file=%t1.log %s
+// CHECK-SEEDED: long
+// CHECK-SEEDED: short
+
+// With a share the unseeded state runs alongside it, and finishes first.
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --seed-unseeded-share=0.5 --seed-out=%t.klee-out-seed/test000001.ktest %t.bc > %t2.log
+// RUN: FileCheck -check-prefix=CHECK-SHARE -input-file=%t2.log %s
+// CHECK-SHARE: short
+// CHECK-SHARE: long
+
+// RUN: rm -rf %t.klee-out-3
+// RUN: not %klee --output-dir=%t.klee-out-3 --seed-unseeded-share=1 %t.bc 2>&1 | FileCheck -check-prefix=CHECK-RANGE %s
+// CHECK-RANGE: --seed-unseeded-share must be at least 0 and below 1
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+
+int main() {
+  unsigned char a;
+  unsigned i, sum = 0;
+
+  klee_make_symbolic(&a, sizeof a, "a");
+#ifdef MAKE_SEED
+  klee_assume(a <= 10);
+#endif
+
+  if (a > 10) {
+    printf("short\n");
+    return 0;
+  }
+
+  for (i = 0; i < 1000; ++i)
+    sum += i;
+  printf("long\n");
+  return sum == 499500 ? 0 : 1;
+}
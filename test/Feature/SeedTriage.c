@@ -0,0 +1,55 @@
+// RUN: %llvmgcc -emit-llvm -c -g %s -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t.bc > %t1.log
+// RUN: grep -c "done" %t1.log | grep 8
+
+// Only the seed taking every branch covers anything the others do not.
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --seed-triage --only-replay-seeds --seed-out-dir=%t.klee-out %t.bc > %t2.log 2>&1
+// RUN: grep -q "seed triage kept 1 of 8 seeds" %t2.log
+// RUN: ls %t.klee-out-2 | grep -c ktest | grep 1
+// RUN: FileCheck -check-prefix=CHECK-INFO -input-file=%t.klee-out-2/info %s
+
+// The seeding run after triage starts from fresh memory, in which
+// symbolic-index reads still work.
+// RUN: %llvmgcc -emit-llvm -c -g -DINDEX %s -o %t-index.bc
+// RUN: rm -rf %t.klee-out-3
+// RUN: %klee --output-dir=%t.klee-out-3 %t-index.bc > %t3.log
+// RUN: rm -rf %t.klee-out-4
+// RUN: %klee --output-dir=%t.klee-out-4 --seed-triage --only-replay-seeds --seed-out-dir=%t.klee-out-3 %t-index.bc > %t4.log 2>&1
+// RUN: grep -q "seed triage kept 1 of 8 seeds" %t4.log
+// RUN: ls %t.klee-out-4 | grep -c ktest | grep 1
+
+// Seeds which the seeding run would extend are not triaged on a prefix.
+// RUN: rm -rf %t.klee-out-5
+// RUN: %klee --output-dir=%t.klee-out-5 --seed-triage --allow-seed-extension --only-replay-seeds --seed-out-dir=%t.klee-out %t.bc 2>&1 | FileCheck -check-prefix=CHECK-EXT %s
+// CHECK-EXT: --seed-triage is ignored
+// CHECK-EXT-NOT: seed triage kept
+
+#include <stdio.h>
+
+int main() {
+  unsigned char a, b, c;
+  int n = 0;
+
+  klee_make_symbolic(&a, sizeof a, "a");
+  klee_make_symbolic(&b, sizeof b, "b");
+  klee_make_symbolic(&c, sizeof c, "c");
+
+  if (a > 10) n += 1;
+  if (b > 20) n += 2;
+  if (c > 30) n += 4;
+
+#ifdef INDEX
+  {
+    static const unsigned char digits[8] = "01234567";
+    printf("done %d %c\n", n, digits[a & 7]);
+  }
+#else
+  printf("done %d\n", n);
+#endif
+  return 0;
+}
+
+// Triage replays are not counted as explored paths.
+// CHECK-INFO: KLEE: done: completed paths = 1{{$}}
@@ -21,6 +21,7 @@
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/Support/PrintVersion.h"
 #include "klee/Internal/Support/ErrorHandling.h"
+#include "klee/util/ExprRewriter.h"
 
 #if LLVM_VERSION_CODE > LLVM_VERSION(3, 2)
 #include "llvm/IR/Constants.h"
@@ -188,9 +189,9 @@ namespace {
                    cl::desc("Specify a directory to replay ktest files from"),
                    cl::value_desc("output directory"));
 
-  cl::opt<std::string>
+  cl::list<std::string>
   ReplayPathFile("replay-path",
-                 cl::desc("Specify a path file to replay"),
+                 cl::desc("Specify a path file to replay (may be given more than once)"),
                  cl::value_desc("path file"));
 
   cl::list<std::string>
@@ -246,7 +247,7 @@ public:
   ~KleeHandler();
 
   llvm::raw_ostream &getInfoStream() const { return *m_infoFile; }
-  unsigned getNumTestCases() { return m_testIndex; }
+  unsigned getNumTestCases() const { return m_testIndex; }
   unsigned getNumPathsExplored() { return m_pathsExplored; }
   void incPathsExplored() { m_pathsExplored++; }
 
@@ -554,9 +555,8 @@ void KleeHandler::loadPathFile(std::string name,
   if (!f.good())
     assert(0 && "unable to open path file");
 
-  while (f.good()) {
-    unsigned value;
-    f >> value;
+  unsigned value;
+  while (f >> value) {
     buffer.push_back(!!value);
     f.get();
   }
@@ -1375,8 +1375,8 @@ int main(int argc, char **argv, char **envp) {
 
   std::vector<bool> replayPath;
 
-  if (ReplayPathFile != "") {
-    KleeHandler::loadPathFile(ReplayPathFile, replayPath);
+  if (ReplayPathFile.size() == 1) {
+    KleeHandler::loadPathFile(ReplayPathFile[0], replayPath);
   }
 
   Interpreter::InterpreterOptions IOpts;
@@ -1395,7 +1395,7 @@ int main(int argc, char **argv, char **envp) {
     interpreter->setModule(mainModule, Opts);
   externalsAndGlobalsCheck(finalModule);
 
-  if (ReplayPathFile != "") {
+  if (ReplayPathFile.size() == 1) {
     interpreter->setReplayPath(&replayPath);
   }
 
@@ -1501,7 +1501,19 @@ int main(int argc, char **argv, char **envp) {
                    str);
       }
     }
-    interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
+    if (ReplayPathFile.size() > 1) {
+      for (unsigned i = 0; i != ReplayPathFile.size() && !interrupted; ++i) {
+        replayPath.clear();
+        KleeHandler::loadPathFile(ReplayPathFile[i], replayPath);
+        interpreter->setReplayPath(&replayPath);
+        llvm::errs() << "KLEE: replaying path: " << ReplayPathFile[i]
+                     << " (" << i+1 << "/" << ReplayPathFile.size() << ")\n";
+        interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
+      }
+      interpreter->setReplayPath(0);
+    } else {
+      interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
+    }
 
     while (!seeds.empty()) {
       kTest_free(seeds.back());
@@ -1538,6 +1550,36 @@ int main(int argc, char **argv, char **envp) {
     *theStatisticManager->getStatisticByName("Instructions");
   uint64_t forks =
     *theStatisticManager->getStatisticByName("Forks");
+  uint64_t resolutions =
+    *theStatisticManager->getStatisticByName("Resolutions");
+  uint64_t resolveQueries =
+    *theStatisticManager->getStatisticByName("ResolveQueries");
+  uint64_t concolicModelHits =
+    *theStatisticManager->getStatisticByName("ConcolicModelHits");
+  uint64_t abstractDomainPrunedQueries =
+    *theStatisticManager->getStatisticByName("AbstractDomainPrunedQueries");
+  uint64_t resolutionCacheHits =
+    *theStatisticManager->getStatisticByName("ResolutionCacheHits");
+  uint64_t segmentedForksAvoided =
+    *theStatisticManager->getStatisticByName("SegmentedForksAvoided");
+  uint64_t externalCallsFastPath =
+    *theStatisticManager->getStatisticByName("ExternalCallsFastPath");
+  uint64_t concreteFastPathInstructions =
+    *theStatisticManager->getStatisticByName("ConcreteFastPathInstructions");
+  uint64_t nativeCalls =
+    *theStatisticManager->getStatisticByName("NativeCalls");
+  uint64_t nativeCallBailouts =
+    *theStatisticManager->getStatisticByName("NativeCallBailouts");
+  uint64_t targetUnreachableStates =
+    *theStatisticManager->getStatisticByName("TargetUnreachableStates");
+  uint64_t duplicateStatesPruned =
+    *theStatisticManager->getStatisticByName("DuplicateStatesPruned");
+  uint64_t mergedStates =
+    *theStatisticManager->getStatisticByName("MergedStates");
+  uint64_t mergeQueriesSaved =
+    *theStatisticManager->getStatisticByName("MergeQueriesSaved");
+  uint64_t replayedBranches =
+    *theStatisticManager->getStatisticByName("ReplayedBranches");
 
   handler->getInfoStream()
     << "KLEE: done: explored paths = " << 1 + forks << "\n";
@@ -1553,6 +1595,62 @@ int main(int argc, char **argv, char **envp) {
     << "KLEE: done: valid queries = " << queriesValid << "\n"
     << "KLEE: done: invalid queries = " << queriesInvalid << "\n"
     << "KLEE: done: query cex = " << queryCounterexamples << "\n";
+  if (resolutions)
+    handler->getInfoStream()
+      << "KLEE: done: avg. resolve queries per dereference = "
+      << (double) resolveQueries / resolutions << "\n";
+  if (concolicModelHits)
+    handler->getInfoStream()
+      << "KLEE: done: branches decided by the concolic model = "
+      << concolicModelHits << "\n";
+  if (abstractDomainPrunedQueries)
+    handler->getInfoStream()
+      << "KLEE: done: queries decided by the abstract domain = "
+      << abstractDomainPrunedQueries << "\n";
+  if (resolutionCacheHits)
+    handler->getInfoStream()
+      << "KLEE: done: resolution cache hits = " << resolutionCacheHits
+      << "\n";
+  if (segmentedForksAvoided)
+    handler->getInfoStream()
+      << "KLEE: done: forks avoided by segmented memory = "
+      << segmentedForksAvoided << "\n";
+  if (externalCallsFastPath)
+    handler->getInfoStream()
+      << "KLEE: done: external calls on the fast path = "
+      << externalCallsFastPath << "\n";
+  if (concreteFastPathInstructions)
+    handler->getInfoStream()
+      << "KLEE: done: instructions on the concrete fast path = "
+      << concreteFastPathInstructions << "\n";
+  if (nativeCalls || nativeCallBailouts)
+    handler->getInfoStream()
+      << "KLEE: done: native calls = " << nativeCalls
+      << " (bailouts = " << nativeCallBailouts << ")\n";
+  if (targetUnreachableStates)
+    handler->getInfoStream()
+      << "KLEE: done: states unable to reach the target = "
+      << targetUnreachableStates << "\n";
+  if (duplicateStatesPruned)
+    handler->getInfoStream()
+      << "KLEE: done: duplicate states pruned = "
+      << duplicateStatesPruned << "\n";
+  if (mergedStates)
+    handler->getInfoStream()
+      << "KLEE: done: merged states = " << mergedStates
+      << " (estimated queries saved = " << mergeQueriesSaved << ")\n";
+  if (replayedBranches)
+    handler->getInfoStream()
+      << "KLEE: done: branches replayed without the solver = "
+      << replayedBranches << "\n";
+  for (unsigned i = 0, e = ExprRewriter::getNumRules(); i != e; ++i)
+    if (uint64_t hits = ExprRewriter::getRuleHits(i))
+      handler->getInfoStream()
+        << "KLEE: done: expr rewrite " << ExprRewriter::getRuleName(i)
+        << " = " << hits << "\n";
+  if (uint64_t memoHits = ExprRewriter::getMemoHits())
+    handler->getInfoStream()
+      << "KLEE: done: expr rewrite memo hits = " << memoHits << "\n";
 
   std::stringstream stats;
   stats << "\n";
@@ -0,0 +1,117 @@
+//===-- DiscretePDFTest.cpp -------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Internal/ADT/DiscretePDF.h"
+
+#include <map>
+
+using namespace klee;
+
+namespace {
+
+/// Check that \a pdf holds exactly the weights in \a expected, and that
+/// choose() hands out each item over a range of p proportional to its
+/// weight.
+void checkWeights(DiscretePDF<int> &pdf, const std::map<int, double> &expected) {
+  double total = 0;
+  for (std::map<int, double>::const_iterator it = expected.begin(),
+         ie = expected.end(); it != ie; ++it) {
+    ASSERT_TRUE(pdf.inTree(it->first));
+    EXPECT_EQ(it->second, pdf.getWeight(it->first));
+    total += it->second;
+  }
+  ASSERT_EQ(expected.empty(), pdf.empty());
+  if (expected.empty())
+    return;
+
+  std::map<int, unsigned> hits;
+  const unsigned steps = 10000;
+  for (unsigned i = 0; i != steps; ++i)
+    ++hits[pdf.choose((i + .5) / steps)];
+
+  for (std::map<int, double>::const_iterator it = expected.begin(),
+         ie = expected.end(); it != ie; ++it) {
+    double share = (double) hits[it->first] / steps;
+    EXPECT_NEAR(it->second / total, share, 2. / steps);
+  }
+  for (std::map<int, unsigned>::iterator it = hits.begin(),
+         ie = hits.end(); it != ie; ++it)
+    EXPECT_TRUE(expected.count(it->first));
+}
+
+TEST(DiscretePDFTest, InsertUpdateRemove) {
+  DiscretePDF<int> pdf;
+  std::map<int, double> expected;
+  checkWeights(pdf, expected);
+
+  for (int i = 0; i != 5; ++i) {
+    pdf.insert(i, i + 1);
+    expected[i] = i + 1;
+  }
+  checkWeights(pdf, expected);
+
+  pdf.update(2, 10);
+  expected[2] = 10;
+  pdf.remove(0);
+  expected.erase(0);
+  checkWeights(pdf, expected);
+
+  // Zero weights are never chosen while anything else has weight.
+  pdf.update(4, 0);
+  expected[4] = 0;
+  checkWeights(pdf, expected);
+}
+
+TEST(DiscretePDFTest, GrowAndReuseSlots) {
+  DiscretePDF<int> pdf;
+  std::map<int, double> expected;
+
+  // Grow past the initial capacity a few times.
+  for (int i = 0; i != 100; ++i) {
+    pdf.insert(i, 1 + i % 7);
+    expected[i] = 1 + i % 7;
+  }
+  checkWeights(pdf, expected);
+
+  // Free every other slot and fill the holes with new items, reweighting
+  // the survivors in between as a batch of lazy updates would.
+  for (int i = 0; i < 100; i += 2) {
+    pdf.remove(i);
+    expected.erase(i);
+  }
+  for (int i = 1; i < 100; i += 2) {
+    pdf.update(i, 3);
+    expected[i] = 3;
+  }
+  for (int i = 100; i != 150; ++i) {
+    pdf.insert(i, 5);
+    expected[i] = 5;
+  }
+  checkWeights(pdf, expected);
+
+  for (int i = 1; i < 150; i += 2) {
+    if (i < 100 || expected.count(i)) {
+      pdf.remove(i);
+      expected.erase(i);
+    }
+  }
+  checkWeights(pdf, expected);
+}
+
+TEST(DiscretePDFTest, AllZero) {
+  DiscretePDF<int> pdf;
+  pdf.insert(7, 0);
+  pdf.insert(8, 0);
+  int chosen = pdf.choose(.5);
+  EXPECT_TRUE(chosen == 7 || chosen == 8);
+}
+
+}
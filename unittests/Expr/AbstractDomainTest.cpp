@@ -0,0 +1,155 @@
+//===-- AbstractDomainTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr.h"
+#include "klee/util/AbstractDomain.h"
+#include "klee/util/ArrayCache.h"
+#include "klee/util/Assignment.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> c32(uint64_t value) {
+  return ConstantExpr::create(value & 0xFFFFFFFF, Expr::Int32);
+}
+
+struct DomainFixture {
+  ArrayCache ac;
+  const Array *x, *y;
+  ref<Expr> X, Y, X32, Y32, XS32;
+
+  DomainFixture() {
+    x = ac.CreateArray("x", 1);
+    y = ac.CreateArray("y", 1);
+    X = Expr::createTempRead(x, Expr::Int8);
+    Y = Expr::createTempRead(y, Expr::Int8);
+    X32 = ZExtExpr::create(X, Expr::Int32);
+    Y32 = ZExtExpr::create(Y, Expr::Int32);
+    XS32 = SExtExpr::create(X, Expr::Int32);
+  }
+
+  /// Conditions over x and y, used both as constraints and as queries.
+  void getConditions(std::vector< ref<Expr> > &result) {
+    result.push_back(UltExpr::create(X32, c32(10)));
+    result.push_back(UltExpr::create(X32, c32(20)));
+    result.push_back(UleExpr::create(c32(200), X32));
+    result.push_back(UltExpr::create(c32(250), X32));
+    result.push_back(SltExpr::create(XS32, c32(0)));
+    result.push_back(SltExpr::create(XS32, c32(-100)));
+    result.push_back(SleExpr::create(c32(5), XS32));
+    result.push_back(EqExpr::create(c32(7), X32));
+    result.push_back(EqExpr::create(c32(0), AndExpr::create(X32, c32(1))));
+    result.push_back(EqExpr::create(c32(0x80), AndExpr::create(X32, c32(0xC0))));
+    result.push_back(UltExpr::create(AddExpr::create(c32(-30), X32), c32(10)));
+    result.push_back(UltExpr::create(X32, Y32));
+    result.push_back(EqExpr::create(X, Y));
+    result.push_back(UltExpr::create(AddExpr::create(X32, Y32), c32(100)));
+    result.push_back(UltExpr::create(MulExpr::create(X32, c32(3)), c32(60)));
+    result.push_back(UltExpr::create(LShrExpr::create(X32, c32(4)), c32(2)));
+    result.push_back(UltExpr::create(ConcatExpr::create(Y, X),
+                                     ConstantExpr::create(0x3000, Expr::Int16)));
+  }
+};
+
+bool isTrue(Assignment &a, const ref<Expr> &e) {
+  return a.evaluate(e)->isTrue();
+}
+
+TEST(AbstractDomainTest, Decides) {
+  DomainFixture f;
+  AbstractDomain domain;
+  domain.addConstraint(UltExpr::create(f.X32, c32(10)));
+
+  EXPECT_TRUE(domain.evaluate(UltExpr::create(f.X32, c32(20))).mustBeTrue());
+  EXPECT_TRUE(domain.evaluate(EqExpr::create(c32(42), f.X32)).mustBeFalse());
+  EXPECT_TRUE(domain.evaluate(SltExpr::create(f.XS32, c32(0))).mustBeFalse());
+  EXPECT_FALSE(domain.evaluate(UltExpr::create(f.X32, c32(5))).mustBeTrue());
+  EXPECT_FALSE(domain.evaluate(UltExpr::create(f.X32, c32(5))).mustBeFalse());
+
+  // Bounds checks of the form (k + x) < n.
+  ref<Expr> offset = AddExpr::create(c32(4), f.X32);
+  EXPECT_TRUE(domain.evaluate(UltExpr::create(offset, c32(16))).mustBeTrue());
+
+  // Negated conditions refine too.
+  domain.addConstraint(Expr::createIsZero(UltExpr::create(f.X32, c32(3))));
+  AbstractValue byte = domain.getByte(f.x, 0);
+  EXPECT_EQ(3U, byte.min);
+  EXPECT_EQ(9U, byte.max);
+
+  AbstractDomain other;
+  other.addConstraint(EqExpr::create(c32(40), f.X32));
+  AbstractDomain joined = domain.join(other);
+  EXPECT_EQ(3U, joined.getByte(f.x, 0).min);
+  EXPECT_EQ(40U, joined.getByte(f.x, 0).max);
+  EXPECT_TRUE(joined.getByte(f.y, 0).isTop());
+}
+
+TEST(AbstractDomainTest, Sound) {
+  DomainFixture f;
+  std::vector< ref<Expr> > conditions;
+  f.getConditions(conditions);
+
+  std::vector<Assignment> assignments;
+  for (unsigned xv = 0; xv < 256; ++xv) {
+    for (unsigned yv = 0; yv < 256; yv += 51) {
+      Assignment a;
+      a.bindings[f.x] = std::vector<unsigned char>(1, xv);
+      a.bindings[f.y] = std::vector<unsigned char>(1, yv);
+      assignments.push_back(a);
+    }
+  }
+
+  // Constrain by every pair of conditions, each either way, and check that
+  // every decision made by the domain holds in all satisfying assignments.
+  for (unsigned i = 0; i != conditions.size(); ++i) {
+    for (unsigned j = i; j != conditions.size(); ++j) {
+      for (unsigned polarity = 0; polarity != 4; ++polarity) {
+        ref<Expr> c1 = conditions[i], c2 = conditions[j];
+        if (polarity & 1)
+          c1 = Expr::createIsZero(c1);
+        if (polarity & 2)
+          c2 = Expr::createIsZero(c2);
+
+        AbstractDomain domain;
+        domain.addConstraint(c1);
+        domain.addConstraint(c2);
+
+        std::vector<Assignment*> satisfying;
+        for (unsigned k = 0; k != assignments.size(); ++k)
+          if (isTrue(assignments[k], c1) && isTrue(assignments[k], c2))
+            satisfying.push_back(&assignments[k]);
+
+        for (unsigned k = 0; k != satisfying.size(); ++k) {
+          unsigned char xv = satisfying[k]->bindings[f.x][0];
+          AbstractValue byte = domain.getByte(f.x, 0);
+          ASSERT_TRUE(byte.min <= xv && xv <= byte.max);
+          ASSERT_EQ(0U, xv & byte.knownZero);
+          ASSERT_EQ(byte.knownOne, xv & byte.knownOne);
+        }
+
+        for (unsigned q = 0; q != conditions.size(); ++q) {
+          AbstractValue v = domain.evaluate(conditions[q]);
+          if (!v.mustBeTrue() && !v.mustBeFalse())
+            continue;
+          for (unsigned k = 0; k != satisfying.size(); ++k)
+            ASSERT_EQ(v.mustBeTrue(), isTrue(*satisfying[k], conditions[q]))
+              << "constraint " << i << "/" << j << "/" << polarity
+              << ", query " << q;
+        }
+      }
+    }
+  }
+}
+
+}
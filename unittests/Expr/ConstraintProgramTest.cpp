@@ -0,0 +1,129 @@
+//===-- ConstraintProgramTest.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr.h"
+#include "klee/util/ArrayCache.h"
+#include "klee/util/Assignment.h"
+#include "klee/util/ConstraintProgram.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// Deterministically fill \a n assignments for \a x and \a y with small
+/// values, so that divisions by zero and overshifts are common.
+void makeAssignments(const Array *x, const Array *y, unsigned n,
+                     std::vector<Assignment*> &result) {
+  uint32_t seed = 12345;
+  for (unsigned i = 0; i != n; ++i) {
+    Assignment *a = new Assignment();
+    for (unsigned k = 0; k != 2; ++k) {
+      std::vector<unsigned char> bytes(4);
+      for (unsigned j = 0; j != 4; ++j) {
+        seed = seed * 1103515245 + 12345;
+        unsigned char b = (seed >> 16) & 0xFF;
+        bytes[j] = (j == 0 || (seed & 0x100)) ? b : (b & 0x80 ? 0xFF : 0);
+      }
+      a->bindings[k == 0 ? x : y] = bytes;
+    }
+    result.push_back(a);
+  }
+}
+
+void checkAgainstEvaluator(const std::vector< ref<Expr> > &constraints,
+                           std::vector<Assignment*> &assignments) {
+  ConstraintProgram program(constraints.begin(), constraints.end());
+  std::vector<const Assignment*> batch(assignments.begin(),
+                                      assignments.end());
+  std::vector<bool> batchResult;
+  program.satisfies(batch, batchResult);
+
+  unsigned firstSatisfying = assignments.size();
+  for (unsigned i = 0, e = assignments.size(); i != e; ++i) {
+    bool expected = assignments[i]->satisfies(constraints.begin(),
+                                              constraints.end());
+    EXPECT_EQ(expected, program.satisfies(*assignments[i]));
+    EXPECT_EQ(expected, (bool) batchResult[i]);
+    if (expected && firstSatisfying == e)
+      firstSatisfying = i;
+  }
+  EXPECT_EQ(firstSatisfying, program.findSatisfying(batch));
+}
+
+TEST(ConstraintProgramTest, MatchesAssignment) {
+  ArrayCache ac;
+  const Array *x = ac.CreateArray("x", 4);
+  const Array *y = ac.CreateArray("y", 4);
+  ref<Expr> X = Expr::createTempRead(x, Expr::Int32);
+  ref<Expr> Y = Expr::createTempRead(y, Expr::Int32);
+
+  // A read through an update list with a symbolic index.
+  UpdateList ul(x, 0);
+  ul.extend(ZExtExpr::create(Expr::createTempRead(y, Expr::Int8),
+                             Expr::Int32),
+            ConstantExpr::alloc(7, Expr::Int8));
+  ref<Expr> updated =
+    ReadExpr::create(ul, ConstantExpr::alloc(1, Expr::Int32));
+
+  std::vector< ref<Expr> > constraints;
+  constraints.push_back(SltExpr::create(SDivExpr::create(X, Y),
+                                        ConstantExpr::alloc(5, Expr::Int32)));
+  constraints.push_back(UleExpr::create(
+      LShrExpr::create(X, URemExpr::create(Y, ConstantExpr::alloc(40,
+                                                                  Expr::Int32))),
+      AShrExpr::create(Y, ConstantExpr::alloc(3, Expr::Int32))));
+  constraints.push_back(NeExpr::create(
+      ExtractExpr::create(MulExpr::create(X, Y), 3, Expr::Int8), updated));
+  constraints.push_back(SltExpr::create(
+      SExtExpr::create(Expr::createTempRead(x, Expr::Int8), Expr::Int64),
+      SubExpr::create(ZExtExpr::create(SRemExpr::create(X, Y), Expr::Int64),
+                      ConstantExpr::alloc(100, Expr::Int64))));
+
+  std::vector<Assignment*> assignments;
+  makeAssignments(x, y, 200, assignments);
+
+  // Check each constraint on its own, to exercise both outcomes, and then all
+  // of them together.
+  for (unsigned i = 0; i != constraints.size(); ++i) {
+    std::vector< ref<Expr> > single(1, constraints[i]);
+    checkAgainstEvaluator(single, assignments);
+  }
+  checkAgainstEvaluator(constraints, assignments);
+
+  for (unsigned i = 0; i != assignments.size(); ++i)
+    delete assignments[i];
+}
+
+TEST(ConstraintProgramTest, UnsupportedWidthFallsBack) {
+  ArrayCache ac;
+  const Array *x = ac.CreateArray("x", 4);
+  const Array *y = ac.CreateArray("y", 4);
+  ref<Expr> X = Expr::createTempRead(x, Expr::Int32);
+  ref<Expr> Y = Expr::createTempRead(y, Expr::Int32);
+
+  std::vector< ref<Expr> > constraints;
+  constraints.push_back(UltExpr::create(
+      ZExtExpr::create(X, 128), MulExpr::create(ZExtExpr::create(Y, 128),
+                                                ZExtExpr::create(Y, 128))));
+  ConstraintProgram program(constraints.begin(), constraints.end());
+  EXPECT_FALSE(program.isValid());
+
+  std::vector<Assignment*> assignments;
+  makeAssignments(x, y, 20, assignments);
+  checkAgainstEvaluator(constraints, assignments);
+
+  for (unsigned i = 0; i != assignments.size(); ++i)
+    delete assignments[i];
+}
+
+}
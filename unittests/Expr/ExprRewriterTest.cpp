@@ -0,0 +1,179 @@
+//===-- ExprRewriterTest.cpp ----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr.h"
+#include "klee/util/ArrayCache.h"
+#include "klee/util/Assignment.h"
+#include "klee/util/ExprRewriter.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> c32(uint64_t value) {
+  return ConstantExpr::create(value & 0xFFFFFFFF, Expr::Int32);
+}
+
+uint64_t getHits(const char *name) {
+  for (unsigned i = 0; i != ExprRewriter::getNumRules(); ++i)
+    if (!strcmp(ExprRewriter::getRuleName(i), name))
+      return ExprRewriter::getRuleHits(i);
+  return 0;
+}
+
+struct RewriterFixture {
+  ArrayCache ac;
+  const Array *x, *y;
+  ref<Expr> X, Y, X16, Y16, X32, Y32;
+
+  RewriterFixture() {
+    x = ac.CreateArray("x", 2);
+    y = ac.CreateArray("y", 2);
+    X = Expr::createTempRead(x, Expr::Int8);
+    Y = Expr::createTempRead(y, Expr::Int8);
+    X16 = Expr::createTempRead(x, Expr::Int16);
+    Y16 = Expr::createTempRead(y, Expr::Int16);
+    X32 = ZExtExpr::create(X, Expr::Int32);
+    Y32 = ZExtExpr::create(Y, Expr::Int32);
+  }
+
+  /// Expressions matched by the rules, built without simplification.
+  void getExprs(std::vector< ref<Expr> > &result) {
+    result.push_back(ExtractExpr::alloc(ExtractExpr::alloc(X16, 4, 12), 2, 8));
+    result.push_back(ExtractExpr::alloc(X32, 0, Expr::Int8));
+    result.push_back(ExtractExpr::alloc(X32, 4, Expr::Int8));
+    result.push_back(ExtractExpr::alloc(X32, 8, Expr::Int16));
+    result.push_back(ExtractExpr::alloc(SExtExpr::alloc(X16, 32), 3, 8));
+    result.push_back(ZExtExpr::alloc(ZExtExpr::alloc(X, 16), 32));
+    result.push_back(SExtExpr::alloc(SExtExpr::alloc(X, 16), 32));
+    result.push_back(SExtExpr::alloc(ZExtExpr::alloc(X, 16), 32));
+    result.push_back(NotExpr::alloc(NotExpr::alloc(X)));
+    ref<Expr> cond = UltExpr::create(X, Y);
+    result.push_back(SelectExpr::alloc(cond,
+                                       SelectExpr::alloc(cond, X, Y),
+                                       ConstantExpr::create(3, Expr::Int8)));
+    result.push_back(SelectExpr::alloc(cond, X16,
+                                       SelectExpr::alloc(cond, Y16, X16)));
+    result.push_back(EqExpr::alloc(X32, Y32));
+    result.push_back(UltExpr::alloc(X32, Y32));
+    result.push_back(UleExpr::alloc(X32, Y32));
+    result.push_back(SltExpr::alloc(X32, Y32));
+    result.push_back(SleExpr::alloc(SExtExpr::alloc(X, 32),
+                                    SExtExpr::alloc(Y, 32)));
+    result.push_back(SltExpr::alloc(SExtExpr::alloc(X, 32),
+                                    SExtExpr::alloc(Y, 32)));
+    result.push_back(UltExpr::alloc(X32, c32(100)));
+    result.push_back(UltExpr::alloc(X32, c32(300)));
+    result.push_back(UleExpr::alloc(X32, c32(255)));
+    result.push_back(UltExpr::alloc(c32(255), X32));
+    result.push_back(UleExpr::alloc(c32(17), X32));
+    result.push_back(EqExpr::alloc(ConcatExpr::alloc(X, Y),
+                                   ConcatExpr::alloc(Y, X)));
+    result.push_back(EqExpr::alloc(ConstantExpr::create(0x1234, Expr::Int16),
+                                   ConcatExpr::alloc(Y, X)));
+    result.push_back(MulExpr::alloc(c32(3), MulExpr::alloc(X32, c32(5))));
+    result.push_back(AndExpr::alloc(AndExpr::alloc(c32(0xF0), Y32),
+                                    c32(0x3C)));
+    result.push_back(OrExpr::alloc(c32(1), OrExpr::alloc(c32(6), X32)));
+    result.push_back(XorExpr::alloc(XorExpr::alloc(X32, c32(0xFF)),
+                                    c32(0x0F)));
+    result.push_back(ShlExpr::alloc(ShlExpr::alloc(X32, c32(3)), c32(4)));
+    result.push_back(ShlExpr::alloc(ShlExpr::alloc(X32, c32(20)), c32(12)));
+    result.push_back(LShrExpr::alloc(LShrExpr::alloc(X32, c32(1)), c32(2)));
+  }
+};
+
+/// The rewriter memoizes expressions across tests, so the arrays they read
+/// must outlive all of them.
+RewriterFixture &getFixture() {
+  static RewriterFixture fixture;
+  return fixture;
+}
+
+TEST(ExprRewriterTest, Shapes) {
+  RewriterFixture &f = getFixture();
+
+  uint64_t hits = getHits("ExtractOfZExt");
+  EXPECT_EQ(f.X, ExprRewriter::rewrite(ExtractExpr::alloc(f.X32, 0, 8)));
+  EXPECT_EQ(hits + 1, getHits("ExtractOfZExt"));
+
+  ref<Expr> zz = ExprRewriter::rewrite(ZExtExpr::alloc(ZExtExpr::alloc(f.X, 16),
+                                                       32));
+  EXPECT_EQ(f.X32, zz);
+
+  EXPECT_EQ(f.X, ExprRewriter::rewrite(NotExpr::alloc(NotExpr::alloc(f.X))));
+
+  ref<Expr> cmp = ExprRewriter::rewrite(UltExpr::alloc(f.X32, f.Y32));
+  EXPECT_EQ(UltExpr::create(f.X, f.Y), cmp);
+
+  ref<Expr> alwaysTrue = ExprRewriter::rewrite(UltExpr::alloc(f.X32, c32(256)));
+  EXPECT_TRUE(isa<ConstantExpr>(alwaysTrue));
+  EXPECT_TRUE(cast<ConstantExpr>(alwaysTrue)->isTrue());
+
+  ref<Expr> split =
+    ExprRewriter::rewrite(EqExpr::alloc(ConstantExpr::create(0x1234, Expr::Int16),
+                                        ConcatExpr::alloc(f.Y, f.X)));
+  EXPECT_EQ(Expr::And, split->getKind());
+
+  ref<Expr> masked =
+    ExprRewriter::rewrite(AndExpr::alloc(c32(0xF0),
+                                         AndExpr::alloc(c32(0x3C), f.X32)));
+  ASSERT_EQ(Expr::And, masked->getKind());
+  EXPECT_EQ(c32(0x30), masked->getKid(1));
+
+  // Expressions no rule matches are returned as they are.
+  ref<Expr> add = AddExpr::create(f.X32, f.Y32);
+  EXPECT_EQ(add, ExprRewriter::rewrite(add));
+
+  // Repeated rewrites are answered from the memo cache.
+  uint64_t memoHits = ExprRewriter::getMemoHits();
+  ref<Expr> again = ExprRewriter::rewrite(UltExpr::alloc(f.X32, f.Y32));
+  EXPECT_EQ(cmp, again);
+  EXPECT_EQ(memoHits + 1, ExprRewriter::getMemoHits());
+}
+
+TEST(ExprRewriterTest, Equivalent) {
+  RewriterFixture &f = getFixture();
+  std::vector< ref<Expr> > exprs;
+  f.getExprs(exprs);
+
+  std::vector< ref<Expr> > rewritten;
+  for (unsigned i = 0; i != exprs.size(); ++i) {
+    rewritten.push_back(ExprRewriter::rewrite(exprs[i]));
+    EXPECT_NE(exprs[i], rewritten[i]) << "expression " << i;
+  }
+
+  // Every rule should have been exercised by now.
+  for (unsigned i = 0; i != ExprRewriter::getNumRules(); ++i)
+    EXPECT_LT(0U, ExprRewriter::getRuleHits(i))
+      << ExprRewriter::getRuleName(i);
+
+  srand(0);
+  for (unsigned n = 0; n != 1000; ++n) {
+    Assignment a;
+    std::vector<unsigned char> xv(2), yv(2);
+    for (unsigned k = 0; k != 2; ++k) {
+      xv[k] = rand() & 0xFF;
+      yv[k] = rand() & 0xFF;
+    }
+    a.bindings[f.x] = xv;
+    a.bindings[f.y] = yv;
+    for (unsigned i = 0; i != exprs.size(); ++i)
+      ASSERT_EQ(a.evaluate(exprs[i]), a.evaluate(rewritten[i]))
+        << "expression " << i;
+  }
+}
+
+}
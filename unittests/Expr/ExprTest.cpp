@@ -113,4 +113,30 @@ TEST(ExprTest, ExtractConcat) {
   EXPECT_EQ(Expr::Extract, concat2->getKid(1)->getKind());
 }
 
+
+TEST(ExprTest, ConstantArrayPieces) {
+  ArrayCache ac;
+  std::vector<ref<ConstantExpr> > values;
+  for (unsigned i = 0; i != 300; ++i)
+    values.push_back(ConstantExpr::create(i < 100 ? 7 : (3 * i + 1) & 0xFF, 8));
+  values.push_back(ConstantExpr::create(42, 8));
+  const Array *table = ac.CreateArray("table", values.size(), &values[0],
+                                      &values[0] + values.size());
+
+  const std::vector<Array::Piece> *pieces = table->getPieces(8);
+  ASSERT_TRUE(pieces != 0);
+  ASSERT_EQ(3U, pieces->size());
+  EXPECT_EQ(0U, (*pieces)[0].start);
+  EXPECT_EQ(100U, (*pieces)[0].end);
+  EXPECT_EQ(7U, (*pieces)[0].base);
+  EXPECT_EQ(0U, (*pieces)[0].step);
+  EXPECT_EQ(300U, (*pieces)[1].end);
+  EXPECT_EQ((3 * 100 + 1) & 0xFFU, (*pieces)[1].base);
+  EXPECT_EQ(3U, (*pieces)[1].step);
+  EXPECT_EQ(42U, (*pieces)[2].base);
+
+  EXPECT_TRUE(table->getPieces(2) == 0);
+  EXPECT_TRUE(table->getPieces(3) != 0);
+}
+
 }
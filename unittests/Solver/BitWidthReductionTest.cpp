@@ -0,0 +1,264 @@
+//===-- BitWidthReductionTest.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/Solver.h"
+#include "klee/SolverImpl.h"
+#include "klee/util/ArrayCache.h"
+#include "klee/util/Assignment.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// A solver which records the queries which reach it, and answers them by
+/// trying every value of a set of small arrays.
+class EnumeratingSolver : public SolverImpl {
+public:
+  std::vector<const Array*> arrays;
+  std::vector< ref<Expr> > constraints;
+  ref<Expr> expr;
+
+  EnumeratingSolver(const std::vector<const Array*> &_arrays)
+    : arrays(_arrays) {}
+
+  /// Call \a f on each assignment satisfying the recorded constraints, until
+  /// it returns false.
+  template<class F>
+  void forEachModel(F &f) {
+    unsigned numBytes = 0;
+    for (unsigned i = 0; i != arrays.size(); ++i)
+      numBytes += arrays[i]->size;
+    assert(numBytes <= 2 && "too many bytes to enumerate");
+
+    for (unsigned value = 0; value != (1U << (8 * numBytes)); ++value) {
+      Assignment a;
+      unsigned shift = 0;
+      for (unsigned i = 0; i != arrays.size(); ++i) {
+        std::vector<unsigned char> &bytes = a.bindings[arrays[i]];
+        for (unsigned j = 0; j != arrays[i]->size; ++j, shift += 8)
+          bytes.push_back(value >> shift);
+      }
+      if (a.satisfies(constraints.begin(), constraints.end()) && !f(a))
+        return;
+    }
+  }
+
+  void record(const Query &query) {
+    constraints.assign(query.constraints.begin(), query.constraints.end());
+    expr = query.expr;
+  }
+
+  struct AllTrue {
+    ref<Expr> expr;
+    bool result;
+    bool operator()(Assignment &a) {
+      result = a.evaluate(expr)->isTrue();
+      return result;
+    }
+  };
+
+  bool computeTruth(const Query &query, bool &isValid) {
+    record(query);
+    AllTrue f;
+    f.expr = query.expr;
+    f.result = true;
+    forEachModel(f);
+    isValid = f.result;
+    return true;
+  }
+
+  struct FirstValue {
+    ref<Expr> expr, value;
+    bool operator()(Assignment &a) {
+      value = a.evaluate(expr);
+      return false;
+    }
+  };
+
+  bool computeValue(const Query &query, ref<Expr> &result) {
+    record(query);
+    FirstValue f;
+    f.expr = query.expr;
+    forEachModel(f);
+    result = f.value;
+    return !result.isNull();
+  }
+
+  struct FirstModel {
+    ref<Expr> expr;
+    const std::vector<const Array*> *objects;
+    std::vector< std::vector<unsigned char> > *values;
+    bool found;
+    bool operator()(Assignment &a) {
+      if (a.evaluate(expr)->isTrue())
+        return true;
+      for (unsigned i = 0; i != objects->size(); ++i)
+        values->push_back(a.bindings[(*objects)[i]]);
+      found = true;
+      return false;
+    }
+  };
+
+  bool computeInitialValues(const Query &query,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution) {
+    record(query);
+    FirstModel f;
+    f.expr = query.expr;
+    f.objects = &objects;
+    f.values = &values;
+    f.found = false;
+    forEachModel(f);
+    hasSolution = f.found;
+    return true;
+  }
+
+  SolverRunStatus getOperationStatusCode() {
+    return SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  }
+};
+
+ref<Expr> c32(uint64_t value) {
+  return ConstantExpr::create(value & 0xFFFFFFFF, Expr::Int32);
+}
+
+/// Return the widest operand width of any comparison in \a e.
+unsigned getMaxCompareWidth(const ref<Expr> &e) {
+  unsigned result = 0;
+  if (isa<CmpExpr>(e))
+    result = e->getKid(0)->getWidth();
+  for (unsigned i = 0; i != e->getNumKids(); ++i)
+    if (e->getKid(i)->getWidth() == Expr::Bool)
+      result = std::max(result, getMaxCompareWidth(e->getKid(i)));
+  return result;
+}
+
+TEST(BitWidthReductionTest, Narrows) {
+  ArrayCache ac;
+  const Array *x = ac.CreateArray("x", 1), *y = ac.CreateArray("y", 1);
+  ref<Expr> X = Expr::createTempRead(x, Expr::Int8);
+  ref<Expr> Y = Expr::createTempRead(y, Expr::Int8);
+  ref<Expr> X32 = ZExtExpr::create(X, Expr::Int32);
+  ref<Expr> Y32 = ZExtExpr::create(Y, Expr::Int32);
+  ref<Expr> XS32 = SExtExpr::create(X, Expr::Int32);
+  ref<Expr> YS32 = SExtExpr::create(Y, Expr::Int32);
+
+  std::vector< ref<Expr> > queries;
+  queries.push_back(UltExpr::create(X32, Y32));
+  queries.push_back(UltExpr::create(AddExpr::create(X32, Y32), c32(300)));
+  queries.push_back(SltExpr::create(XS32, YS32));
+  queries.push_back(SleExpr::create(AddExpr::create(XS32, YS32), c32(-7)));
+  queries.push_back(EqExpr::create(c32(0x2A), MulExpr::create(X32, c32(3))));
+  queries.push_back(SltExpr::create(SubExpr::create(X32, Y32), c32(100)));
+  queries.push_back(UltExpr::create(LShrExpr::create(X32, c32(2)), c32(17)));
+  queries.push_back(EqExpr::create(c32(0x12),
+                                   AndExpr::create(AddExpr::create(X32, Y32),
+                                                   c32(0xFF))));
+  queries.push_back(UltExpr::create(AndExpr::create(XS32, c32(0xF00)),
+                                    c32(0x300)));
+  queries.push_back(UleExpr::create(ShlExpr::create(X32, c32(3)),
+                                    ZExtExpr::create(ConcatExpr::create(Y, Y),
+                                                     Expr::Int32)));
+
+  std::vector<const Array*> arrays;
+  arrays.push_back(x);
+  arrays.push_back(y);
+  EnumeratingSolver *enumerator = new EnumeratingSolver(arrays);
+  Solver *solver = createBitWidthReductionSolver(new Solver(enumerator));
+  ConstraintManager constraints;
+
+  for (unsigned i = 0; i != queries.size(); ++i) {
+    bool result;
+    ASSERT_TRUE(solver->mustBeTrue(Query(constraints, queries[i]), result));
+    ref<Expr> reduced = enumerator->expr;
+    EXPECT_GT(getMaxCompareWidth(queries[i]), getMaxCompareWidth(reduced))
+      << "query " << i;
+
+    for (unsigned xv = 0; xv != 256; ++xv) {
+      for (unsigned yv = 0; yv < 256; yv += 5) {
+        Assignment a;
+        a.bindings[x] = std::vector<unsigned char>(1, xv);
+        a.bindings[y] = std::vector<unsigned char>(1, yv);
+        ASSERT_EQ(a.evaluate(queries[i]), a.evaluate(reduced))
+          << "query " << i << " x=" << xv << " y=" << yv;
+      }
+    }
+  }
+
+  // Models of the reduced query satisfy the original constraints.
+  constraints.addConstraint(queries[1]);
+  constraints.addConstraint(queries[3]);
+  std::vector< std::vector<unsigned char> > values;
+  ASSERT_TRUE(solver->getInitialValues(Query(constraints, queries[0]), arrays,
+                                       values));
+  Assignment model(arrays, values);
+  EXPECT_TRUE(model.satisfies(constraints.begin(), constraints.end()));
+  EXPECT_FALSE(model.evaluate(queries[0])->isTrue());
+  ASSERT_FALSE(enumerator->constraints.empty());
+  EXPECT_GT(32U, getMaxCompareWidth(enumerator->constraints[0]));
+
+  // Values are only asked for in the bits they can have set.
+  ref<ConstantExpr> value;
+  ASSERT_TRUE(solver->getValue(Query(constraints, AddExpr::create(X32, Y32)),
+                               value));
+  EXPECT_EQ(32U, value->getWidth());
+  EXPECT_EQ(9U, enumerator->expr->getWidth());
+
+  delete solver;
+}
+
+TEST(BitWidthReductionTest, DivisionByZero) {
+  ArrayCache ac;
+  const Array *x = ac.CreateArray("x", 1), *y = ac.CreateArray("y", 1);
+  ref<Expr> X32 = ZExtExpr::create(Expr::createTempRead(x, Expr::Int8),
+                                   Expr::Int32);
+  ref<Expr> Y32 = ZExtExpr::create(Expr::createTempRead(y, Expr::Int8),
+                                   Expr::Int32);
+  ref<Expr> X12 = ShlExpr::create(X32, c32(4));
+
+  std::vector<const Array*> arrays;
+  arrays.push_back(x);
+  arrays.push_back(y);
+  EnumeratingSolver *enumerator = new EnumeratingSolver(arrays);
+  Solver *solver = createBitWidthReductionSolver(new Solver(enumerator));
+  // The enumerator cannot evaluate a division by zero, but the reduction
+  // does not look at the constraints.
+  ConstraintManager constraints;
+  constraints.addConstraint(Expr::createIsZero(EqExpr::create(Y32, c32(0))));
+
+  // x urem 0 is x, so the remainder of a 12-bit value by a divisor which
+  // may be zero needs all 12 bits.
+  bool result;
+  enumerator->expr = 0;
+  ASSERT_TRUE(solver->mustBeTrue(
+      Query(constraints, EqExpr::create(c32(0x123), URemExpr::create(X12, Y32))),
+      result));
+  ASSERT_FALSE(enumerator->expr.isNull());
+  EXPECT_LE(12U, getMaxCompareWidth(enumerator->expr));
+
+  // A nonzero constant divisor bounds the remainder.
+  enumerator->expr = 0;
+  ASSERT_TRUE(solver->mustBeTrue(
+      Query(constraints, EqExpr::create(c32(7), URemExpr::create(X12, c32(10)))),
+      result));
+  ASSERT_FALSE(enumerator->expr.isNull());
+  EXPECT_GT(12U, getMaxCompareWidth(enumerator->expr));
+
+  delete solver;
+}
+
+}